@@ -12,5 +12,6 @@ fn main() {
 
     println!("cargo:rustc-link-search=native={}", out_dir);
     println!("cargo:rustc-link-lib=static=concorde");
+    println!("cargo:rustc-link-lib=pthread");
     println!("cargo:rerun-if-changed=src/concorde/*");
 }
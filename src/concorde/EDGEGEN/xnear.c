@@ -75,9 +75,15 @@
 /*                                                                          */
 /*  int CCedgegen_junk_k_nearest (int ncount, int k, CCdatagroup *dat,      */
 /*      double *wcoord, int wantlist, int *ecount, int **elist,             */
-/*      int silent)                                                         */
+/*      int nthreads, int silent)                                           */
 /*    RETURNS the k-nearest graph (for JUNK-Norms)                          */
 /*      -see CCedgegen_x_k_nearest (above) for the variables                */
+/*      -nthreads is the number of threads to use, or 0 to pick it from     */
+/*       ncount and the processors online                                   */
+/*    With CC_POSIXTHREADS the node scans are split across threads; the     */
+/*    edges come out in the same order for any number of threads.           */
+/*    An unweighted CC_MATRIXNORM runs a tiled kernel over the triangle     */
+/*    instead of one scan per node (ties go to the smaller end).            */
 /*                                                                          */
 /*  int CCedgegen_junk_node_k_nearest (CCdatagroup *dat, double *wcoord,    */
 /*      int n, int k, int ncount, int *list)                                */
@@ -137,6 +143,10 @@
 
 #define BIGDOUBLE (1e30)
 #define NEAR_HEAP_CUTOFF 100 /* When to switch from list to heap       */
+#define JUNK_THREAD_NODES 1000 /* Fewest nodes per junk-norm scan thread */
+#define JUNK_MAX_THREADS 64
+#define MATRIX_TILE 2048 /* Columns per tile: their top lists stay in cache */
+#define MATRIX_CHUNK 16  /* Distances filtered per compare block          */
 
 #define dtrunc(x) (((x) > 0.0) ? floor(x) : ceil(x))
 
@@ -155,15 +165,60 @@ typedef struct tabledat {
     CCptrworld intptr_world;
 } tabledat;
 
+/* One worker's share of the junk-norm scans: the nodes lo..hi-1 */
+typedef struct junkwork {
+    CCdatagroup *dat;
+    double *wcoord;
+    int ncount;
+    int num;
+    int lo, hi;
+    int *lists; /* num neighbors per node, shared by all workers */
+    int ecount; /* edges kept from lo..hi-1 */
+    int *elist; /* where those edges go, filled in the second pass */
+    int rval;
+} junkwork;
+
+/* One worker of the CC_MATRIXNORM kernel. It owns the column tiles     */
+/* blo..bhi-1 and keeps a top list (distance, end) for every node from  */
+/* the entries in those tiles; the lists of the workers are then merged */
+/* for the nodes lo..hi-1.                                              */
+typedef struct matwork {
+    CCdatagroup *dat;
+    int ncount;
+    int num;
+    int blo, bhi;
+    int lo, hi;
+    int *dist;   /* num per node, ascending by (distance, end) */
+    int *end;
+    int *thresh; /* dist[v * num + num - 1]: what v's list accepts */
+    struct matwork *all;
+    int nall;
+    int *lists;
+    int rval;
+} matwork;
+
 static void add_to_list_and_reset(int *list, int *lcount, shortedge *nearlist,
                                   int nearnum, int *nodenames),
     insert(int n, int m, shortedge *nearlist, CCdatagroup *dat, double *wcoord),
     x_quicksort(int *list, double *x, int l, int u);
 static int run_x_k_nearest(int ncount, int num, CCdatagroup *dat,
                            double *wcoord, int wantlist, int *ecount,
-                           int **elist, int doquad, int silent),
+                           int **elist, int doquad, int nthreads, int silent),
+    junk_k_nearest(int ncount, int num, CCdatagroup *dat, double *wcoord,
+                   int wantlist, int *ecount, int **elist, int nthreads,
+                   int silent),
+    junk_scan(CCdatagroup *dat, double *wcoord, int n, int nearnum,
+              int ncount, shortedge *nearlist, int *list),
+    junk_threads(int ncount),
+    matrix_lists(int ncount, int num, CCdatagroup *dat, int *lists,
+                 int nworkers),
     put_in_table(tabledat *td, int i, int j, int *added);
 
+static void matrix_row(matwork *w, int i, int j0, const int *row, int len),
+    top_insert(matwork *w, int v, int d, int e),
+    *junk_lists_work(void *arg), *junk_edges_work(void *arg),
+    *matrix_tiles_work(void *arg), *matrix_merge_work(void *arg);
+
 CC_PTRWORLD_LIST_ROUTINES(intptr, int, intptralloc, intptr_bulk_alloc,
                           intptrfree, intptr_listadd, intptr_listfree)
 CC_PTRWORLD_LEAKS_ROUTINE(intptr, intptr_check_leaks, this, int)
@@ -171,26 +226,28 @@ CC_PTRWORLD_LEAKS_ROUTINE(intptr, intptr_check_leaks, this, int)
 int CCedgegen_x_k_nearest(int ncount, int num, CCdatagroup *dat, double *wcoord,
                           int wantlist, int *ecount, int **elist, int silent) {
     return run_x_k_nearest(ncount, num, dat, wcoord, wantlist, ecount, elist, 0,
-                           silent);
+                           0, silent);
 }
 
 int CCedgegen_x_quadrant_k_nearest(int ncount, int num, CCdatagroup *dat,
                                    double *wcoord, int wantlist, int *ecount,
                                    int **elist, int silent) {
     return run_x_k_nearest(ncount, num, dat, wcoord, wantlist, ecount, elist, 1,
-                           silent);
+                           0, silent);
 }
 
 int CCedgegen_junk_k_nearest(int ncount, int num, CCdatagroup *dat,
                              double *wcoord, int wantlist, int *ecount,
-                             int **elist, int silent) {
+                             int **elist, int nthreads, int silent) {
     return run_x_k_nearest(ncount, num, dat, wcoord, wantlist, ecount, elist, 0,
-                           silent);
+                           nthreads, silent);
 }
 
+/* nthreads only matters to the junk-norm code */
 static int run_x_k_nearest(int ncount, int num, CCdatagroup *dat,
                            double *wcoord, int wantlist, int *ecount,
-                           int **elist, int doquad, int silent) {
+                           int **elist, int doquad, int nthreads,
+                           int silent) {
     int rval = 0;
     int i, n;
     intptr *ip, *ipnext;
@@ -268,12 +325,18 @@ static int run_x_k_nearest(int ncount, int num, CCdatagroup *dat,
         goto CLEANUP;
     }
 
-    if (!usex && doquad) {
+    if (!usex && doquad && !silent) {
         printf("NOTE: Cannot run quadrant nearest with a JUNK norm.\n");
         printf("      Running nearest instead.\n");
         fflush(stdout);
     }
 
+    if (!usex) {
+        rval = junk_k_nearest(ncount, num, dat, wcoord, wantlist, ecount,
+                              elist, nthreads, silent);
+        goto CLEANUP;
+    }
+
     for (n = 0; n < ncount; n++) {
         if (usex) {
             if (doquad) {
@@ -615,12 +678,22 @@ static void insert(int n, int m, shortedge *nearlist, CCdatagroup *dat,
 
 int CCedgegen_junk_node_k_nearest(CCdatagroup *dat, double *wcoord, int n,
                                   int nearnum, int ncount, int *list) {
-    int i, j, ntotal;
+    int rval;
     shortedge *nearlist = (shortedge *)NULL;
 
     nearlist = CC_SAFE_MALLOC(nearnum + 1, shortedge);
     if (!nearlist)
         return 1;
+    rval = junk_scan(dat, wcoord, n, nearnum, ncount, nearlist, list);
+    CC_FREE(nearlist, shortedge);
+    return rval;
+}
+
+/* nearlist is scratch space for nearnum + 1 entries */
+static int junk_scan(CCdatagroup *dat, double *wcoord, int n, int nearnum,
+                     int ncount, shortedge *nearlist, int *list) {
+    int i, j, ntotal;
+
     for (i = 0; i < nearnum; i++)
         nearlist[i].length = BIGDOUBLE;
     nearlist[nearnum].length = -BIGDOUBLE;
@@ -644,11 +717,347 @@ int CCedgegen_junk_node_k_nearest(CCdatagroup *dat, double *wcoord, int n,
             list[i] = -1;
         return 1;
     }
-
-    CC_IFFREE(nearlist, shortedge);
     return 0;
 }
 
+/* The scans of the nodes are independent, so they are split into one    */
+/* block of nodes per worker. A second pass has each worker count, and   */
+/* then write, the edges of its block that no smaller node has listed;   */
+/* the blocks land in elist in node order, whatever the thread count.    */
+static int junk_k_nearest(int ncount, int num, CCdatagroup *dat,
+                          double *wcoord, int wantlist, int *ecount,
+                          int **elist, int nthreads, int silent) {
+    int rval = 0;
+    int i, nworkers, total;
+    int *lists = (int *)NULL;
+    junkwork *w = (junkwork *)NULL;
+
+    nworkers = (nthreads > 0) ? nthreads : junk_threads(ncount);
+    if (nworkers > JUNK_MAX_THREADS)
+        nworkers = JUNK_MAX_THREADS;
+    lists = CC_SAFE_MALLOC(ncount * num, int);
+    w = CC_SAFE_MALLOC(nworkers, junkwork);
+    if (lists == (int *)NULL || w == (junkwork *)NULL) {
+        fprintf(stderr, "out of memory in junk_k_nearest\n");
+        rval = 1;
+        goto CLEANUP;
+    }
+
+    for (i = 0; i < nworkers; i++) {
+        w[i].dat = dat;
+        w[i].wcoord = wcoord;
+        w[i].ncount = ncount;
+        w[i].num = num;
+        w[i].lo = (int)(((double)ncount * i) / nworkers);
+        w[i].hi = (int)(((double)ncount * (i + 1)) / nworkers);
+        w[i].lists = lists;
+        w[i].ecount = 0;
+        w[i].elist = (int *)NULL;
+        w[i].rval = 0;
+    }
+
+    if (dat->norm == CC_MATRIXNORM && wcoord == (double *)NULL) {
+        rval = matrix_lists(ncount, num, dat, lists, nworkers);
+        if (rval) {
+            fprintf(stderr, "matrix_lists failed\n");
+            goto CLEANUP;
+        }
+    } else {
+        CCutil_run_workers(w, sizeof(junkwork), nworkers, junk_lists_work);
+        for (i = 0; i < nworkers; i++) {
+            if (w[i].rval) {
+                fprintf(stderr, "junk_node_k_nearest_failed\n");
+                rval = 1;
+                goto CLEANUP;
+            }
+        }
+    }
+
+    /* The counting pass: elist is still NULL */
+    CCutil_run_workers(w, sizeof(junkwork), nworkers, junk_edges_work);
+    for (i = 0, total = 0; i < nworkers; i++)
+        total += w[i].ecount;
+
+    if (!silent) {
+        printf(" %d edges (%d threads)\n", total, nworkers);
+        fflush(stdout);
+    }
+
+    if (wantlist) {
+        *elist = CC_SAFE_MALLOC(2 * total, int);
+        if (!(*elist)) {
+            rval = 1;
+            goto CLEANUP;
+        }
+        *ecount = total;
+        for (i = 0, total = 0; i < nworkers; i++) {
+            w[i].elist = *elist + 2 * total;
+            total += w[i].ecount;
+        }
+        CCutil_run_workers(w, sizeof(junkwork), nworkers, junk_edges_work);
+    }
+
+CLEANUP:
+
+    CC_IFFREE(lists, int);
+    CC_IFFREE(w, junkwork);
+    return rval;
+}
+
+static void *junk_lists_work(void *arg) {
+    junkwork *w = (junkwork *)arg;
+    shortedge *nearlist;
+    int n;
+
+    nearlist = CC_SAFE_MALLOC(w->num + 1, shortedge);
+    if (nearlist == (shortedge *)NULL) {
+        w->rval = 1;
+        return (void *)NULL;
+    }
+    for (n = w->lo; n < w->hi && w->rval == 0; n++) {
+        w->rval = junk_scan(w->dat, w->wcoord, n, w->num, w->ncount, nearlist,
+                            w->lists + n * w->num);
+    }
+    CC_FREE(nearlist, shortedge);
+    return (void *)NULL;
+}
+
+/* Edge nj is kept unless j < n and j's own list holds n */
+static void *junk_edges_work(void *arg) {
+    junkwork *w = (junkwork *)arg;
+    int n, i, q, j, k = 0;
+    int num = w->num;
+
+    for (n = w->lo; n < w->hi; n++) {
+        for (i = 0; i < num; i++) {
+            j = w->lists[n * num + i];
+            if (j < n) {
+                for (q = 0; q < num && w->lists[j * num + q] != n; q++)
+                    ;
+                if (q < num)
+                    continue;
+            }
+            if (w->elist != (int *)NULL) {
+                w->elist[2 * k] = n;
+                w->elist[2 * k + 1] = j;
+            }
+            k++;
+        }
+    }
+    w->ecount = k;
+    return (void *)NULL;
+}
+
+/* The CC_MATRIXNORM kernel. Row i of the triangle holds d(i,j) for j < i */
+/* contiguously, so the triangle is cut into tiles of MATRIX_TILE columns  */
+/* and read one row segment at a time: each entry updates the top lists of */
+/* both its row and its column node, and the lists of a tile's columns     */
+/* stay in cache while the rows stream past. Blocks of MATRIX_CHUNK        */
+/* entries are first compared (branch free, so the compiler can use SIMD   */
+/* integer compares) against the row's threshold and the columns'          */
+/* thresholds; only blocks with a hit are looked at one by one. Ties are   */
+/* broken by the smaller end, so the lists do not depend on the tiling or  */
+/* on the number of workers.                                               */
+static int matrix_lists(int ncount, int num, CCdatagroup *dat, int *lists,
+                        int nworkers) {
+    int rval = 0;
+    int i, t, b, nblocks;
+    double total, sofar;
+    matwork *w = (matwork *)NULL;
+
+    nblocks = (ncount + MATRIX_TILE - 1) / MATRIX_TILE;
+    if (nworkers > nblocks)
+        nworkers = nblocks;
+
+    w = CC_SAFE_MALLOC(nworkers, matwork);
+    if (w == (matwork *)NULL) {
+        fprintf(stderr, "out of memory in matrix_lists\n");
+        return 1;
+    }
+    for (t = 0; t < nworkers; t++) {
+        w[t].dist = CC_SAFE_MALLOC(ncount * num, int);
+        w[t].end = CC_SAFE_MALLOC(ncount * num, int);
+        w[t].thresh = CC_SAFE_MALLOC(ncount, int);
+    }
+    for (t = 0; t < nworkers; t++) {
+        if (w[t].dist == (int *)NULL || w[t].end == (int *)NULL ||
+            w[t].thresh == (int *)NULL) {
+            fprintf(stderr, "out of memory in matrix_lists\n");
+            rval = 1;
+            goto CLEANUP;
+        }
+    }
+
+    /* Tile b costs about MATRIX_TILE * (ncount - b * MATRIX_TILE) reads */
+    total = 0.0;
+    for (b = 0; b < nblocks; b++)
+        total += (double)(ncount - b * MATRIX_TILE);
+    for (t = 0, b = 0, sofar = 0.0; t < nworkers; t++) {
+        w[t].blo = b;
+        for (; b < nblocks && (t == nworkers - 1 ||
+                               sofar < total * (t + 1) / nworkers);
+             b++) {
+            sofar += (double)(ncount - b * MATRIX_TILE);
+        }
+        w[t].bhi = b;
+    }
+
+    for (t = 0; t < nworkers; t++) {
+        w[t].dat = dat;
+        w[t].ncount = ncount;
+        w[t].num = num;
+        w[t].lo = (int)(((double)ncount * t) / nworkers);
+        w[t].hi = (int)(((double)ncount * (t + 1)) / nworkers);
+        w[t].all = w;
+        w[t].nall = nworkers;
+        w[t].lists = lists;
+        w[t].rval = 0;
+        for (i = 0; i < ncount * num; i++) {
+            w[t].dist[i] = CCutil_MAXINT;
+            w[t].end[i] = CCutil_MAXINT;
+        }
+        for (i = 0; i < ncount; i++)
+            w[t].thresh[i] = CCutil_MAXINT;
+    }
+
+    CCutil_run_workers(w, sizeof(matwork), nworkers, matrix_tiles_work);
+    CCutil_run_workers(w, sizeof(matwork), nworkers, matrix_merge_work);
+    for (t = 0; t < nworkers; t++) {
+        if (w[t].rval) {
+            fprintf(stderr, "There do not exist %d neighbors\n", num);
+            rval = 1;
+        }
+    }
+
+CLEANUP:
+
+    for (t = 0; t < nworkers; t++) {
+        CC_IFFREE(w[t].dist, int);
+        CC_IFFREE(w[t].end, int);
+        CC_IFFREE(w[t].thresh, int);
+    }
+    CC_FREE(w, matwork);
+    return rval;
+}
+
+static void *matrix_tiles_work(void *arg) {
+    matwork *w = (matwork *)arg;
+    int **adj = w->dat->adj;
+    int ncount = w->ncount;
+    int b, i, j0, j1;
+
+    for (b = w->blo; b < w->bhi; b++) {
+        j0 = b * MATRIX_TILE;
+        j1 = j0 + MATRIX_TILE;
+        if (j1 > ncount)
+            j1 = ncount;
+        for (i = j0 + 1; i < ncount; i++) {
+            matrix_row(w, i, j0, adj[i] + j0, (i < j1 ? i : j1) - j0);
+        }
+    }
+    return (void *)NULL;
+}
+
+/* row[q] is d(i, j0 + q) for q < len */
+static void matrix_row(matwork *w, int i, int j0, const int *row, int len) {
+    const int *tc = w->thresh + j0;
+    int ti = w->thresh[i];
+    int c, q, m, hit;
+
+    for (c = 0; c < len; c += MATRIX_CHUNK) {
+        m = len - c;
+        if (m >= MATRIX_CHUNK) {
+            m = MATRIX_CHUNK;
+            hit = 0;
+            for (q = 0; q < MATRIX_CHUNK; q++)
+                hit |= (row[c + q] <= ti) | (row[c + q] <= tc[c + q]);
+            if (!hit)
+                continue;
+        }
+        for (q = c; q < c + m; q++) {
+            if (row[q] <= w->thresh[i])
+                top_insert(w, i, row[q], j0 + q);
+            if (row[q] <= tc[q])
+                top_insert(w, j0 + q, row[q], i);
+        }
+        ti = w->thresh[i];
+    }
+}
+
+/* Called with d <= thresh[v]; an entry equal to the last loses to it */
+/* unless its end is smaller.                                          */
+static void top_insert(matwork *w, int v, int d, int e) {
+    int *vd = w->dist + v * w->num;
+    int *ve = w->end + v * w->num;
+    int i = w->num - 1;
+
+    if (d == vd[i] && e > ve[i])
+        return;
+    while (i > 0 && (vd[i - 1] > d || (vd[i - 1] == d && ve[i - 1] > e))) {
+        vd[i] = vd[i - 1];
+        ve[i] = ve[i - 1];
+        i--;
+    }
+    vd[i] = d;
+    ve[i] = e;
+    w->thresh[v] = vd[w->num - 1];
+}
+
+/* Each edge lies in exactly one tile, so the workers' lists for a node */
+/* are disjoint and a num-way merge gives its top list.                 */
+static void *matrix_merge_work(void *arg) {
+    matwork *w = (matwork *)arg;
+    matwork *all = w->all;
+    int num = w->num;
+    int v, k, t, best, bd, be, d;
+    int head[JUNK_MAX_THREADS];
+
+    for (v = w->lo; v < w->hi; v++) {
+        for (t = 0; t < w->nall; t++)
+            head[t] = v * num;
+        for (k = 0; k < num; k++) {
+            best = 0;
+            bd = all[0].dist[head[0]];
+            be = all[0].end[head[0]];
+            for (t = 1; t < w->nall; t++) {
+                d = all[t].dist[head[t]];
+                if (d < bd || (d == bd && all[t].end[head[t]] < be)) {
+                    best = t;
+                    bd = d;
+                    be = all[t].end[head[t]];
+                }
+            }
+            if (be == CCutil_MAXINT) {
+                w->lists[v * num + k] = -1;
+                w->rval = 1;
+                continue;
+            }
+            w->lists[v * num + k] = be;
+            if (head[best] < v * num + num - 1)
+                head[best]++;
+            else {
+                all[best].dist[head[best]] = CCutil_MAXINT;
+                all[best].end[head[best]] = CCutil_MAXINT;
+            }
+        }
+    }
+    return (void *)NULL;
+}
+
+/* Each scan is O(ncount), so small instances are not worth a thread */
+static int junk_threads(int ncount) {
+    int nthreads = ncount / JUNK_THREAD_NODES;
+    int cpus = CCutil_cpu_count();
+
+    if (nthreads > cpus)
+        nthreads = cpus;
+    if (nthreads > JUNK_MAX_THREADS)
+        nthreads = JUNK_MAX_THREADS;
+    if (nthreads < 1)
+        nthreads = 1;
+    return nthreads;
+}
+
 int CCedgegen_junk_node_nearest(CCdatagroup *dat, double *wcoord, int ncount,
                                 int n, char *marks) {
     int j, bestnode = 0;
@@ -1120,7 +1529,7 @@ int CCedgegen_x_qboruvka_tour(int ncount, CCdatagroup *dat, int *outcycle,
                     tail[tail[x]] = tail[y];
                     tail[tail[y]] = tail[x];
                 }
-                if (count % 10000 == 9999) {
+                if (!silent && count % 10000 == 9999) {
                     printf(".");
                     fflush(stdout);
                 }
@@ -1138,7 +1547,7 @@ int CCedgegen_x_qboruvka_tour(int ncount, CCdatagroup *dat, int *outcycle,
     }
     len += (double)CCutil_dat_edgelen(x, y, dat);
     *val = len;
-    if (ncount >= 10000)
+    if (!silent && ncount >= 10000)
         printf("\n");
     // printf ("Length of Quick-Boruvka Tour: %.2f\n", len);
 
@@ -1557,7 +1966,7 @@ int CCedgegen_junk_qboruvka_tour(int ncount, CCdatagroup *dat, int *outcycle,
                     tail[tail[x]] = tail[y];
                     tail[tail[y]] = tail[x];
                 }
-                if (count % 10000 == 9999) {
+                if (!silent && count % 10000 == 9999) {
                     printf(".");
                     fflush(stdout);
                 }
@@ -1575,7 +1984,7 @@ int CCedgegen_junk_qboruvka_tour(int ncount, CCdatagroup *dat, int *outcycle,
     }
     len += (double)CCutil_dat_edgelen(x, y, dat);
     *val = len;
-    if (ncount >= 10000)
+    if (!silent && ncount >= 10000)
         printf("\n");
     // printf("Length of Quick-Boruvka Tour: %.2f\n", len);
 
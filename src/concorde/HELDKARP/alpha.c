@@ -0,0 +1,677 @@
+/****************************************************************************/
+/*                                                                          */
+/*  This file is part of CONCORDE                                           */
+/*                                                                          */
+/*  (c) Copyright 1995--1999 by David Applegate, Robert Bixby,              */
+/*  Vasek Chvatal, and William Cook                                         */
+/*                                                                          */
+/*  Permission is granted for academic research use.  For other uses,       */
+/*  contact the authors for licensing options.                              */
+/*                                                                          */
+/*  Use at your own risk.  We make no guarantees about the                  */
+/*  correctness or usefulness of this code.                                 */
+/*                                                                          */
+/****************************************************************************/
+
+/****************************************************************************/
+/*                                                                          */
+/*                 ALPHA-NEARNESS CANDIDATE EDGES                           */
+/*                                                                          */
+/*                           TSP CODE                                       */
+/*                                                                          */
+/*                                                                          */
+/*    EXPORTED FUNCTIONS:                                                   */
+/*                                                                          */
+/*  int CCheldkarp_alpha_nearest (int ncount, CCdatagroup *dat,             */
+/*      int ecount, const int *elist, int k, int *acount, int **alist,      */
+/*      double *lowbound, int silent)                                       */
+/*    RETURNS the graph of the k alpha-nearest neighbors of each node.      */
+/*     -ecount, elist is a sparse graph (a k-nearest graph, say) that the   */
+/*      subgradient ascent is run on; the minimum spanning tree edges are   */
+/*      added to it, so it need not be connected                            */
+/*     -acount, alist return the edges in end0 end1 format                  */
+/*     -lowbound returns the 1-tree bound of the final penalties (it can    */
+/*      be NULL)                                                            */
+/*    The alpha-value of an edge is the increase in the length of the       */
+/*    minimum 1-tree (under the node penalties of the ascent) when the      */
+/*    1-tree is forced to use the edge (Helsgaun); edges of optimal tours   */
+/*    have small alpha-values far more often than they are among the        */
+/*    nearest neighbors. The ascent costs O(m log n) per step on the        */
+/*    sparse graph; the alpha-values take O(n^2) time and O(n) space.       */
+/*                                                                          */
+/*  int CCheldkarp_sparse_bound (int ncount, CCdatagroup *dat,              */
+/*      int ecount, const int *elist, double *lowbound, int silent)         */
+/*    RETURNS in lowbound the Held-Karp 1-tree bound on the length of       */
+/*    every tour, for instances far beyond CCheldkarp_small.                */
+/*     -ecount, elist is the sparse graph the ascent is run on (the LK      */
+/*      candidate edges, say); it need not be connected                     */
+/*    After each ascent the minimum 1-tree of the complete graph is         */
+/*    computed under the penalties; its value is a bound, and the edges     */
+/*    of it that the sparse graph lacks are added before the next ascent,   */
+/*    up to SPARSE_REPAIRS times. The best of these bounds is returned.     */
+/*    Each repair costs O(n^2) time; memory stays O(n + m).                 */
+/*                                                                          */
+/****************************************************************************/
+
+#include "heldkarp.h"
+#include "machdefs.h"
+#include "macrorus.h"
+#include "util.h"
+
+#define ALPHA_BIG (1e30)
+#define ALPHA_MIN_PERIOD 10  /* Ascent steps in the first period       */
+#define ALPHA_MAX_PERIOD 100 /*   (ncount / 2 between these bounds)    */
+#define ALPHA_STEP (0.01)    /* First step, as a part of the mean edge */
+#define SPARSE_REPAIRS 3     /* Ascents rerun on a repaired graph      */
+
+#define ALPHA_MAX(a, b) ((a) > (b) ? (a) : (b))
+
+/* Node 0 is the special node of every 1-tree */
+typedef struct alphagraph {
+    int ncount;
+    int *start; /* the neighbors of v are adj[start[v]..start[v+1]-1] */
+    int *adj;
+    int *len;
+} alphagraph;
+
+/* Both orders of an edge must give the same double, since the alpha of */
+/* a tree edge is computed as the difference of two such costs.          */
+#define ALPHA_COST(d, pi, a, b)                                               \
+    ((a) < (b) ? (double)(d) + (pi)[a] + (pi)[b]                              \
+               : (double)(d) + (pi)[b] + (pi)[a])
+
+static int build_graph(alphagraph *g, int ncount, int ecount, const int *elist,
+                       const int *dad, CCdatagroup *dat),
+    sparse_tree(alphagraph *g, const double *pi, int *deg, int *dad,
+                char *state, CCdheap *h, double *val),
+    add_edge(const alphagraph *g, int v, int w, int *glist, int *gcount),
+    add_tree(const alphagraph *g, int ncount, const int *dad, int n1, int n2,
+             int *glist, int *gcount);
+
+static void ascent(alphagraph *g, double *pi, double *work, int *deg,
+                   int *lastdeg, int *dad, char *state, CCdheap *h,
+                   int *steps),
+    dense_tree(int ncount, CCdatagroup *dat, const double *pi, int *dad,
+               int *order, double *dcost, double *key, double *val),
+    special_edges(int ncount, CCdatagroup *dat, const double *pi, double *c1,
+                  double *c2, int *n1, int *n2),
+    free_graph(alphagraph *g),
+    top_add(int k, double *topa, double *topc, int *tope, double a, double c,
+            int e);
+
+int CCheldkarp_alpha_nearest(int ncount, CCdatagroup *dat, int ecount,
+                             const int *elist, int k, int *acount,
+                             int **alist, double *lowbound, int silent) {
+    int rval = 0;
+    int a, b, i, j, q, n1, n2, steps = 0, total;
+    double val, c, c1, c2, sum;
+    double *pi = (double *)NULL, *work = (double *)NULL;
+    double *dcost = (double *)NULL, *beta = (double *)NULL;
+    double *topa = (double *)NULL, *topc = (double *)NULL;
+    int *deg = (int *)NULL, *lastdeg = (int *)NULL, *dad = (int *)NULL;
+    int *order = (int *)NULL, *mark = (int *)NULL, *lists = (int *)NULL;
+    char *state = (char *)NULL;
+    alphagraph g;
+    CCdheap h;
+
+    *acount = 0;
+    *alist = (int *)NULL;
+    g.start = (int *)NULL;
+    g.adj = (int *)NULL;
+    g.len = (int *)NULL;
+    h.entry = (int *)NULL;
+
+    if (ncount < 3) {
+        fprintf(stderr, "alpha-nearness needs at least 3 nodes\n");
+        return 1;
+    }
+    if (k > ncount - 1)
+        k = ncount - 1;
+
+    pi = CC_SAFE_MALLOC(ncount, double);
+    work = CC_SAFE_MALLOC(ncount, double);
+    dcost = CC_SAFE_MALLOC(ncount, double);
+    beta = CC_SAFE_MALLOC(ncount, double);
+    topa = CC_SAFE_MALLOC(k, double);
+    topc = CC_SAFE_MALLOC(k, double);
+    deg = CC_SAFE_MALLOC(ncount, int);
+    lastdeg = CC_SAFE_MALLOC(ncount, int);
+    dad = CC_SAFE_MALLOC(ncount, int);
+    order = CC_SAFE_MALLOC(ncount, int);
+    mark = CC_SAFE_MALLOC(ncount, int);
+    lists = CC_SAFE_MALLOC(ncount * k, int);
+    state = CC_SAFE_MALLOC(ncount, char);
+    if (!pi || !work || !dcost || !beta || !topa || !topc || !deg ||
+        !lastdeg || !dad || !order || !mark || !lists || !state) {
+        fprintf(stderr, "out of memory in CCheldkarp_alpha_nearest\n");
+        rval = 1;
+        goto CLEANUP;
+    }
+    rval = CCutil_dheap_init(&h, ncount);
+    if (rval) {
+        fprintf(stderr, "CCutil_dheap_init failed\n");
+        goto CLEANUP;
+    }
+
+    /* The spanning tree keeps the sparse graph connected */
+    for (i = 0; i < ncount; i++)
+        pi[i] = 0.0;
+    dense_tree(ncount, dat, pi, dad, order, dcost, work, &val);
+    rval = build_graph(&g, ncount, ecount, elist, dad, dat);
+    if (rval)
+        goto CLEANUP;
+
+    ascent(&g, pi, work, deg, lastdeg, dad, state, &h, &steps);
+
+    /* The exact minimum 1-tree under the final penalties */
+    dense_tree(ncount, dat, pi, dad, order, dcost, work, &val);
+    special_edges(ncount, dat, pi, &c1, &c2, &n1, &n2);
+    for (i = 0, sum = 0.0; i < ncount; i++)
+        sum += pi[i];
+    val += c1 + c2 - 2.0 * sum;
+    if (lowbound != (double *)NULL)
+        *lowbound = val;
+    if (!silent) {
+        printf("alpha: 1-tree bound %.0f after %d ascent steps\n", val, steps);
+        fflush(stdout);
+    }
+
+    /* beta[b] is the longest edge on the tree path from a to b: it is */
+    /* set along a's path to the root, and then for the other nodes in  */
+    /* the order they joined the tree (each after its dad).             */
+    for (i = 0; i < ncount; i++)
+        mark[i] = -1;
+    for (a = 0; a < ncount; a++) {
+        for (i = 0; i < k; i++) {
+            topa[i] = ALPHA_BIG;
+            topc[i] = ALPHA_BIG;
+            lists[a * k + i] = -1;
+        }
+        if (a == 0) {
+            for (b = 1; b < ncount; b++) {
+                c = ALPHA_COST(CCutil_dat_edgelen(0, b, dat), pi, 0, b);
+                top_add(k, topa, topc, lists + a * k, ALPHA_MAX(c - c2, 0.0), c,
+                        b);
+            }
+            continue;
+        }
+        beta[a] = -ALPHA_BIG;
+        mark[a] = a;
+        for (b = a; dad[b] != -1; b = dad[b]) {
+            beta[dad[b]] = ALPHA_MAX(beta[b], dcost[b]);
+            mark[dad[b]] = a;
+        }
+        for (i = 0; i < ncount - 1; i++) {
+            b = order[i];
+            if (b == a)
+                continue;
+            if (mark[b] != a)
+                beta[b] = ALPHA_MAX(beta[dad[b]], dcost[b]);
+            c = ALPHA_COST(CCutil_dat_edgelen(a, b, dat), pi, a, b);
+            top_add(k, topa, topc, lists + a * k, c - beta[b], c, b);
+        }
+        c = ALPHA_COST(CCutil_dat_edgelen(a, 0, dat), pi, a, 0);
+        top_add(k, topa, topc, lists + a * k, ALPHA_MAX(c - c2, 0.0), c, 0);
+    }
+
+    /* Edge ab is kept unless b < a and b's own list holds a */
+    for (q = 0; q < 2; q++) {
+        total = 0;
+        for (a = 0; a < ncount; a++) {
+            for (i = 0; i < k; i++) {
+                b = lists[a * k + i];
+                if (b < a) {
+                    for (j = 0; j < k && lists[b * k + j] != a; j++)
+                        ;
+                    if (j < k)
+                        continue;
+                }
+                if (q == 1) {
+                    (*alist)[2 * total] = a;
+                    (*alist)[2 * total + 1] = b;
+                }
+                total++;
+            }
+        }
+        if (q == 0) {
+            *alist = CC_SAFE_MALLOC(2 * total, int);
+            if (!(*alist)) {
+                fprintf(stderr, "out of memory in CCheldkarp_alpha_nearest\n");
+                rval = 1;
+                goto CLEANUP;
+            }
+        }
+    }
+    *acount = total;
+
+CLEANUP:
+
+    if (h.entry != (int *)NULL)
+        CCutil_dheap_free(&h);
+    free_graph(&g);
+    CC_IFFREE(pi, double);
+    CC_IFFREE(work, double);
+    CC_IFFREE(dcost, double);
+    CC_IFFREE(beta, double);
+    CC_IFFREE(topa, double);
+    CC_IFFREE(topc, double);
+    CC_IFFREE(deg, int);
+    CC_IFFREE(lastdeg, int);
+    CC_IFFREE(dad, int);
+    CC_IFFREE(order, int);
+    CC_IFFREE(mark, int);
+    CC_IFFREE(lists, int);
+    CC_IFFREE(state, char);
+    return rval;
+}
+
+int CCheldkarp_sparse_bound(int ncount, CCdatagroup *dat, int ecount,
+                            const int *elist, double *lowbound, int silent) {
+    int rval = 0;
+    int i, round, n1, n2, added = 0, gcount = ecount, steps = 0;
+    double val, c1, c2, sum, best = -ALPHA_BIG;
+    double *pi = (double *)NULL, *work = (double *)NULL;
+    double *dcost = (double *)NULL;
+    int *deg = (int *)NULL, *lastdeg = (int *)NULL, *dad = (int *)NULL;
+    int *order = (int *)NULL, *glist = (int *)NULL;
+    char *state = (char *)NULL;
+    alphagraph g;
+    CCdheap h;
+
+    g.start = (int *)NULL;
+    g.adj = (int *)NULL;
+    g.len = (int *)NULL;
+    h.entry = (int *)NULL;
+
+    if (ncount < 3) {
+        fprintf(stderr, "a 1-tree bound needs at least 3 nodes\n");
+        return 1;
+    }
+
+    pi = CC_SAFE_MALLOC(ncount, double);
+    work = CC_SAFE_MALLOC(ncount, double);
+    dcost = CC_SAFE_MALLOC(ncount, double);
+    deg = CC_SAFE_MALLOC(ncount, int);
+    lastdeg = CC_SAFE_MALLOC(ncount, int);
+    dad = CC_SAFE_MALLOC(ncount, int);
+    order = CC_SAFE_MALLOC(ncount, int);
+    state = CC_SAFE_MALLOC(ncount, char);
+    /* The first 1-tree and each repair add at most ncount edges */
+    glist = CC_SAFE_MALLOC(2 * (ecount + (SPARSE_REPAIRS + 1) * ncount), int);
+    if (!pi || !work || !dcost || !deg || !lastdeg || !dad || !order ||
+        !state || !glist) {
+        fprintf(stderr, "out of memory in CCheldkarp_sparse_bound\n");
+        rval = 1;
+        goto CLEANUP;
+    }
+    rval = CCutil_dheap_init(&h, ncount);
+    if (rval) {
+        fprintf(stderr, "CCutil_dheap_init failed\n");
+        goto CLEANUP;
+    }
+
+    /* The minimum 1-tree keeps the sparse graph connected */
+    for (i = 0; i < 2 * ecount; i++)
+        glist[i] = elist[i];
+    for (i = 0; i < ncount; i++)
+        pi[i] = 0.0;
+    dense_tree(ncount, dat, pi, dad, order, dcost, work, &val);
+    special_edges(ncount, dat, pi, &c1, &c2, &n1, &n2);
+    add_tree((alphagraph *)NULL, ncount, dad, n1, n2, glist, &gcount);
+
+    for (round = 0; round <= SPARSE_REPAIRS; round++) {
+        rval = build_graph(&g, ncount, gcount, glist, (int *)NULL, dat);
+        if (rval)
+            goto CLEANUP;
+        ascent(&g, pi, work, deg, lastdeg, dad, state, &h, &steps);
+
+        /* The ascent only saw the sparse graph; the bound needs them all */
+        dense_tree(ncount, dat, pi, dad, order, dcost, work, &val);
+        special_edges(ncount, dat, pi, &c1, &c2, &n1, &n2);
+        for (i = 0, sum = 0.0; i < ncount; i++)
+            sum += pi[i];
+        val += c1 + c2 - 2.0 * sum;
+        if (val > best)
+            best = val;
+
+        /* The last round's tree would never be searched */
+        if (round < SPARSE_REPAIRS)
+            i = add_tree(&g, ncount, dad, n1, n2, glist, &gcount);
+        else
+            i = 0;
+        free_graph(&g);
+        if (i == 0)
+            break;
+        added += i;
+    }
+
+    *lowbound = best;
+    if (!silent) {
+        printf("sparse: 1-tree bound %.0f after %d ascent steps, "
+               "%d edges repaired\n", best, steps, added);
+        fflush(stdout);
+    }
+
+CLEANUP:
+
+    if (h.entry != (int *)NULL)
+        CCutil_dheap_free(&h);
+    free_graph(&g);
+    CC_IFFREE(pi, double);
+    CC_IFFREE(work, double);
+    CC_IFFREE(dcost, double);
+    CC_IFFREE(deg, int);
+    CC_IFFREE(lastdeg, int);
+    CC_IFFREE(dad, int);
+    CC_IFFREE(order, int);
+    CC_IFFREE(glist, int);
+    CC_IFFREE(state, char);
+    return rval;
+}
+
+/* Appends to glist the edges of the 1-tree (dad, 0 n1, 0 n2) that g   */
+/* does not have (all of them if g is NULL); returns how many.          */
+static int add_tree(const alphagraph *g, int ncount, const int *dad, int n1,
+                    int n2, int *glist, int *gcount) {
+    int v, count = 0;
+
+    for (v = 0; v < ncount; v++) {
+        if (dad[v] != -1)
+            count += add_edge(g, v, dad[v], glist, gcount);
+    }
+    count += add_edge(g, 0, n1, glist, gcount);
+    count += add_edge(g, 0, n2, glist, gcount);
+    return count;
+}
+
+static int add_edge(const alphagraph *g, int v, int w, int *glist,
+                    int *gcount) {
+    int e;
+
+    if (g != (alphagraph *)NULL) {
+        for (e = g->start[v]; e < g->start[v + 1]; e++) {
+            if (g->adj[e] == w)
+                return 0;
+        }
+    }
+    glist[2 * *gcount] = v;
+    glist[2 * *gcount + 1] = w;
+    (*gcount)++;
+    return 1;
+}
+
+static void free_graph(alphagraph *g) {
+    CC_IFFREE(g->start, int);
+    CC_IFFREE(g->adj, int);
+    CC_IFFREE(g->len, int);
+}
+
+/* The union of elist and the tree edges v dad[v] (dad can be NULL), */
+/* as adjacency arrays                                               */
+static int build_graph(alphagraph *g, int ncount, int ecount, const int *elist,
+                       const int *dad, CCdatagroup *dat) {
+    int i, v, w, m = 2 * ecount + 2 * ncount;
+
+    g->ncount = ncount;
+    g->start = CC_SAFE_MALLOC(ncount + 1, int);
+    g->adj = CC_SAFE_MALLOC(m, int);
+    g->len = CC_SAFE_MALLOC(m, int);
+    if (!g->start || !g->adj || !g->len) {
+        fprintf(stderr, "out of memory in build_graph\n");
+        return 1;
+    }
+
+    for (i = 0; i <= ncount; i++)
+        g->start[i] = 0;
+    for (i = 0; i < ecount; i++) {
+        g->start[elist[2 * i]]++;
+        g->start[elist[2 * i + 1]]++;
+    }
+    for (v = 0; dad != (int *)NULL && v < ncount; v++) {
+        if (dad[v] != -1) {
+            g->start[v]++;
+            g->start[dad[v]]++;
+        }
+    }
+    for (v = 0, m = 0; v <= ncount; v++) {
+        w = g->start[v];
+        g->start[v] = m;
+        m += w;
+    }
+
+    /* start[v] is used as a fill pointer, and then shifted back */
+    for (i = 0; i < ecount; i++) {
+        v = elist[2 * i];
+        w = elist[2 * i + 1];
+        g->len[g->start[v]] = g->len[g->start[w]] =
+            CCutil_dat_edgelen(v, w, dat);
+        g->adj[g->start[v]++] = w;
+        g->adj[g->start[w]++] = v;
+    }
+    for (v = 0; dad != (int *)NULL && v < ncount; v++) {
+        if ((w = dad[v]) != -1) {
+            g->len[g->start[v]] = g->len[g->start[w]] =
+                CCutil_dat_edgelen(v, w, dat);
+            g->adj[g->start[v]++] = w;
+            g->adj[g->start[w]++] = v;
+        }
+    }
+    for (v = ncount; v > 0; v--)
+        g->start[v] = g->start[v - 1];
+    g->start[0] = 0;
+    return 0;
+}
+
+/* The subgradient ascent of Held and Karp, with the step and period   */
+/* schedule of Helsgaun: pi moves by t times a mix of this and the last */
+/* degree excess; t doubles while the first period keeps improving, and */
+/* t and the period are halved each period after that. Returns the best */
+/* penalties in pi.                                                     */
+static void ascent(alphagraph *g, double *pi, double *work, int *deg,
+                   int *lastdeg, int *dad, char *state, CCdheap *h,
+                   int *steps) {
+    int ncount = g->ncount;
+    int i, p, period, initial = 1, norm;
+    double t, w, bestw;
+
+    for (i = 0; i < ncount; i++)
+        work[i] = pi[i];
+    if (sparse_tree(g, work, deg, dad, state, h, &bestw))
+        return;
+    for (i = 0, norm = 0; i < ncount; i++) {
+        deg[i] -= 2;
+        lastdeg[i] = deg[i];
+        norm += deg[i] * deg[i];
+    }
+
+    period = ncount / 2;
+    if (period < ALPHA_MIN_PERIOD)
+        period = ALPHA_MIN_PERIOD;
+    if (period > ALPHA_MAX_PERIOD)
+        period = ALPHA_MAX_PERIOD;
+    t = ALPHA_STEP * ALPHA_MAX(bestw, 1.0) / ncount;
+
+    for (; period > 0 && norm != 0; period /= 2, t /= 2) {
+        for (p = 1; p <= period && norm != 0; p++) {
+            for (i = 0; i < ncount; i++) {
+                work[i] += t * (0.7 * deg[i] + 0.3 * lastdeg[i]);
+                lastdeg[i] = deg[i];
+            }
+            (*steps)++;
+            if (sparse_tree(g, work, deg, dad, state, h, &w))
+                return;
+            for (i = 0, norm = 0; i < ncount; i++) {
+                deg[i] -= 2;
+                norm += deg[i] * deg[i];
+            }
+            if (w > bestw) {
+                bestw = w;
+                for (i = 0; i < ncount; i++)
+                    pi[i] = work[i];
+                if (initial)
+                    t *= 2;
+                if (p == period && (period *= 2) > ALPHA_MAX_PERIOD)
+                    period = ALPHA_MAX_PERIOD;
+            } else if (initial && p > period / 2) {
+                initial = 0;
+                p = 0;
+                t = 3 * t / 4;
+            }
+        }
+    }
+}
+
+/* Prim's algorithm on the sparse graph; node 0 then gets its two      */
+/* cheapest edges. Returns 1 if the graph does not give a 1-tree.       */
+static int sparse_tree(alphagraph *g, const double *pi, int *deg, int *dad,
+                       char *state, CCdheap *h, double *val) {
+    int ncount = g->ncount;
+    int v, w, e, reached = 0, n1 = -1, n2 = -1;
+    double c, c1 = ALPHA_BIG, c2 = ALPHA_BIG, sum = 0.0;
+
+    for (v = 0; v < ncount; v++) {
+        deg[v] = 0;
+        dad[v] = -1;
+        state[v] = 0; /* 1 in the heap, 2 in the tree */
+    }
+    *val = 0.0;
+
+    h->key[1] = 0.0;
+    CCutil_dheap_insert(h, 1);
+    state[1] = 1;
+    while ((v = CCutil_dheap_deletemin(h)) != -1) {
+        state[v] = 2;
+        reached++;
+        if (dad[v] != -1) {
+            *val += h->key[v];
+            deg[v]++;
+            deg[dad[v]]++;
+        }
+        for (e = g->start[v]; e < g->start[v + 1]; e++) {
+            w = g->adj[e];
+            if (w == 0 || state[w] == 2)
+                continue;
+            c = ALPHA_COST(g->len[e], pi, v, w);
+            if (state[w] == 0) {
+                h->key[w] = c;
+                dad[w] = v;
+                CCutil_dheap_insert(h, w);
+                state[w] = 1;
+            } else if (c < h->key[w]) {
+                dad[w] = v;
+                CCutil_dheap_changekey(h, w, c);
+            }
+        }
+    }
+
+    for (e = g->start[0]; e < g->start[1]; e++) {
+        w = g->adj[e];
+        if (w == n1)
+            continue;
+        c = ALPHA_COST(g->len[e], pi, 0, w);
+        if (c < c1) {
+            c2 = c1;
+            n2 = n1;
+            c1 = c;
+            n1 = w;
+        } else if (c < c2) {
+            c2 = c;
+            n2 = w;
+        }
+    }
+    if (reached != ncount - 1 || n2 == -1) {
+        fprintf(stderr, "sparse graph has no 1-tree\n");
+        return 1;
+    }
+    deg[0] = 2;
+    deg[n1]++;
+    deg[n2]++;
+
+    for (v = 0; v < ncount; v++)
+        sum += pi[v];
+    *val += c1 + c2 - 2.0 * sum;
+    return 0;
+}
+
+/* Prim's algorithm on the complete graph of the nodes 1..ncount-1, in */
+/* O(n^2) time and O(n) space. order lists the nodes as they join the  */
+/* tree; dcost[v] is the cost of the edge v dad[v].                    */
+static void dense_tree(int ncount, CCdatagroup *dat, const double *pi,
+                       int *dad, int *order, double *dcost, double *key,
+                       double *val) {
+    int i, j, v, w, best, rest = ncount - 2;
+    double c;
+
+    /* order[i+1..] holds the nodes still outside the tree */
+    dad[0] = -1;
+    dad[1] = -1;
+    dcost[0] = 0.0;
+    dcost[1] = 0.0;
+    order[0] = 1;
+    for (i = 2; i < ncount; i++) {
+        order[i - 1] = i;
+        key[i] = ALPHA_COST(CCutil_dat_edgelen(1, i, dat), pi, 1, i);
+        dad[i] = 1;
+    }
+    *val = 0.0;
+
+    for (i = 1; rest > 0; i++, rest--) {
+        best = i;
+        for (j = i + 1; j < ncount - 1; j++) {
+            if (key[order[j]] < key[order[best]])
+                best = j;
+        }
+        CC_SWAP(order[i], order[best], v);
+        v = order[i];
+        dcost[v] = key[v];
+        *val += key[v];
+        for (j = i + 1; j < ncount - 1; j++) {
+            w = order[j];
+            c = ALPHA_COST(CCutil_dat_edgelen(v, w, dat), pi, v, w);
+            if (c < key[w]) {
+                key[w] = c;
+                dad[w] = v;
+            }
+        }
+    }
+}
+
+/* c1 <= c2 are the two cheapest edges at node 0, to n1 and n2 */
+static void special_edges(int ncount, CCdatagroup *dat, const double *pi,
+                          double *c1, double *c2, int *n1, int *n2) {
+    int v;
+    double c;
+
+    *c1 = *c2 = ALPHA_BIG;
+    *n1 = *n2 = -1;
+    for (v = 1; v < ncount; v++) {
+        c = ALPHA_COST(CCutil_dat_edgelen(0, v, dat), pi, 0, v);
+        if (c < *c1) {
+            *c2 = *c1;
+            *n2 = *n1;
+            *c1 = c;
+            *n1 = v;
+        } else if (c < *c2) {
+            *c2 = c;
+            *n2 = v;
+        }
+    }
+}
+
+/* Keeps the k smallest (alpha, cost) in topa, topc with their ends in tope */
+static void top_add(int k, double *topa, double *topc, int *tope, double a,
+                    double c, int e) {
+    int i = k - 1;
+
+    if (a > topa[i] || (a == topa[i] && c >= topc[i]))
+        return;
+    while (i > 0 && (topa[i - 1] > a || (topa[i - 1] == a && topc[i - 1] > c))) {
+        topa[i] = topa[i - 1];
+        topc[i] = topc[i - 1];
+        tope[i] = tope[i - 1];
+        i--;
+    }
+    topa[i] = a;
+    topc[i] = c;
+    tope[i] = e;
+}
@@ -28,15 +28,22 @@
 /*    EXPORTED FUNCTIONS:                                                   */
 /*                                                                          */
 /*  int CCheldkarp_small (int ncount, CCdatagroup *dat, double *upbound,    */
-/*      double *optval, int *foundtour, int anytour, int *tour_elist,       */
-/*      int nodelimit, int silent)                                          */
+/*      double *optval, double *lowbound, int *foundtour, int anytour,      */
+/*      int *tour_elist, int nodelimit, int silent,                         */
+/*      const CCheldkarp_config *cfg)                                       */
 /*    -ncount is the number of nodes in the graph.                          */
 /*    -dat specifies the information needed to compute the edge lengths.    */
 /*    -upbound is an upperbound on the optimal tour length (it can be       */
 /*     NULL)                                                                */
 /*    -optval returns the length of an optimal tour (or the upperbound      */
 /*     if no better tour is found, or the value of the first tour found     */
-/*     that it better than upbound if anytour = 1 is specified)             */
+/*     that it better than upbound if anytour = 1 is specified, or the      */
+/*     best value so far if a limit stopped the search); it is set on       */
+/*     every return, to upbound (or -1 with no upbound) on failure          */
+/*    -lowbound returns a lower bound on the optimal tour length: the       */
+/*     optimal value itself, or if a limit stopped the search the least     */
+/*     bound of the subproblems it left open; -1 if the search stopped      */
+/*     before the root bound was computed, or failed (can be NULL)          */
 /*    -foundtour will be set to 1 if a tour better than upbound is found    */
 /*    -anytour should be set to 1 to cut off the search after any tour      */
 /*     better than upbound is found (it may not be an optimal tour)         */
@@ -44,37 +51,155 @@
 /*     format; if not NULL then it should point to an array of length       */
 /*     at least 2*ncount.  Can be NULL.                                     */
 /*    -nodelimit specifies a limit on the number of search nodes (use -1    */
-/*     to impose no limit)                                                  */
+/*     to impose no limit); returns HELDKARP_SEARCHLIMITEXCEEDED if it,     */
+/*     or the time bound of cfg, is reached                                 */
 /*    -silent should be set to 1 to restrict the output and 2 to            */
 /*     disable all normal output                                            */
+/*    -cfg sets the number of search threads, the node selection and a      */
+/*     time bound (NULL for the defaults of CCheldkarp_init_config).        */
+/*     Idle threads take open subproblems from a shared pool that busy      */
+/*     ones refill, and a tour found by any thread prunes the others at     */
+/*     once; the optimal value is the same for any number of threads,      */
+/*     the tour may differ.  CC_HK_BEST_FIRST takes the open subproblem     */
+/*     with the least bound next, and dives depth-first while the pool      */
+/*     holds pool_memory bytes.                                             */
 /*                                                                          */
 /*  int CCheldkarp_small_elist (int ncount, int ecount, int *elist,         */
-/*      int *elen, int *upbound, int *optval, int *foundtour,               */
-/*      int anytour, int *tour_elist, int nodelimit, int silent)            */
+/*      int *elen, double *upbound, double *optval, double *lowbound,       */
+/*      int *foundtour, int anytour, int *tour_elist, int nodelimit,        */
+/*      int silent, const CCheldkarp_config *cfg)                           */
 /*     USES edgelist rather than datagroup.                                 */
 /*      -ecount is the number of edges in the graph.                        */
 /*      -elist is the list of edges in end0 end1 format.                    */
 /*      -elen is a list of the edge lengths.                                */
 /*                                                                          */
-/*    NOTES: The upperbound will be converted to an int.                    */
-/*           Graph can have at most MAX_NODES with edge lengths no greater  */
-/*           than  WEIGHT_MAX_EDGE                                          */
+/*  void CCheldkarp_init_config (CCheldkarp_config *cfg)                    */
+/*    SETS cfg to one depth-first search thread, no time bound and 256 MB   */
+/*     for the best-first pool.                                             */
+/*                                                                          */
+/*  int CCtsp_hk (const unsigned int *distarr, unsigned int *route,        */
+/*      unsigned int ncount, int nodelimit, double *lowbound,               */
+/*      const CCheldkarp_config *cfg)                                       */
+/*    SOLVES the instance given by the lower-triangular distarr exactly     */
+/*     and returns the tour length (-1 on failure, CC_HK_TOUR_TOO_LONG if   */
+/*     it does not fit in an int), the tour in route.                       */
+/*    A short Lin-Kernighan run gives the upper bound the branch-and-bound  */
+/*     starts from; if Held-Karp finds nothing shorter, the LK tour is      */
+/*     optimal and is the one returned.  Instances where ncount times the   */
+/*     longest edge passes INT_MAX skip the LK run.                         */
+/*    If nodelimit or the time bound of cfg (which also covers the LK       */
+/*     run) stops the search, the best tour found is returned and           */
+/*     lowbound (if not NULL) tells how far from optimal it can be, or is   */
+/*     -1 if the search stopped before it computed any bound.  A search     */
+/*     stopped before any tour, with no LK tour to fall back on, returns    */
+/*     the tour 0, 1, ..., ncount-1.                                        */
+/*                                                                          */
+/*  int CCtsp_hk_bound (const unsigned int *distarr, unsigned int ncount,   */
+/*      double *lowbound)                                                   */
+/*    RETURNS in lowbound a Held-Karp lower bound on every tour of the      */
+/*     lower-triangular distarr, with no search: CCheldkarp_sparse_bound    */
+/*     on the LK candidate edges, so it scales to large instances.          */
+/*                                                                          */
+/*    NOTES: The upperbound will be converted to an integer.                */
+/*           Bounds are computed in 64-bit fixed point, so the search       */
+/*           takes any int edge lengths and the node count is limited only  */
+/*           by the (ncount-1)^2 adjacency matrix; but CCtsp_hk returns an  */
+/*           int, so it fails with CC_HK_TOUR_TOO_LONG when the tour it     */
+/*           finds is longer than INT_MAX.                                  */
 /*           The code was designed for problems in the range of 25 to 35    */
 /*           nodes.                                                         */
 /*                                                                          */
 /****************************************************************************/
 
 #include "heldkarp.h"
+#include "linkern.h"
 #include "machdefs.h"
 #include "macrorus.h"
 
 #define LINE_LEN (75)
 
-#define MAX_NODES (100)
 #define WEIGHT_ADJUST (5)
 #define WEIGHT_MULT (1 << WEIGHT_ADJUST)
-#define WEIGHT_MAX_EDGE (1 << (20 - WEIGHT_ADJUST)) /* no overflow */
-#define WEIGHT_MAX_NODE (1 << 21)
+#define WEIGHT_MAX_NODE ((hkweight)INT_MAX << (WEIGHT_ADJUST + 1))
+#define HKWEIGHT_MAX ((hkweight)(~0ULL >> 1))
+
+#define HK_MAX_THREADS (64)
+#define HK_THREAD_NODES (20) /* smaller searches run on one thread */
+
+#define SEED_MIN_NODES (8) /* smaller instances skip the LK upper bound */
+#define SEED_STALL (100)   /* kicks without improvement in the LK run */
+
+/* Edge lengths scaled by WEIGHT_MULT, node weights and tree lengths.  */
+/* An edge is at most INT_MAX * WEIGHT_MULT and a node weight at most  */
+/* twice that, so sums over millions of nodes cannot overflow.         */
+typedef long long hkweight;
+
+/* Scratch space for Prim's algorithm, one entry per node. */
+typedef struct spanwork {
+    int *nremain;
+    int *nedge;
+    hkweight *nlen;
+} spanwork;
+
+/* An open subproblem: the branching decisions from the root and the */
+/* node weights to start the subgradient from.                       */
+typedef struct hktask {
+    int depth;
+    hkweight bound; /* lower bound of the parent */
+    int *path;
+    hkweight *y;
+} hktask;
+
+/* What the workers of one search share; everything that changes is */
+/* guarded by lock.                                                  */
+typedef struct hksearch {
+    int ncount;
+    int ecount;
+    int *elist;
+    int *elen;
+    hkweight *len;
+    int *padjlist; /* adjacency of the root, node 0 deleted */
+    int *zadjlist;
+    int nthreads;
+    int nodelimit;
+    int just_verify;
+    int silent;
+    int best_first;
+    double pool_memory;
+    double deadline; /* CCutil_mono_zeit, 0 for none */
+    hkweight upperbound;
+    int foundtour;
+    int *besttour;
+    int bbcount;
+    int stop;          /* a limit was hit, or just_verify found a tour */
+    int limited;       /* a node or time limit was hit */
+    hkweight lowbound; /* least bound of the subtrees a limit left open */
+    hktask **pool;     /* open subproblems */
+    int npool;
+    int poolspace;
+    double poolbytes;
+    int busy; /* workers holding a task */
+#ifdef CC_POSIXTHREADS
+    pthread_mutex_t lock;
+    pthread_cond_t wake;
+#endif
+} hksearch;
+
+/* One search thread, with its own fixings and weights. */
+typedef struct hkworker {
+    hksearch *s;
+    int **adjlist;
+    int *padjlist;
+    int *zadjlist;
+    hkweight *y;
+    int *deg;
+    int *tree;
+    int *besttour;
+    int *efix;
+    int *degfix;
+    int *path; /* decisions on the way to the current node */
+    spanwork sw;
+} hkworker;
 
 typedef struct treenode {
     int deg;
@@ -86,73 +211,209 @@ typedef struct treenode {
     int parentlen;
 } treenode;
 
-static void initial_y(int ncount, int ecount, int *elist, int *len, int *y),
-    hk_work(int ncount, int *elist, int *elen, int *len, int **adjlist,
-            int *zadjlist, int *y, int *deg, int *upperbound, int *tree,
-            int *foundtour, int *besttour, int *efix, int *degfix, int depth,
-            int *bbcount, int just_verify, int silent, int nodelimit),
-    held_karp_bound(int ncount, int *elist, int *elen, int *len, int **adjlist,
-                    int *zadjlist, int *y, int *deg, int upperbound, int *tree,
-                    int *val, int *newtour, int *besttour, int maxiter,
+static void no_results(double *upbound, double *optval, double *lowbound),
+    initial_y(int ncount, int ecount, int *elist, hkweight *len,
+              hkweight *y),
+    init_search(hksearch *s), free_search(hksearch *s),
+    lock_search(hksearch *s), unlock_search(hksearch *s),
+    free_task(hktask *t), free_worker(hkworker *w),
+    load_task(hkworker *w, hktask *t),
+    left_open(hksearch *s, hkweight bound),
+    new_tour(hksearch *s, hkweight val, int *tour),
+    hk_work(hkworker *w, int depth, hkweight bound),
+    held_karp_bound(int ncount, int *elist, int *elen, hkweight *len,
+                    int **adjlist, int *zadjlist, hkweight *y, int *deg,
+                    hkweight upperbound, int *tree, hkweight *val,
+                    int *newtour, int *besttour, spanwork *sw, int maxiter,
                     double beta, int silent),
-    one_tree(int ncount, int *elist, int *len, int **adjlist, int *zadjlist,
-             int *y, int *tree, int *notree),
-    span_tree(int nnodes, int **adjlist, int elen[], int y[], int sptree[],
-              int *notree),
-    edge_select(int ncount, int *elist, int *len, int *y, int *tree, int *efix,
-                int *ebranch),
+    one_tree(int ncount, int *elist, hkweight *len, int **adjlist,
+             int *zadjlist, hkweight *y, int *tree, spanwork *sw,
+             int *notree),
+    span_tree(int nnodes, int **adjlist, hkweight elen[], hkweight y[],
+              int sptree[], spanwork *sw, int *notree),
+    edge_select(int ncount, int *elist, hkweight *len, hkweight *y, int *tree,
+                int *efix, int *ebranch),
     set_adjlist(int n0, int n1, int **adjlist, int *zadjlist, int val);
 
-static int run_hk(unsigned int ncount, CCdatagroup *dat, int *hk_tour),
+static int hk_threads(int ncount, int nthreads),
+    init_worker(hkworker *w, hksearch *s),
+    task_before(hksearch *s, hktask *a, hktask *b),
+    push_task(hksearch *s, hktask *t),
+    give_task(hkworker *w, int depth, int d, hkweight bound, int room),
+    enter_node(hksearch *s, hkweight *upperbound),
+    stopped(hksearch *s);
+static double task_bytes(int ncount, int depth);
+static hkweight current_bound(hksearch *s);
+static hktask *new_task(int ncount, int depth, hkweight bound),
+    *pop_task(hksearch *s),
+    *take_task(hksearch *s, hktask *done);
+static void *hk_thread(void *arg);
+
+static int run_hk(unsigned int ncount, CCdatagroup *dat, int upbound,
+                  int nodelimit, const CCheldkarp_config *cfg, int *hk_tour,
+                  int *hk_found, double *lowbound),
+    lk_upbound(const unsigned int *distarr, unsigned int ncount,
+               double time_bound, unsigned int *route),
+    lk_fits(const unsigned int *distarr, unsigned int ncount),
     CCutil_get_bestlen(unsigned int ncount, CCdatagroup *dat, int *perm,
-                       int *tour, int *len);
+                       int *tour, long long *len);
 
 int CCtsp_hk(const unsigned int *distarr, unsigned int *route,
-             unsigned int ncount) {
+             unsigned int ncount, int nodelimit, double *lowbound,
+             const CCheldkarp_config *cfg) {
     int rval = 0;
     int i;
     CCdatagroup dat;
     int *ptour = (int *)NULL;
     int *besttour = (int *)NULL;
-    int bestlen = 0;
+    unsigned int *lktour = (unsigned int *)NULL;
+    int lklen = -1, hk_found = 1;
+    long long bestlen = 0;
+    double lb = -1.0, starttime = CCutil_mono_zeit();
+    CCheldkarp_config hcfg;
+
+    /* Below 3 nodes there is one tour and nothing to bound or branch on */
+    if (ncount < 3) {
+        for (i = 0; i < (int)ncount; i++)
+            route[i] = (unsigned int)i;
+        bestlen = (ncount == 2) ? 2 * (long long)distarr[1] : 0;
+        if (bestlen > INT_MAX)
+            return CC_HK_TOUR_TOO_LONG;
+        if (lowbound)
+            *lowbound = (double)bestlen;
+        return (int)bestlen;
+    }
+
+    if (cfg == (const CCheldkarp_config *)NULL)
+        CCheldkarp_init_config(&hcfg);
+    else
+        hcfg = *cfg;
     CCutil_init_datagroup(&dat);
     rval = CCutil_receive_distarr(distarr, ncount, &dat);
     CCcheck_rval(rval, "CCutil_receive_distarr failed");
     besttour = CC_SAFE_MALLOC(ncount, int);
     CCcheck_NULL(besttour, "out of memory for besttour");
-    rval = run_hk(ncount, &dat, besttour);
+    if (ncount >= SEED_MIN_NODES && lk_fits(distarr, ncount)) {
+        lktour = CC_SAFE_MALLOC(ncount, unsigned int);
+        CCcheck_NULL(lktour, "out of memory for lktour");
+        lklen = lk_upbound(distarr, ncount, hcfg.time_bound, lktour);
+    }
+
+    /* The bound covers the whole call, so charge the LK run against it */
+    if (hcfg.time_bound > 0.0) {
+        hcfg.time_bound -= CCutil_mono_zeit() - starttime;
+        if (hcfg.time_bound <= 0.0)
+            hcfg.time_bound = 1e-9;
+    }
+    rval = run_hk(ncount, &dat, lklen, nodelimit, &hcfg, besttour, &hk_found,
+                  &lb);
     CCcheck_rval(rval, "run_hk failed");
+    /* A limit may stop the search before any tour; fall back to the LK */
+    /* tour, or to the identity tour when there was no LK run           */
+    if (!hk_found) {
+        for (i = 0; i < ncount; i++)
+            besttour[i] = (lklen < 0) ? i : (int)lktour[i];
+    }
     ptour = CC_SAFE_MALLOC(ncount, int);
     CCcheck_NULL(ptour, "out of memory for ptour");
     for (i = 0; i < ncount; i++)
         ptour[i] = i;
     rval = CCutil_get_bestlen(ncount, &dat, ptour, besttour, &bestlen);
     CCcheck_rval(rval, "CCutil_get_bestlen failed");
+    if (bestlen > INT_MAX) {
+        fprintf(stderr, "tour length %lld does not fit in an int\n", bestlen);
+        rval = CC_HK_TOUR_TOO_LONG;
+        goto CLEANUP;
+    }
     for (int i = 0; i < ncount; i++) {
         route[i] = (unsigned int)besttour[i];
     }
-    goto CLEANUP;
+    if (lowbound)
+        *lowbound = lb;
 
 CLEANUP:
-    if (rval) {
+    CC_IFFREE(besttour, int);
+    CC_IFFREE(lktour, unsigned int);
+    CC_IFFREE(ptour, int);
+    CCutil_freedatagroup(&dat);
+    if (rval == CC_HK_TOUR_TOO_LONG) {
+        return rval;
+    } else if (rval) {
         return -1;
     } else {
-        return bestlen;
+        return (int)bestlen;
+    }
+}
+
+int CCtsp_hk_bound(const unsigned int *distarr, unsigned int ncount,
+                   double *lowbound) {
+    int rval = 0;
+    int ecount = 0;
+    int *elist = (int *)NULL;
+    CCdatagroup dat;
+
+    CCutil_init_datagroup(&dat);
+    rval = CCutil_receive_distarr(distarr, ncount, &dat);
+    CCcheck_rval(rval, "CCutil_receive_distarr failed");
+    rval = CCtsp_lk_candidates(distarr, ncount, &ecount, &elist);
+    CCcheck_rval(rval, "CCtsp_lk_candidates failed");
+    rval = CCheldkarp_sparse_bound(ncount, &dat, ecount, elist, lowbound, 1);
+    CCcheck_rval(rval, "CCheldkarp_sparse_bound failed");
+
+CLEANUP:
+    CCtsp_lk_free_candidates(elist);
+    CCutil_freedatagroup(&dat);
+    return rval;
+}
+
+/* The length of a quick LK tour, or -1 if LK failed (there is then no */
+/* bound, and Held-Karp has to find a tour on its own).                */
+
+static int lk_upbound(const unsigned int *distarr, unsigned int ncount,
+                      double time_bound, unsigned int *route) {
+    CCtsp_lkconfig cfg;
+
+    CCtsp_init_lkconfig(&cfg);
+    cfg.time_bound = time_bound;
+    return CCtsp_lk(distarr, route, ncount, SEED_STALL, -1.0, &cfg);
+}
+
+/* LK keeps tour lengths in an int, so it only seeds instances where no */
+/* tour can pass INT_MAX; Held-Karp itself works in 64 bits.            */
+
+static int lk_fits(const unsigned int *distarr, unsigned int ncount) {
+    size_t i, n = (size_t)ncount * (ncount + 1) / 2;
+    unsigned int maxedge = 0;
+
+    for (i = 0; i < n; i++) {
+        if (distarr[i] > maxedge)
+            maxedge = distarr[i];
     }
+    return (double)ncount * (double)maxedge <= (double)INT_MAX;
 }
 
-static int run_hk(unsigned int ncount, CCdatagroup *dat, int *hk_tour) {
-    double hk_val;
-    int hk_found, hk_yesno;
+/* upbound < 0 means no bound; hk_tour is only set if hk_found.  A */
+/* search cut short by a limit is not an error.                   */
+
+static int run_hk(unsigned int ncount, CCdatagroup *dat, int upbound,
+                  int nodelimit, const CCheldkarp_config *cfg, int *hk_tour,
+                  int *hk_found, double *lowbound) {
+    double hk_val, ub = (double)upbound;
+    int hk_yesno;
     int *hk_tlist = (int *)NULL;
     int rval = 0;
 
     hk_tlist = CC_SAFE_MALLOC(2 * ncount, int);
     CCcheck_NULL(hk_tlist, "out of memory for hk_tlist");
 
-    rval = CCheldkarp_small(ncount, dat, (double *)NULL, &hk_val, &hk_found, 0,
-                            hk_tlist, 100000000, 2);
+    rval = CCheldkarp_small(ncount, dat, upbound < 0 ? (double *)NULL : &ub,
+                            &hk_val, lowbound, hk_found, 0, hk_tlist,
+                            nodelimit, 2, cfg);
+    if (rval == HELDKARP_SEARCHLIMITEXCEEDED)
+        rval = 0;
     CCcheck_rval(rval, "CCheldkarp_small failed");
+    if (!*hk_found)
+        goto CLEANUP;
 
     rval = CCutil_edge_to_cycle(ncount, hk_tlist, &hk_yesno, hk_tour);
     CCcheck_rval(rval, "CCutil_edge_to_cycle failed");
@@ -169,7 +430,7 @@ CLEANUP:
 }
 
 static int CCutil_get_bestlen(unsigned int ncount, CCdatagroup *dat, int *perm,
-                              int *tour, int *len) {
+                              int *tour, long long *len) {
     int *cyc = (int *)NULL;
     int i;
     int rval = 0;
@@ -218,16 +479,25 @@ CLEANUP:
 }
 
 int CCheldkarp_small(int ncount, CCdatagroup *dat, double *upbound,
-                     double *optval, int *foundtour, int anytour,
-                     int *tour_elist, int nodelimit, int silent) {
+                     double *optval, double *lowbound, int *foundtour,
+                     int anytour, int *tour_elist, int nodelimit, int silent,
+                     const CCheldkarp_config *cfg) {
     int rval = 0;
-    int i, j, k, ecount;
+    int i, j, ecount;
+    size_t k, ecount_l;
     int *elist = (int *)NULL;
     int *elen = (int *)NULL;
 
-    ecount = ncount * (ncount - 1) / 2;
-    elist = CC_SAFE_MALLOC(ecount * 2, int);
-    elen = CC_SAFE_MALLOC(ecount, int);
+    no_results(upbound, optval, lowbound);
+    ecount_l = (size_t)ncount * (size_t)(ncount - 1) / 2;
+    if (ecount_l > (size_t)INT_MAX) {
+        fprintf(stderr, "too many edges for CCheldkarp_small\n");
+        rval = HELDKARP_ERROR;
+        goto CLEANUP;
+    }
+    ecount = (int)ecount_l;
+    elist = CC_SAFE_MALLOC(2 * ecount_l, int);
+    elen = CC_SAFE_MALLOC(ecount_l, int);
     if (elist == (int *)NULL || elen == (int *)NULL) {
         fprintf(stderr, "out of memory in CCheldkarp_small\n");
         rval = HELDKARP_ERROR;
@@ -243,8 +513,8 @@ int CCheldkarp_small(int ncount, CCdatagroup *dat, double *upbound,
     }
 
     rval = CCheldkarp_small_elist(ncount, ecount, elist, elen, upbound, optval,
-                                  foundtour, anytour, tour_elist, nodelimit,
-                                  silent);
+                                  lowbound, foundtour, anytour, tour_elist,
+                                  nodelimit, silent, cfg);
 
 CLEANUP:
 
@@ -261,147 +531,179 @@ CLEANUP:
  */
 
 int CCheldkarp_small_elist(int ncount, int ecount, int *elist, int *elen,
-                           double *upbound, double *optval, int *foundtour,
-                           int anytour, int *tour_elist, int nodelimit,
-                           int silent) {
+                           double *upbound, double *optval, double *lowbound,
+                           int *foundtour, int anytour, int *tour_elist,
+                           int nodelimit, int silent,
+                           const CCheldkarp_config *cfg) {
     int rval = 0;
-    int bbcount = 0;
-    int init_ub = ncount * WEIGHT_MAX_EDGE + 1;
-    int n1, n2, i, upperbound, val;
-    int *p;
+    int n1, n2, i, k, nworkers = 0;
     int **adjlist = (int **)NULL;
-    int *padjlist = (int *)NULL;
-    int *zadjlist = (int *)NULL;
-    int *degfix = (int *)NULL;
-    int *tree = (int *)NULL;
-    int *efix = (int *)NULL;
-    int *len = (int *)NULL;
-    int *deg = (int *)NULL;
-    int *y = (int *)NULL;
-    int *besttour = (int *)NULL;
+    hkworker *workers = (hkworker *)NULL;
+    hktask *root = (hktask *)NULL;
+    hksearch s;
+    CCheldkarp_config defaults;
 
     *foundtour = 0;
+    no_results(upbound, optval, lowbound);
+
+    if (cfg == (const CCheldkarp_config *)NULL) {
+        CCheldkarp_init_config(&defaults);
+        cfg = &defaults;
+    }
+    init_search(&s);
+    s.ncount = ncount;
+    s.ecount = ecount;
+    s.elist = elist;
+    s.elen = elen;
+    s.nodelimit = nodelimit;
+    s.just_verify = anytour;
+    s.silent = silent;
+    s.nthreads = hk_threads(ncount, cfg->nthreads);
+    s.best_first = (cfg->nodesel == CC_HK_BEST_FIRST);
+    s.pool_memory = cfg->pool_memory;
+    if (cfg->time_bound > 0.0)
+        s.deadline = CCutil_mono_zeit() + cfg->time_bound;
 
     if (upbound)
-        upperbound = (int)(*upbound);
+        s.upperbound = (hkweight)(*upbound);
     else
-        upperbound = init_ub;
-
-    val = upperbound;
-
-    if (ncount > MAX_NODES) {
-        fprintf(stderr, "too many nodes\n");
-        rval = HELDKARP_ERROR;
-        goto CLEANUP;
-    }
-    for (i = 0; i < ecount; i++) {
-        if (elen[i] > WEIGHT_MAX_EDGE || -elen[i] > WEIGHT_MAX_EDGE) {
-            fprintf(stderr, "edge too long\n");
-            rval = HELDKARP_ERROR;
-            goto CLEANUP;
-        }
-    }
+        s.upperbound = (hkweight)ncount * INT_MAX + 1;
 
     /* build adjlist for graph with node 0 deleted */
 
     adjlist = CC_SAFE_MALLOC(ncount - 1, int *);
-    padjlist = CC_SAFE_MALLOC((ncount - 1) * (ncount - 1), int);
-    zadjlist = CC_SAFE_MALLOC(ncount, int);
-    len = CC_SAFE_MALLOC(ecount, int);
-    if (adjlist == (int **)NULL || padjlist == (int *)NULL ||
-        zadjlist == (int *)NULL || len == (int *)NULL) {
+    s.padjlist =
+        CC_SAFE_MALLOC((size_t)(ncount - 1) * (size_t)(ncount - 1), int);
+    s.zadjlist = CC_SAFE_MALLOC(ncount, int);
+    s.len = CC_SAFE_MALLOC(ecount, hkweight);
+    s.besttour = CC_SAFE_MALLOC(ncount, int);
+    if (adjlist == (int **)NULL || s.padjlist == (int *)NULL ||
+        s.zadjlist == (int *)NULL || s.len == (hkweight *)NULL ||
+        s.besttour == (int *)NULL) {
         fprintf(stderr, "out of memory in tiny_heldkarp\n");
         rval = HELDKARP_ERROR;
         goto CLEANUP;
     }
-    for (i = 0, p = padjlist; i < ncount - 1; i++, p += (ncount - 1)) {
-        adjlist[i] = p;
+    for (i = 0; i < ncount - 1; i++) {
+        adjlist[i] = s.padjlist + (size_t)i * (size_t)(ncount - 1);
     }
-    for (i = 0; i < (ncount - 1) * (ncount - 1); i++)
-        padjlist[i] = 0;
+    memset(s.padjlist, 0,
+           (size_t)(ncount - 1) * (size_t)(ncount - 1) * sizeof(int));
     for (i = 0; i < ncount; i++)
-        zadjlist[i] = 0;
+        s.zadjlist[i] = 0;
 
     /* fill in edge # in adj list; 0 stands for no edge; i+1 <-> edge i */
 
     for (i = 0; i < ecount; i++) {
-        len[i] = (elen[i] << WEIGHT_ADJUST);
+        s.len[i] = (hkweight)elen[i] * WEIGHT_MULT;
         n1 = elist[2 * i];
         n2 = elist[2 * i + 1];
         if (n1 == 0) {
-            zadjlist[n2] = i + 1;
+            s.zadjlist[n2] = i + 1;
         } else if (n2 == 0) {
-            zadjlist[n1] = i + 1;
+            s.zadjlist[n1] = i + 1;
         } else {
             adjlist[n1 - 1][n2 - 1] = adjlist[n2 - 1][n1 - 1] = i + 1;
         }
     }
 
-    tree = CC_SAFE_MALLOC(ncount, int);
-    y = CC_SAFE_MALLOC(ncount, int);
-    deg = CC_SAFE_MALLOC(ncount, int);
-    besttour = CC_SAFE_MALLOC(ncount, int);
-    if (tree == (int *)NULL || y == (int *)NULL || deg == (int *)NULL ||
-        besttour == (int *)NULL) {
+    root = new_task(ncount, 0, -HKWEIGHT_MAX);
+    if (root == (hktask *)NULL || push_task(&s, root)) {
         fprintf(stderr, "out of memory in tiny_heldkarp\n");
+        if (root)
+            free_task(root);
         rval = HELDKARP_ERROR;
         goto CLEANUP;
     }
-    initial_y(ncount, ecount, elist, len, y);
+    initial_y(ncount, ecount, elist, s.len, root->y);
 
-    efix = CC_SAFE_MALLOC(ecount, int);
-    degfix = CC_SAFE_MALLOC(ncount, int);
-    if (efix == (int *)NULL || degfix == (int *)NULL) {
+    workers = CC_SAFE_MALLOC(s.nthreads, hkworker);
+    if (workers == (hkworker *)NULL) {
         fprintf(stderr, "out of memory in tiny_heldkarp\n");
         rval = HELDKARP_ERROR;
         goto CLEANUP;
     }
-    for (i = 0; i < ecount; i++)
-        efix[i] = 0;
-    for (i = 0; i < ncount; i++)
-        degfix[i] = 0;
+    for (k = 0; k < s.nthreads; k++) {
+        if (init_worker(&workers[k], &s)) {
+            if (k == 0) {
+                fprintf(stderr, "out of memory in tiny_heldkarp\n");
+                rval = HELDKARP_ERROR;
+                goto CLEANUP;
+            }
+            break;
+        }
+        nworkers++;
+    }
 
-    hk_work(ncount, elist, elen, len, adjlist, zadjlist, y, deg, &val, tree,
-            foundtour, besttour, efix, degfix, 0, &bbcount, anytour, silent,
-            nodelimit);
+    /* A worker without a thread runs once the pool has drained: a no-op */
+    CCutil_run_workers(workers, sizeof(hkworker), nworkers, hk_thread);
     if (silent < 2) {
-        printf("BBnodes: %d\n", bbcount);
+        printf("BBnodes: %d\n", s.bbcount);
         fflush(stdout);
     }
 
-    if (nodelimit != -1 && bbcount > nodelimit) {
+    *optval = (double)s.upperbound;
+    if (s.limited) {
         rval = HELDKARP_SEARCHLIMITEXCEEDED;
-    } else {
-        *optval = (double)val;
+        for (i = 0; i < s.npool; i++) {
+            if (s.pool[i]->bound < s.lowbound)
+                s.lowbound = s.pool[i]->bound;
+        }
+        /* The root, still open with its -HKWEIGHT_MAX, means no bound */
+        if (lowbound && s.lowbound > -HKWEIGHT_MAX) {
+            *lowbound = (double)(s.lowbound < s.upperbound ? s.lowbound
+                                                           : s.upperbound);
+        }
+    } else if (lowbound) {
+        *lowbound = (double)s.upperbound;
     }
 
+    *foundtour = s.foundtour;
     if (*foundtour && tour_elist) {
         for (i = 0; i < ncount; i++) {
-            tour_elist[2 * i] = elist[2 * besttour[i]];
-            tour_elist[2 * i + 1] = elist[2 * besttour[i] + 1];
+            tour_elist[2 * i] = elist[2 * s.besttour[i]];
+            tour_elist[2 * i + 1] = elist[2 * s.besttour[i] + 1];
         }
     }
 
 CLEANUP:
 
+    if (workers) {
+        for (k = 0; k < nworkers; k++)
+            free_worker(&workers[k]);
+        CC_FREE(workers, hkworker);
+    }
+    for (i = 0; i < s.npool; i++)
+        free_task(s.pool[i]);
     CC_IFFREE(adjlist, int *);
-    CC_IFFREE(padjlist, int);
-    CC_IFFREE(zadjlist, int);
-    CC_IFFREE(degfix, int);
-    CC_IFFREE(tree, int);
-    CC_IFFREE(efix, int);
-    CC_IFFREE(len, int);
-    CC_IFFREE(deg, int);
-    CC_IFFREE(y, int);
-    CC_IFFREE(besttour, int);
+    CC_IFFREE(s.padjlist, int);
+    CC_IFFREE(s.zadjlist, int);
+    CC_IFFREE(s.len, hkweight);
+    CC_IFFREE(s.besttour, int);
+    free_search(&s);
     return rval;
 }
 
-static void initial_y(int ncount, int ecount, int *elist, int *len, int *y) {
+/* What CCheldkarp_small reports until its search has a result */
+static void no_results(double *upbound, double *optval, double *lowbound) {
+    *optval = (upbound != (double *)NULL) ? *upbound : -1.0;
+    if (lowbound)
+        *lowbound = -1.0;
+}
+
+void CCheldkarp_init_config(CCheldkarp_config *cfg) {
+    cfg->nthreads = 1;
+    cfg->nodesel = CC_HK_DEPTH_FIRST;
+    cfg->time_bound = -1.0;
+    cfg->pool_memory = 256.0 * 1024.0 * 1024.0;
+}
+
+static void initial_y(int ncount, int ecount, int *elist, hkweight *len,
+                      hkweight *y) {
     int i;
 
     for (i = 0; i < ncount; i++)
-        y[i] = INT_MAX;
+        y[i] = HKWEIGHT_MAX;
     for (i = 0; i < ecount; i++) {
         if (len[i] < y[elist[2 * i]])
             y[elist[2 * i]] = len[i];
@@ -413,87 +715,470 @@ static void initial_y(int ncount, int ecount, int *elist, int *len, int *y) {
     }
 }
 
-static void hk_work(int ncount, int *elist, int *elen, int *len, int **adjlist,
-                    int *zadjlist, int *y, int *deg, int *upperbound, int *tree,
-                    int *foundtour, int *besttour, int *efix, int *degfix,
-                    int depth, int *bbcount, int just_verify, int silent,
-                    int nodelimit) {
-    int ebranch, n0, n1, maxiter, val, newtour;
+/* Each worker keeps its own copy of the fixings and node weights; an    */
+/* open subproblem carries the branching decisions that lead to it from  */
+/* the root and the weights of its parent, so any worker can take it.    */
+
+static void init_search(hksearch *s) {
+    s->padjlist = (int *)NULL;
+    s->zadjlist = (int *)NULL;
+    s->len = (hkweight *)NULL;
+    s->besttour = (int *)NULL;
+    s->foundtour = 0;
+    s->bbcount = 0;
+    s->deadline = 0.0;
+    s->stop = 0;
+    s->limited = 0;
+    s->lowbound = HKWEIGHT_MAX;
+    s->pool = (hktask **)NULL;
+    s->npool = 0;
+    s->poolspace = 0;
+    s->poolbytes = 0.0;
+    s->busy = 0;
+#ifdef CC_POSIXTHREADS
+    pthread_mutex_init(&s->lock, NULL);
+    pthread_cond_init(&s->wake, NULL);
+#endif
+}
+
+static void free_search(hksearch *s) {
+    CC_IFFREE(s->pool, hktask *);
+#ifdef CC_POSIXTHREADS
+    pthread_mutex_destroy(&s->lock);
+    pthread_cond_destroy(&s->wake);
+#endif
+}
+
+static void lock_search(hksearch *s) {
+#ifdef CC_POSIXTHREADS
+    pthread_mutex_lock(&s->lock);
+#else
+    (void)s;
+#endif
+}
+
+static void unlock_search(hksearch *s) {
+#ifdef CC_POSIXTHREADS
+    pthread_mutex_unlock(&s->lock);
+#else
+    (void)s;
+#endif
+}
+
+/* The bound of one node is O(ncount^2) per iteration, so a thread pays */
+/* off from a few dozen nodes on.                                       */
+static int hk_threads(int ncount, int nthreads) {
+#ifdef CC_POSIXTHREADS
+    if (nthreads == 0)
+        nthreads = CCutil_cpu_count();
+    if (nthreads > HK_MAX_THREADS)
+        nthreads = HK_MAX_THREADS;
+    if (ncount < HK_THREAD_NODES || nthreads < 1)
+        nthreads = 1;
+#else
+    (void)ncount;
+    nthreads = 1;
+#endif
+    return nthreads;
+}
+
+static hktask *new_task(int ncount, int depth, hkweight bound) {
+    hktask *t = CC_SAFE_MALLOC(1, hktask);
+
+    if (t == (hktask *)NULL)
+        return (hktask *)NULL;
+    t->depth = depth;
+    t->bound = bound;
+    t->path = (int *)NULL;
+    t->y = CC_SAFE_MALLOC(ncount, hkweight);
+    if (depth > 0)
+        t->path = CC_SAFE_MALLOC(depth, int);
+    if (t->y == (hkweight *)NULL || (depth > 0 && t->path == (int *)NULL)) {
+        free_task(t);
+        return (hktask *)NULL;
+    }
+    return t;
+}
+
+static void free_task(hktask *t) {
+    CC_IFFREE(t->y, hkweight);
+    CC_IFFREE(t->path, int);
+    CC_FREE(t, hktask);
+}
+
+static double task_bytes(int ncount, int depth) {
+    return (double)sizeof(hktask) + (double)ncount * sizeof(hkweight) +
+           (double)depth * sizeof(int);
+}
+
+/* The pool is a stack for depth-first search, and a heap on the bound */
+/* (deeper first among equals) for best-first.  Call with the lock.    */
+
+static int task_before(hksearch *s, hktask *a, hktask *b) {
+    if (!s->best_first)
+        return 0;
+    return a->bound < b->bound || (a->bound == b->bound && a->depth > b->depth);
+}
+
+static int push_task(hksearch *s, hktask *t) {
+    int i, p;
+
+    if (s->npool == s->poolspace &&
+        CCutil_reallocrus_scale((void **)&s->pool, &s->poolspace,
+                                s->npool + 1, 1.3, sizeof(hktask *))) {
+        return 1;
+    }
+    i = s->npool++;
+    if (s->best_first) {
+        for (; i > 0 && task_before(s, t, s->pool[p = (i - 1) / 2]); i = p)
+            s->pool[i] = s->pool[p];
+    }
+    s->pool[i] = t;
+    s->poolbytes += task_bytes(s->ncount, t->depth);
+#ifdef CC_POSIXTHREADS
+    pthread_cond_signal(&s->wake);
+#endif
+    return 0;
+}
+
+static hktask *pop_task(hksearch *s) {
+    hktask *t = s->pool[0], *last;
+    int i, c;
+
+    if (!s->best_first) {
+        t = s->pool[--s->npool];
+    } else {
+        last = s->pool[--s->npool];
+        for (i = 0; (c = 2 * i + 1) < s->npool; i = c) {
+            if (c + 1 < s->npool && task_before(s, s->pool[c + 1], s->pool[c]))
+                c++;
+            if (!task_before(s, s->pool[c], last))
+                break;
+            s->pool[i] = s->pool[c];
+        }
+        if (s->npool > 0)
+            s->pool[i] = last;
+    }
+    s->poolbytes -= task_bytes(s->ncount, t->depth);
+    return t;
+}
+
+static int init_worker(hkworker *w, hksearch *s) {
+    int i, ncount = s->ncount;
+
+    w->s = s;
+    w->adjlist = CC_SAFE_MALLOC(ncount - 1, int *);
+    w->padjlist =
+        CC_SAFE_MALLOC((size_t)(ncount - 1) * (size_t)(ncount - 1), int);
+    w->zadjlist = CC_SAFE_MALLOC(ncount, int);
+    w->y = CC_SAFE_MALLOC(ncount, hkweight);
+    w->deg = CC_SAFE_MALLOC(ncount, int);
+    w->tree = CC_SAFE_MALLOC(ncount, int);
+    w->besttour = CC_SAFE_MALLOC(ncount, int);
+    w->efix = CC_SAFE_MALLOC(s->ecount, int);
+    w->degfix = CC_SAFE_MALLOC(ncount, int);
+    w->path = CC_SAFE_MALLOC(s->ecount, int);
+    w->sw.nremain = CC_SAFE_MALLOC(ncount, int);
+    w->sw.nedge = CC_SAFE_MALLOC(ncount, int);
+    w->sw.nlen = CC_SAFE_MALLOC(ncount, hkweight);
+    if (w->adjlist == (int **)NULL || w->padjlist == (int *)NULL ||
+        w->zadjlist == (int *)NULL || w->y == (hkweight *)NULL ||
+        w->deg == (int *)NULL || w->tree == (int *)NULL ||
+        w->besttour == (int *)NULL || w->efix == (int *)NULL ||
+        w->degfix == (int *)NULL || w->path == (int *)NULL ||
+        w->sw.nremain == (int *)NULL || w->sw.nedge == (int *)NULL ||
+        w->sw.nlen == (hkweight *)NULL) {
+        free_worker(w);
+        return 1;
+    }
+    for (i = 0; i < ncount - 1; i++)
+        w->adjlist[i] = w->padjlist + (size_t)i * (size_t)(ncount - 1);
+    return 0;
+}
+
+static void free_worker(hkworker *w) {
+    CC_IFFREE(w->adjlist, int *);
+    CC_IFFREE(w->padjlist, int);
+    CC_IFFREE(w->zadjlist, int);
+    CC_IFFREE(w->y, hkweight);
+    CC_IFFREE(w->deg, int);
+    CC_IFFREE(w->tree, int);
+    CC_IFFREE(w->besttour, int);
+    CC_IFFREE(w->efix, int);
+    CC_IFFREE(w->degfix, int);
+    CC_IFFREE(w->path, int);
+    CC_IFFREE(w->sw.nremain, int);
+    CC_IFFREE(w->sw.nedge, int);
+    CC_IFFREE(w->sw.nlen, hkweight);
+}
+
+static void *hk_thread(void *arg) {
+    hkworker *w = (hkworker *)arg;
+    hksearch *s = w->s;
+    hktask *t = (hktask *)NULL;
+
+    while ((t = take_task(s, t)) != (hktask *)NULL) {
+        load_task(w, t);
+        hk_work(w, t->depth, t->bound);
+    }
+    return (void *)NULL;
+}
+
+/* Frees done (the task the caller has finished, or NULL) and waits for */
+/* the next open subproblem; NULL once the pool is empty and no worker  */
+/* can add to it, or the search was stopped.                            */
+static hktask *take_task(hksearch *s, hktask *done) {
+    hktask *t = (hktask *)NULL;
+
+    if (done)
+        free_task(done);
+    lock_search(s);
+    if (done)
+        s->busy--;
+    while (s->npool == 0 && s->busy > 0 && !s->stop) {
+#ifdef CC_POSIXTHREADS
+        pthread_cond_wait(&s->wake, &s->lock);
+#else
+        break;
+#endif
+    }
+    if (s->npool > 0 && !s->stop) {
+        t = pop_task(s);
+        s->busy++;
+    }
+#ifdef CC_POSIXTHREADS
+    if (t == (hktask *)NULL)
+        pthread_cond_broadcast(&s->wake);
+#endif
+    unlock_search(s);
+    return t;
+}
+
+/* Hands the child of the current node that takes decision d (see   */
+/* load_task) on to the pool; returns 1 if the worker must search   */
+/* it itself.  Unless room is set the pool only takes it if it is  */
+/* running low.                                                     */
+static int give_task(hkworker *w, int depth, int d, hkweight bound,
+                     int room) {
+    hksearch *s = w->s;
+    hktask *t;
+    int rval = 1;
+
+    lock_search(s);
+    if (room) {
+        room = (s->poolbytes + task_bytes(s->ncount, depth + 1) <=
+                s->pool_memory);
+    } else {
+        room = (s->nthreads > 1 && s->npool < s->nthreads);
+    }
+    unlock_search(s);
+    if (!room)
+        return 1;
+
+    t = new_task(s->ncount, depth + 1, bound);
+    if (t == (hktask *)NULL)
+        return 1;
+    memcpy(t->path, w->path, depth * sizeof(int));
+    t->path[depth] = d;
+    memcpy(t->y, w->y, s->ncount * sizeof(hkweight));
+    lock_search(s);
+    rval = push_task(s, t);
+    unlock_search(s);
+    if (rval)
+        free_task(t);
+    return rval;
+}
+
+/* path[i] is e+1 if edge e is fixed to 1 at depth i, -(e+1) if it is */
+/* deleted.                                                           */
+static void load_task(hkworker *w, hktask *t) {
+    hksearch *s = w->s;
+    int i, e, ncount = s->ncount;
+
+    memcpy(w->padjlist, s->padjlist,
+           (size_t)(ncount - 1) * (size_t)(ncount - 1) * sizeof(int));
+    memcpy(w->zadjlist, s->zadjlist, ncount * sizeof(int));
+    memcpy(w->y, t->y, ncount * sizeof(hkweight));
+    memset(w->efix, 0, s->ecount * sizeof(int));
+    memset(w->degfix, 0, ncount * sizeof(int));
+    for (i = 0; i < t->depth; i++) {
+        w->path[i] = t->path[i];
+        if (t->path[i] < 0) {
+            e = -t->path[i] - 1;
+            set_adjlist(s->elist[2 * e], s->elist[2 * e + 1], w->adjlist,
+                        w->zadjlist, 0);
+        } else {
+            e = t->path[i] - 1;
+            w->efix[e] = 1;
+            w->degfix[s->elist[2 * e]]++;
+            w->degfix[s->elist[2 * e + 1]]++;
+            set_adjlist(s->elist[2 * e], s->elist[2 * e + 1], w->adjlist,
+                        w->zadjlist, -(e + 1));
+        }
+    }
+}
+
+/* Counts a node and reads the current upper bound; returns 1 if the */
+/* search is over.                                                   */
+static int enter_node(hksearch *s, hkweight *upperbound) {
+    int stop;
+
+    lock_search(s);
+    s->bbcount++;
+    if (!s->stop && ((s->nodelimit != -1 && s->bbcount > s->nodelimit) ||
+                     (s->deadline > 0.0 && CCutil_mono_zeit() > s->deadline))) {
+        s->stop = 1;
+        s->limited = 1;
+    }
+    stop = s->stop;
+    *upperbound = s->upperbound;
+    unlock_search(s);
+    return stop;
+}
+
+static int stopped(hksearch *s) {
+    int stop;
+
+    lock_search(s);
+    stop = s->stop;
+    unlock_search(s);
+    return stop;
+}
+
+static hkweight current_bound(hksearch *s) {
+    hkweight upperbound;
+
+    lock_search(s);
+    upperbound = s->upperbound;
+    unlock_search(s);
+    return upperbound;
+}
+
+/* A subtree left unsearched when a limit stopped the search; bound is */
+/* a lower bound on the tours in it.                                   */
+static void left_open(hksearch *s, hkweight bound) {
+    lock_search(s);
+    if (bound < s->lowbound)
+        s->lowbound = bound;
+    unlock_search(s);
+}
+
+static void new_tour(hksearch *s, hkweight val, int *tour) {
+    int i;
+
+    lock_search(s);
+    if (val < s->upperbound) {
+        s->foundtour = 1;
+        s->upperbound = val;
+        for (i = 0; i < s->ncount; i++)
+            s->besttour[i] = tour[i];
+    }
+    if (s->just_verify)
+        s->stop = 1;
+    unlock_search(s);
+}
+
+/* bound is the lower bound of the parent, the best known for the node */
+/* until its own is computed.                                          */
+static void hk_work(hkworker *w, int depth, hkweight bound) {
+    hksearch *s = w->s;
+    int ebranch, n0, n1, maxiter, newtour, fix;
+    int show = (!s->silent && s->nthreads == 1 && depth < LINE_LEN);
+    hkweight val, upperbound;
     double beta;
 
-    (*bbcount)++;
-    if (nodelimit != -1 && *bbcount > nodelimit)
+    if (enter_node(s, &upperbound)) {
+        left_open(s, bound);
         return;
+    }
     maxiter = (depth > 0 ? 10 : 1000);
     beta = (depth > 0 ? 0.9 : 0.99);
-    held_karp_bound(ncount, elist, elen, len, adjlist, zadjlist, y, deg,
-                    *upperbound, tree, &val, &newtour, besttour, maxiter, beta,
-                    silent);
+    held_karp_bound(s->ncount, s->elist, s->elen, s->len, w->adjlist,
+                    w->zadjlist, w->y, w->deg, upperbound, w->tree, &val,
+                    &newtour, w->besttour, &w->sw, maxiter, beta, s->silent);
     if (newtour == 1) {
-        *foundtour = 1;
-        *upperbound = val;
+        new_tour(s, val, w->besttour);
         return;
     }
-    if (val >= *upperbound)
+    if (val < bound)
+        val = bound; /* the parent's bound holds for the node too */
+    if (val >= current_bound(s))
         return;
 
-    edge_select(ncount, elist, len, y, tree, efix, &ebranch);
+    edge_select(s->ncount, s->elist, s->len, w->y, w->tree, w->efix,
+                &ebranch);
     if (ebranch == -1)
         return;
-    n0 = elist[2 * ebranch];
-    n1 = elist[2 * ebranch + 1];
-    set_adjlist(n0, n1, adjlist, zadjlist, 0);
+    n0 = s->elist[2 * ebranch];
+    n1 = s->elist[2 * ebranch + 1];
+    fix = (w->degfix[n0] < 2 && w->degfix[n1] < 2);
+
+    /* Best-first hands both children to the pool while it has room, */
+    /* and dives like depth-first once it is full.                   */
+    if (s->best_first && !give_task(w, depth, -(ebranch + 1), val, 1)) {
+        if (fix && give_task(w, depth, ebranch + 1, val, 1))
+            goto ONE_BRANCH;
+        return;
+    }
+    if (fix && !give_task(w, depth, ebranch + 1, val, 0))
+        fix = 0;
 
-    if (!silent && depth < LINE_LEN) {
+    set_adjlist(n0, n1, w->adjlist, w->zadjlist, 0);
+    w->path[depth] = -(ebranch + 1);
+
+    if (show) {
         printf("0");
         fflush(stdout);
     }
-    hk_work(ncount, elist, elen, len, adjlist, zadjlist, y, deg, upperbound,
-            tree, foundtour, besttour, efix, degfix, depth + 1, bbcount,
-            just_verify, silent, nodelimit);
-    if (!silent && depth < LINE_LEN) {
+    hk_work(w, depth + 1, val);
+    if (show) {
         printf("\b \b");
         fflush(stdout);
     }
-    if (*foundtour == 1 && just_verify == 1) {
-        set_adjlist(n0, n1, adjlist, zadjlist, ebranch + 1);
+    set_adjlist(n0, n1, w->adjlist, w->zadjlist, ebranch + 1);
+    if (stopped(s)) {
+        if (fix)
+            left_open(s, val);
         return;
     }
 
-    if (degfix[n0] < 2 && degfix[n1] < 2) {
-        efix[ebranch] = 1;
-        degfix[n0]++;
-        degfix[n1]++;
-        set_adjlist(n0, n1, adjlist, zadjlist, -(ebranch + 1));
+ONE_BRANCH:
+
+    if (fix) {
+        w->efix[ebranch] = 1;
+        w->degfix[n0]++;
+        w->degfix[n1]++;
+        set_adjlist(n0, n1, w->adjlist, w->zadjlist, -(ebranch + 1));
+        w->path[depth] = ebranch + 1;
 
-        if (!silent && depth < LINE_LEN) {
+        if (show) {
             printf("1");
             fflush(stdout);
         }
-        hk_work(ncount, elist, elen, len, adjlist, zadjlist, y, deg, upperbound,
-                tree, foundtour, besttour, efix, degfix, depth + 1, bbcount,
-                just_verify, silent, nodelimit);
-        if (!silent && depth < LINE_LEN) {
+        hk_work(w, depth + 1, val);
+        if (show) {
             printf("\b \b");
             fflush(stdout);
         }
 
-        efix[ebranch] = 0;
-        degfix[n0]--;
-        degfix[n1]--;
+        w->efix[ebranch] = 0;
+        w->degfix[n0]--;
+        w->degfix[n1]--;
+        set_adjlist(n0, n1, w->adjlist, w->zadjlist, ebranch + 1);
     }
-    set_adjlist(n0, n1, adjlist, zadjlist, ebranch + 1);
 }
 
-static void held_karp_bound(int ncount, int *elist, int *elen, int *len,
-                            int **adjlist, int *zadjlist, int *y, int *deg,
-                            int upperbound, int *tree, int *val, int *newtour,
-                            int *besttour, int maxiter, double beta,
+static void held_karp_bound(int ncount, int *elist, int *elen, hkweight *len,
+                            int **adjlist, int *zadjlist, hkweight *y,
+                            int *deg, hkweight upperbound, int *tree,
+                            hkweight *val, int *newtour, int *besttour,
+                            spanwork *sw, int maxiter, double beta,
                             int silent) {
-    int i, k, t, tlen, ysum, square, notree, newsum;
-    int abound = (upperbound << WEIGHT_ADJUST);
-    int goal = ((upperbound - 1) << WEIGHT_ADJUST);
-    int bestbound = -INT_MAX;
+    int i, k, square, notree, newsum;
+    hkweight t, tlen, ysum;
+    hkweight abound = upperbound * WEIGHT_MULT;
+    hkweight goal = (upperbound - 1) * WEIGHT_MULT;
+    hkweight bestbound = -HKWEIGHT_MAX;
     int iter = 0;
     double alpha = 2.0;
 
@@ -503,9 +1188,9 @@ static void held_karp_bound(int ncount, int *elist, int *elen, int *len,
     }
 
     do {
-        one_tree(ncount, elist, len, adjlist, zadjlist, y, tree, &notree);
+        one_tree(ncount, elist, len, adjlist, zadjlist, y, tree, sw, &notree);
         if (notree == 1) {
-            *val = INT_MAX;
+            *val = HKWEIGHT_MAX;
             return;
         }
         for (i = 0, tlen = 2 * ysum; i < ncount; i++) {
@@ -534,7 +1219,7 @@ static void held_karp_bound(int ncount, int *elist, int *elen, int *len,
             for (i = 0, *val = 0; i < ncount; i++)
                 *val += elen[tree[i]];
             if (silent < 2) {
-                printf("Tour found: %d\n", *val);
+                printf("Tour found: %lld\n", *val);
                 fflush(stdout);
             }
             return;
@@ -542,7 +1227,7 @@ static void held_karp_bound(int ncount, int *elist, int *elen, int *len,
         if (++iter >= maxiter)
             break;
 
-        t = (int)(alpha * (double)((abound - tlen)) / (double)square);
+        t = (hkweight)(alpha * (double)((abound - tlen)) / (double)square);
         if (t < 2)
             break;
         alpha *= beta;
@@ -561,22 +1246,24 @@ static void held_karp_bound(int ncount, int *elist, int *elen, int *len,
         }
     } while (1);
 
-    *val = (bestbound >> WEIGHT_ADJUST);
-    if (bestbound % WEIGHT_MULT)
+    *val = bestbound / WEIGHT_MULT;
+    if (bestbound % WEIGHT_MULT > 0)
         (*val)++;
 }
 
-static void one_tree(int ncount, int *elist, int *len, int **adjlist,
-                     int *zadjlist, int *y, int *tree, int *notree) {
-    int min1, min2, emin1, emin2, i, w, e;
+static void one_tree(int ncount, int *elist, hkweight *len, int **adjlist,
+                     int *zadjlist, hkweight *y, int *tree, spanwork *sw,
+                     int *notree) {
+    int emin1, emin2, i, e;
+    hkweight min1, min2, w;
 
     *notree = 0;
-    span_tree(ncount - 1, adjlist, len, y + 1, tree, notree);
+    span_tree(ncount - 1, adjlist, len, y + 1, tree, sw, notree);
     if (*notree)
         return;
 
-    min1 = INT_MAX;
-    min2 = INT_MAX;
+    min1 = HKWEIGHT_MAX;
+    min2 = HKWEIGHT_MAX;
     emin1 = -1;
     emin2 = -1;
 
@@ -595,17 +1282,17 @@ static void one_tree(int ncount, int *elist, int *len, int **adjlist,
                 emin2 = e;
             }
         } else if (e < 0) {
-            if (min2 == -INT_MAX) {
+            if (min2 == -HKWEIGHT_MAX) {
                 *notree = 1;
                 return;
             }
             min2 = min1;
-            min1 = -INT_MAX;
+            min1 = -HKWEIGHT_MAX;
             emin2 = emin1;
             emin1 = (-e) - 1;
         }
     }
-    if (min2 == INT_MAX) {
+    if (min2 == HKWEIGHT_MAX) {
         *notree = 1;
     } else {
         tree[ncount - 2] = emin1;
@@ -613,28 +1300,27 @@ static void one_tree(int ncount, int *elist, int *len, int **adjlist,
     }
 }
 
-static void span_tree(int nnodes, int **adjlist, int elen[], int y[],
-                      int sptree[], int *notree) {
+static void span_tree(int nnodes, int **adjlist, hkweight elen[],
+                      hkweight y[], int sptree[], spanwork *sw, int *notree) {
     int nbnd, nadd, nrem;
-    int cur, minnode, i;
-    int we, e, ycur;
-    int nremain[MAX_NODES];
-    int nedge[MAX_NODES];
-    int nlen[MAX_NODES];
-    int minlen;
+    int cur, minnode, i, e;
+    hkweight we, ycur, minlen;
+    int *nremain = sw->nremain;
+    int *nedge = sw->nedge;
+    hkweight *nlen = sw->nlen;
     int *tptr;
 
     nbnd = nnodes - 1;
     for (i = 0; i < nbnd; i++) {
         nremain[i] = i + 1;
         nedge[i] = 0;
-        nlen[i] = INT_MAX;
+        nlen[i] = HKWEIGHT_MAX;
     }
     cur = 0;
     nbnd = nnodes - 1;
     nrem = nbnd;
     for (nadd = 0; nadd < nbnd; nadd++) {
-        minlen = INT_MAX;
+        minlen = HKWEIGHT_MAX;
         minnode = -1;
         ycur = y[cur];
         tptr = adjlist[cur];
@@ -648,12 +1334,12 @@ static void span_tree(int nnodes, int **adjlist, int elen[], int y[],
                     nlen[i] = we;
                 }
             } else if (e < 0) { /*  => edge is fixed */
-                if (nlen[i] == -INT_MAX) {
+                if (nlen[i] == -HKWEIGHT_MAX) {
                     *notree = 1;
                     return;
                 } else {
                     nedge[i] = -e;
-                    nlen[i] = -INT_MAX;
+                    nlen[i] = -HKWEIGHT_MAX;
                 }
             }
             if (nlen[i] < minlen) {
@@ -676,10 +1362,11 @@ static void span_tree(int nnodes, int **adjlist, int elen[], int y[],
     }
 }
 
-static void edge_select(int ncount, int *elist, int *len, int *y, int *tree,
-                        int *efix, int *ebranch) {
-    int i, e, w;
-    int min = INT_MAX;
+static void edge_select(int ncount, int *elist, hkweight *len, hkweight *y,
+                        int *tree, int *efix, int *ebranch) {
+    int i, e;
+    hkweight w;
+    hkweight min = HKWEIGHT_MAX;
     int emin = -1;
 
     for (i = 0; i < ncount; i++) {
@@ -123,7 +123,8 @@ int
     CCedgegen_x_qboruvka_tour (int ncount, CCdatagroup *dat, int *outcycle,
         double *val, int ecount, int *elist, int silent),
     CCedgegen_junk_k_nearest (int ncount, int num, CCdatagroup *dat,
-        double *wcoord, int wantlist, int *ecount, int **elist, int silent),
+        double *wcoord, int wantlist, int *ecount, int **elist, int nthreads,
+        int silent),
     CCedgegen_junk_node_k_nearest (CCdatagroup *dat, double *wcoord, int n,
         int nearnum, int ncount, int *list),
     CCedgegen_junk_node_nearest (CCdatagroup *dat, double *wcoord, int ncount,
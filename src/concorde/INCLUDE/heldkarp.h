@@ -21,13 +21,37 @@
 
 #include "util.h"
 
+#define CC_HK_DEPTH_FIRST (0)
+#define CC_HK_BEST_FIRST (1)
+
+#define CC_HK_TOUR_TOO_LONG (-2) /* CCtsp_hk: the length passes INT_MAX */
+
+typedef struct CCheldkarp_config {
+    int nthreads;       /* search threads, 0 for one per online CPU */
+    int nodesel;        /* CC_HK_DEPTH_FIRST or CC_HK_BEST_FIRST */
+    double time_bound;  /* seconds of wall clock, <= 0 for no bound */
+    double pool_memory; /* bytes of open subproblems best-first keeps */
+} CCheldkarp_config;
+
 int CCheldkarp_small(int ncount, CCdatagroup *dat, double *upbound,
-                     double *optval, int *foundtour, int anytour,
-                     int *tour_elist, int nodelimit, int silent),
+                     double *optval, double *lowbound, int *foundtour,
+                     int anytour, int *tour_elist, int nodelimit, int silent,
+                     const CCheldkarp_config *cfg),
     CCheldkarp_small_elist(int ncount, int ecount, int *elist, int *elen,
-                           double *upbound, double *optval, int *foundtour,
-                           int anytour, int *tour_elist, int nodelimit,
-                           int silent);
-int CCtsp_heldkarp(const unsigned int *distarr, unsigned int *route, unsigned int ncount);
+                           double *upbound, double *optval, double *lowbound,
+                           int *foundtour, int anytour, int *tour_elist,
+                           int nodelimit, int silent,
+                           const CCheldkarp_config *cfg);
+void CCheldkarp_init_config(CCheldkarp_config *cfg);
+int CCheldkarp_alpha_nearest(int ncount, CCdatagroup *dat, int ecount,
+                             const int *elist, int k, int *acount,
+                             int **alist, double *lowbound, int silent),
+    CCheldkarp_sparse_bound(int ncount, CCdatagroup *dat, int ecount,
+                            const int *elist, double *lowbound, int silent);
+int CCtsp_hk(const unsigned int *distarr, unsigned int *route,
+             unsigned int ncount, int nodelimit, double *lowbound,
+             const CCheldkarp_config *cfg),
+    CCtsp_hk_bound(const unsigned int *distarr, unsigned int ncount,
+                   double *lowbound);
 
 #endif /* __HELDKARP_H */
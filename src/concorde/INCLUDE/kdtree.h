@@ -0,0 +1,103 @@
+/****************************************************************************/
+/*                                                                          */
+/*  This file is part of CONCORDE                                           */
+/*                                                                          */
+/*  (c) Copyright 1995--1999 by David Applegate, Robert Bixby,              */
+/*  Vasek Chvatal, and William Cook                                         */
+/*                                                                          */
+/*  Permission is granted for academic research use.  For other uses,       */
+/*  contact the authors for licensing options.                              */
+/*                                                                          */
+/*  Use at your own risk.  We make no guarantees about the                  */
+/*  correctness or usefulness of this code.                                 */
+/*                                                                          */
+/****************************************************************************/
+
+/****************************************************************************/
+/****************************************************************************/
+/*                                                                          */
+/*                      PROTOTYPES FOR FILES IN KDTREE                      */
+/*                                                                          */
+/****************************************************************************/
+/****************************************************************************/
+
+#ifndef __KDTREE_H
+#define __KDTREE_H
+
+#include "util.h"
+
+typedef struct CCkdnode {
+    double cutval;
+    struct CCkdnode *loson, *hison, *father;
+    double bnds[4];   /* the cell: xlo, xhi, ylo, yhi */
+    int    empty;     /* every point below has been deleted */
+    int    lopt, hipt; /* bucket: the live points are perm[lopt..hipt] */
+    int    top;       /* bucket: its last point, live or deleted */
+    char   bucket;
+    char   cutdim;
+} CCkdnode;
+
+typedef struct CCkdtree {
+    CCkdnode  *root;
+    CCkdnode **bucketptr;
+    CCkdnode  *nodespace;
+    int       *perm;
+    int        nodecount;
+} CCkdtree;
+
+
+/****************************************************************************/
+/*                                                                          */
+/*                             kdbuild.c                                    */
+/*                                                                          */
+/****************************************************************************/
+
+int
+    CCkdtree_build (CCkdtree *kt, int ncount, CCdatagroup *dat,
+        CCrandstate *rstate);
+
+void
+    CCkdtree_free (CCkdtree *kt),
+    CCkdtree_delete (CCkdtree *kt, int k),
+    CCkdtree_delete_all (CCkdtree *kt, int ncount),
+    CCkdtree_undelete (CCkdtree *kt, int k),
+    CCkdtree_undelete_all (CCkdtree *kt, int ncount);
+
+
+/****************************************************************************/
+/*                                                                          */
+/*                             kdnear.c                                     */
+/*                                                                          */
+/****************************************************************************/
+
+int
+    CCkdtree_k_nearest (CCkdtree *kt, int ncount, int k, CCdatagroup *dat,
+        int *ecount, int **elist, int silent, CCrandstate *rstate),
+    CCkdtree_quadrant_k_nearest (CCkdtree *kt, int ncount, int k,
+        CCdatagroup *dat, int *ecount, int **elist, int silent,
+        CCrandstate *rstate),
+    CCkdtree_node_k_nearest (CCkdtree *kt, int n, int k, CCdatagroup *dat,
+        int *list),
+    CCkdtree_node_quadrant_k_nearest (CCkdtree *kt, int n, int k,
+        CCdatagroup *dat, int *list),
+    CCkdtree_node_nearest (CCkdtree *kt, int n, CCdatagroup *dat),
+    CCkdtree_nearest_neighbor_tour (CCkdtree *kt, int ncount, int start,
+        CCdatagroup *dat, int *outcycle, double *val, CCrandstate *rstate);
+
+
+/****************************************************************************/
+/*                                                                          */
+/*                             kdtour.c                                     */
+/*                                                                          */
+/****************************************************************************/
+
+int
+    CCkdtree_greedy_tour (CCkdtree *kt, int ncount, CCdatagroup *dat,
+        int *outcycle, double *val, int silent, CCrandstate *rstate),
+    CCkdtree_qboruvka_tour (CCkdtree *kt, int ncount, CCdatagroup *dat,
+        int *outcycle, double *val, CCrandstate *rstate),
+    CCkdtree_spacefill_tour (int ncount, CCdatagroup *dat, int *outcycle,
+        double *val);
+
+
+#endif  /* __KDTREE_H */
@@ -23,6 +23,62 @@
 #define CC_LK_CLOSE_KICK     (2)
 #define CC_LK_WALK_KICK      (3)
 
+#define CC_LK_RANDOM_START    (0)
+#define CC_LK_NEIGHBOR_START  (1)
+#define CC_LK_GREEDY_START    (2)
+#define CC_LK_QBORUVKA_START  (3)
+#define CC_LK_SPACEFILL_START (4)
+
+#define CC_LK_NEAREST_CANDS (0)
+#define CC_LK_ALPHA_CANDS   (1)
+
+#define CC_LK_SEARCH_DEFAULT (0)
+#define CC_LK_SEARCH_FAST    (1)
+#define CC_LK_SEARCH_DEEP    (2)
+
+#define CC_LK_MAX_BACKTRACK  (8)
+
+typedef struct CClk_workspace CClk_workspace;
+
+/* How deep and how wide each Lin-Kernighan move is searched. */
+typedef struct CClk_search {
+    int maxdepth;        /* flips in one improving move (>= 1) */
+    int kick_maxdepth;   /* flips in one kick */
+    int backtrack;       /* levels that try more than the best flip */
+    int backtrack_count[CC_LK_MAX_BACKTRACK]; /* flips tried per level */
+    int mak_morton;      /* also try Mak-Morton moves at the first node */
+    int less_or_equal;   /* also take edges no shorter than the gain */
+} CClk_search;
+
+/* What one run did and where its time went; counts are doubles so that  */
+/* long runs cannot overflow them.                                       */
+typedef struct CClk_stats {
+    double load_time;        /* seconds building the datagroup (CCtsp_lk) */
+    double candidate_time;   /* seconds building the candidate edges */
+    double start_time;       /* seconds building the start tour */
+    double initial_time;     /* seconds of LK on the start tour */
+    double kick_time;        /* seconds of the kicks that follow */
+    double kicks;
+    double improving_kicks;
+    double last_improvement; /* the kick that last improved, 0 if none */
+    double flips;            /* CClinkern_flipper_flip calls */
+    double splits;           /* segments the flips had to split */
+    double dist_lookups;     /* edge lengths asked of the distance cache */
+    double dist_misses;      /* ... and not found there */
+    double process_peak_rss; /* peak resident set of the whole process, */
+                             /* not just this run, in KB               */
+} CClk_stats;
+
+/* Hooks into, and the search of, a running CClinkern_tour; NULL hooks */
+/* are ignored.                                                        */
+typedef struct CClk_control {
+    const volatile int *cancel;  /* stop soon after it turns nonzero */
+    int  (*improved) (void *arg, double val, int ncount, const int *cycle);
+    void  *improved_arg;
+    double improved_interval;    /* min seconds between improved calls */
+    CClk_search search;
+    CClk_stats *stats;           /* filled in at the end of the run */
+} CClk_control;
 
 
 int
@@ -30,13 +86,79 @@ int
         int *elist, int stallcount, int repeatcount, int *incycle,
         int *outcycle, double *val, int silent, double time_bound,
         double length_bound, char *saveit_name, int kicktype,
-        CCrandstate *rstate),
+        CCrandstate *rstate, CClk_workspace *ws, const CClk_control *ctl),
     CClinkern_path (int ncount, CCdatagroup *dat, int ecount,
-        int *elist, int nkicks, int *inpath, int *outpath, double *val,
-        int silent, CCrandstate *rstate),
-    CClinkern_fixed (int ncount, CCdatagroup *dat, int ecount, int *elist,
-        int nkicks, int *incycle, int *outcycle, double *val, int fcount,
-        int *flist, int silent, CCrandstate *rstate);
+        int *elist, int stallcount, int repeatcount, int *inpath,
+        int *outpath, double *val, int silent, double time_bound,
+        double length_bound, int kicktype, CCrandstate *rstate,
+        CClk_workspace *ws, const CClk_control *ctl),
+    CClinkern_fixed (int ncount, CCdatagroup *dat, int ecount,
+        int *elist, int stallcount, int repeatcount, int *incycle,
+        int *outcycle, double *val, int fcount, int *flist, int silent,
+        double time_bound, double length_bound, int kicktype,
+        CCrandstate *rstate, CClk_workspace *ws, const CClk_control *ctl),
+    CClinkern_workspace_alloc (CClk_workspace **ws);
+
+void
+    CClinkern_init_control (CClk_control *ctl),
+    CClinkern_search_preset (CClk_search *search, int preset),
+    CClinkern_workspace_free (CClk_workspace *ws);
+
+
+/****************************************************************************/
+/*                                                                          */
+/*                             lk.c                                         */
+/*                                                                          */
+/****************************************************************************/
+
+typedef struct CCtsp_lkworkspace CCtsp_lkworkspace;
+
+/* Everything a solve may be tuned with; there is no file-level state, so  */
+/* the CCtsp_lk routines can run concurrently on distinct workspaces.      */
+typedef struct CCtsp_lkconfig {
+    int    seed;
+    int    kicktype;
+    int    starttype;
+    int    candtype;    /* CC_LK_NEAREST_CANDS or CC_LK_ALPHA_CANDS */
+    int    silent;
+    double time_bound;  /* seconds of wall clock, <= 0 for no bound */
+    CClk_control ctl;   /* cancel flag, progress reports and search */
+} CCtsp_lkconfig;
+
+int
+    CCtsp_lk (const unsigned int *distarr, unsigned int *route,
+        unsigned int ncount, int stallcount, double length_bound,
+        const CCtsp_lkconfig *cfg),
+    CCtsp_lk_from (const unsigned int *distarr, const unsigned int *start,
+        unsigned int *route, unsigned int ncount, int stallcount,
+        double length_bound, const CCtsp_lkconfig *cfg),
+    CCtsp_lk_path (const unsigned int *distarr, unsigned int s,
+        unsigned int t, unsigned int *route, unsigned int ncount,
+        int stallcount, double length_bound, const CCtsp_lkconfig *cfg),
+    CCtsp_lk_fixed (const unsigned int *distarr, int fcount,
+        const unsigned int *flist, unsigned int *route, unsigned int ncount,
+        int stallcount, double length_bound, const CCtsp_lkconfig *cfg),
+    CCtsp_lk_ws (CCtsp_lkworkspace *ws, const unsigned int *distarr,
+        unsigned int *route, unsigned int ncount, int stallcount,
+        double length_bound, const CCtsp_lkconfig *cfg),
+    CCtsp_lk_chain (CCtsp_lkworkspace *ws, const unsigned int *distarr,
+        unsigned int *route, unsigned int ncount, int ecount,
+        const int *elist, int stallcount, double length_bound,
+        const CCtsp_lkconfig *cfg),
+    CCtsp_lk_candidates (const unsigned int *distarr, unsigned int ncount,
+        int *ecount, int **elist),
+    CCtsp_junk_k_nearest (const unsigned int *distarr, unsigned int ncount,
+        int num, const double *wcoord, int nthreads, int *ecount,
+        int **elist),
+    CCtsp_lk_coords (const double *x, const double *y, const double *z,
+        int norm, unsigned int *route, unsigned int ncount, int stallcount,
+        double length_bound, const CCtsp_lkconfig *cfg),
+    CCtsp_lkworkspace_alloc (CCtsp_lkworkspace **ws);
+
+void
+    CCtsp_init_lkconfig (CCtsp_lkconfig *cfg),
+    CCtsp_lk_free_candidates (int *elist),
+    CCtsp_lkworkspace_free (CCtsp_lkworkspace *ws);
 
 #endif  /* __LINKERN_H */
 
@@ -73,16 +195,23 @@ typedef struct CClk_flipper {
     int                     nsegments;
     int                     groupsize;
     int                     split_cutoff;
+    int                     parents_space;
+    int                     children_space;
+    int                     counting; /* keep flips and splits */
+    double                  flips;
+    double                  splits;
 } CClk_flipper;
 
 
 
 int
     CClinkern_flipper_init (CClk_flipper *f, int ncount, int *cyc),
+    CClinkern_flipper_reset (CClk_flipper *f, int ncount, int *cyc),
     CClinkern_flipper_next (CClk_flipper *f, int x),
     CClinkern_flipper_prev (CClk_flipper *f, int x),
     CClinkern_flipper_sequence (CClk_flipper *f, int x, int y, int z);
 void
+    CClinkern_flipper_clear (CClk_flipper *f),
     CClinkern_flipper_flip (CClk_flipper *F, int x, int y),
     CClinkern_flipper_cycle (CClk_flipper *F, int *x),
     CClinkern_flipper_finish (CClk_flipper *F);
@@ -457,6 +457,7 @@ int
 /****************************************************************************/
 
 #undef  CCUTIL_EDGELEN_FUNCTIONPTR
+/* Keep it undefined: the pointer would be shared by concurrent solves. */
 
 typedef struct CCdata_user {
     double  *x;
@@ -1016,6 +1017,10 @@ double
 /****************************************************************************/
 int CCutil_receive_distarr(const unsigned int *distarr, unsigned int ncount,
                            CCdatagroup *dat);
+int CCutil_receive_coords(const double *x, const double *y, const double *z,
+                          int norm, unsigned int ncount, CCdatagroup *dat);
+void CCutil_distarr_rows(const unsigned int *distarr, unsigned int ncount,
+                         int **adj);
 
 char
    *CCutil_strchr (char *s, int c),
@@ -1060,6 +1065,8 @@ typedef struct CCutil_timer {
 double
     CCutil_zeit (void),
     CCutil_real_zeit (void),
+    CCutil_mono_zeit (void),
+    CCutil_peak_memory (void),
     CCutil_stop_timer (CCutil_timer *t, int printit),
     CCutil_total_timer (CCutil_timer *t, int printit);
 
@@ -1071,5 +1078,19 @@ void
     CCutil_resume_timer (CCutil_timer *t);
 
 
+/****************************************************************************/
+/*                                                                          */
+/*                             threads.c                                    */
+/*                                                                          */
+/****************************************************************************/
+
+int
+    CCutil_cpu_count (void);
+
+void
+    CCutil_run_workers (void *w, size_t wsize, int nworkers,
+        void *(*fn) (void *));
+
+
 
 #endif /* __UTIL_H */
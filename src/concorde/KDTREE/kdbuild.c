@@ -0,0 +1,228 @@
+/****************************************************************************/
+/*                                                                          */
+/*  This file is part of CONCORDE                                           */
+/*                                                                          */
+/*  (c) Copyright 1995--1999 by David Applegate, Robert Bixby,              */
+/*  Vasek Chvatal, and William Cook                                         */
+/*                                                                          */
+/*  Permission is granted for academic research use.  For other uses,       */
+/*  contact the authors for licensing options.                              */
+/*                                                                          */
+/*  Use at your own risk.  We make no guarantees about the                  */
+/*  correctness or usefulness of this code.                                 */
+/*                                                                          */
+/****************************************************************************/
+
+/****************************************************************************/
+/*                                                                          */
+/*                      BUILD A 2-D KDTREE                                  */
+/*                                                                          */
+/*                           TSP CODE                                       */
+/*                                                                          */
+/*                                                                          */
+/*    EXPORTED FUNCTIONS:                                                   */
+/*                                                                          */
+/*  int CCkdtree_build (CCkdtree *kt, int ncount, CCdatagroup *dat,         */
+/*      CCrandstate *rstate)                                                */
+/*    BUILDS a semi-dynamic kdtree (Bentley) over the points of dat.        */
+/*     -kt is a pointer to the tree to be built                             */
+/*     -dat must use a KD-Norm (the x and y coordinates are used)           */
+/*     -rstate drives the median selections                                 */
+/*    Each cell is cut at the median of its points in the coordinate with   */
+/*    the larger spread, until at most BUCKETSIZE points are left; so the   */
+/*    build takes O(n log n) time and 2n nodes.                             */
+/*                                                                          */
+/*  void CCkdtree_free (CCkdtree *kt)                                       */
+/*    FREES the space used by the tree.                                     */
+/*                                                                          */
+/*  void CCkdtree_delete (CCkdtree *kt, int k)                              */
+/*    DELETES the point k from the tree (k must be in the tree); deleted    */
+/*     points are skipped by every search.                                  */
+/*                                                                          */
+/*  void CCkdtree_delete_all (CCkdtree *kt, int ncount)                     */
+/*    DELETES every point.                                                  */
+/*                                                                          */
+/*  void CCkdtree_undelete (CCkdtree *kt, int k)                            */
+/*    PUTS the deleted point k back in the tree.                            */
+/*                                                                          */
+/*  void CCkdtree_undelete_all (CCkdtree *kt, int ncount)                   */
+/*    PUTS every point back in the tree.                                    */
+/*                                                                          */
+/****************************************************************************/
+
+#include "kdtree.h"
+#include "machdefs.h"
+#include "macrorus.h"
+#include "util.h"
+
+#define BUCKETSIZE 6
+
+static CCkdnode *build_work(CCkdtree *kt, CCdatagroup *dat, int l, int u,
+                            CCkdnode *father, const double *bnds,
+                            CCrandstate *rstate);
+
+int CCkdtree_build(CCkdtree *kt, int ncount, CCdatagroup *dat,
+                   CCrandstate *rstate) {
+    int i;
+    double bnds[4];
+
+    kt->root = (CCkdnode *)NULL;
+    kt->bucketptr = (CCkdnode **)NULL;
+    kt->nodespace = (CCkdnode *)NULL;
+    kt->perm = (int *)NULL;
+    kt->nodecount = 0;
+
+    if ((dat->norm & CC_NORM_BITS) != CC_KD_NORM_TYPE) {
+        fprintf(stderr, "Cannot build a kdtree with norm %d\n", dat->norm);
+        return 1;
+    }
+    if (ncount < 1) {
+        fprintf(stderr, "Cannot build a kdtree on %d points\n", ncount);
+        return 1;
+    }
+
+    kt->perm = CC_SAFE_MALLOC(ncount, int);
+    kt->bucketptr = CC_SAFE_MALLOC(ncount, CCkdnode *);
+    kt->nodespace = CC_SAFE_MALLOC(2 * ncount, CCkdnode);
+    if (kt->perm == (int *)NULL || kt->bucketptr == (CCkdnode **)NULL ||
+        kt->nodespace == (CCkdnode *)NULL) {
+        fprintf(stderr, "out of memory in CCkdtree_build\n");
+        CCkdtree_free(kt);
+        return 1;
+    }
+
+    bnds[0] = bnds[1] = dat->x[0];
+    bnds[2] = bnds[3] = dat->y[0];
+    for (i = 0; i < ncount; i++) {
+        kt->perm[i] = i;
+        if (dat->x[i] < bnds[0])
+            bnds[0] = dat->x[i];
+        else if (dat->x[i] > bnds[1])
+            bnds[1] = dat->x[i];
+        if (dat->y[i] < bnds[2])
+            bnds[2] = dat->y[i];
+        else if (dat->y[i] > bnds[3])
+            bnds[3] = dat->y[i];
+    }
+
+    kt->root = build_work(kt, dat, 0, ncount - 1, (CCkdnode *)NULL, bnds,
+                          rstate);
+    return 0;
+}
+
+static CCkdnode *build_work(CCkdtree *kt, CCdatagroup *dat, int l, int u,
+                            CCkdnode *father, const double *bnds,
+                            CCrandstate *rstate) {
+    CCkdnode *p = &kt->nodespace[kt->nodecount++];
+    double lobnds[4], hibnds[4];
+    double xmin, xmax, ymin, ymax;
+    double *coord;
+    int i, m;
+
+    p->father = father;
+    p->loson = (CCkdnode *)NULL;
+    p->hison = (CCkdnode *)NULL;
+    p->empty = 0;
+    p->lopt = l;
+    p->hipt = u;
+    p->top = u;
+    for (i = 0; i < 4; i++)
+        p->bnds[i] = bnds[i];
+
+    if (u - l + 1 <= BUCKETSIZE) {
+        p->bucket = 1;
+        p->cutdim = 0;
+        p->cutval = 0.0;
+        for (i = l; i <= u; i++)
+            kt->bucketptr[kt->perm[i]] = p;
+        return p;
+    }
+
+    xmin = xmax = dat->x[kt->perm[l]];
+    ymin = ymax = dat->y[kt->perm[l]];
+    for (i = l + 1; i <= u; i++) {
+        int k = kt->perm[i];
+        if (dat->x[k] < xmin)
+            xmin = dat->x[k];
+        else if (dat->x[k] > xmax)
+            xmax = dat->x[k];
+        if (dat->y[k] < ymin)
+            ymin = dat->y[k];
+        else if (dat->y[k] > ymax)
+            ymax = dat->y[k];
+    }
+
+    p->bucket = 0;
+    p->cutdim = (xmax - xmin >= ymax - ymin) ? 0 : 1;
+    coord = p->cutdim ? dat->y : dat->x;
+    m = (l + u) / 2;
+    CCutil_rselect(kt->perm, l, u, m, coord, rstate);
+    p->cutval = coord[kt->perm[m]];
+
+    for (i = 0; i < 4; i++)
+        lobnds[i] = hibnds[i] = bnds[i];
+    lobnds[2 * p->cutdim + 1] = p->cutval;
+    hibnds[2 * p->cutdim] = p->cutval;
+
+    p->loson = build_work(kt, dat, l, m, p, lobnds, rstate);
+    p->hison = build_work(kt, dat, m + 1, u, p, hibnds, rstate);
+    return p;
+}
+
+void CCkdtree_free(CCkdtree *kt) {
+    CC_IFFREE(kt->perm, int);
+    CC_IFFREE(kt->bucketptr, CCkdnode *);
+    CC_IFFREE(kt->nodespace, CCkdnode);
+    kt->root = (CCkdnode *)NULL;
+    kt->nodecount = 0;
+}
+
+void CCkdtree_delete(CCkdtree *kt, int k) {
+    CCkdnode *p = kt->bucketptr[k];
+    int j, temp;
+
+    /* Swap k past the last live point of its bucket */
+    for (j = p->lopt; kt->perm[j] != k; j++)
+        ;
+    CC_SWAP(kt->perm[j], kt->perm[p->hipt], temp);
+    p->hipt--;
+
+    if (p->hipt < p->lopt) {
+        p->empty = 1;
+        for (p = p->father; p && p->loson->empty && p->hison->empty;
+             p = p->father) {
+            p->empty = 1;
+        }
+    }
+}
+
+void CCkdtree_undelete(CCkdtree *kt, int k) {
+    CCkdnode *p = kt->bucketptr[k];
+    int j, temp;
+
+    for (j = p->hipt + 1; kt->perm[j] != k; j++)
+        ;
+    p->hipt++;
+    CC_SWAP(kt->perm[j], kt->perm[p->hipt], temp);
+
+    for (; p && p->empty; p = p->father)
+        p->empty = 0;
+}
+
+void CCkdtree_delete_all(CCkdtree *kt, CC_UNUSED int ncount) {
+    int i;
+
+    for (i = 0; i < kt->nodecount; i++) {
+        kt->nodespace[i].empty = 1;
+        kt->nodespace[i].hipt = kt->nodespace[i].lopt - 1;
+    }
+}
+
+void CCkdtree_undelete_all(CCkdtree *kt, CC_UNUSED int ncount) {
+    int i;
+
+    for (i = 0; i < kt->nodecount; i++) {
+        kt->nodespace[i].empty = 0;
+        kt->nodespace[i].hipt = kt->nodespace[i].top;
+    }
+}
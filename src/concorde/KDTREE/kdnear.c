@@ -0,0 +1,436 @@
+/****************************************************************************/
+/*                                                                          */
+/*  This file is part of CONCORDE                                           */
+/*                                                                          */
+/*  (c) Copyright 1995--1999 by David Applegate, Robert Bixby,              */
+/*  Vasek Chvatal, and William Cook                                         */
+/*                                                                          */
+/*  Permission is granted for academic research use.  For other uses,       */
+/*  contact the authors for licensing options.                              */
+/*                                                                          */
+/*  Use at your own risk.  We make no guarantees about the                  */
+/*  correctness or usefulness of this code.                                 */
+/*                                                                          */
+/****************************************************************************/
+
+/****************************************************************************/
+/*                                                                          */
+/*               NEAREST NEIGHBORS FROM A KDTREE                            */
+/*                                                                          */
+/*                           TSP CODE                                       */
+/*                                                                          */
+/*                                                                          */
+/*    EXPORTED FUNCTIONS:                                                   */
+/*                                                                          */
+/*  int CCkdtree_k_nearest (CCkdtree *kt, int ncount, int k,                */
+/*      CCdatagroup *dat, int *ecount, int **elist, int silent,             */
+/*      CCrandstate *rstate)                                                */
+/*    RETURNS the k-nearest neighbor graph.                                 */
+/*     -kt can be NULL, in which case a tree is built for the call          */
+/*     -ncount is the number of nodes                                       */
+/*     -k is the number of nearest neighbors wanted                         */
+/*     -dat contains the info to generate edge lengths (a KD-Norm)          */
+/*     -ecount returns the number of edges                                  */
+/*     -elist returns the edges in end1 end2 format                         */
+/*                                                                          */
+/*  int CCkdtree_quadrant_k_nearest (CCkdtree *kt, int ncount, int k,       */
+/*      CCdatagroup *dat, int *ecount, int **elist, int silent,             */
+/*      CCrandstate *rstate)                                                */
+/*    RETURNS the quadrant k-nearest graph: the k nearest neighbors of      */
+/*     each node in each of the four quadrants around it.                   */
+/*                                                                          */
+/*  int CCkdtree_node_k_nearest (CCkdtree *kt, int n, int k,                */
+/*      CCdatagroup *dat, int *list)                                        */
+/*    RETURNS the number of neighbors (at most k) of node n put in list,    */
+/*     nearest first; n itself and deleted points are skipped.              */
+/*     -list should point to an array of length at least k                  */
+/*                                                                          */
+/*  int CCkdtree_node_quadrant_k_nearest (CCkdtree *kt, int n, int k,       */
+/*      CCdatagroup *dat, int *list)                                        */
+/*    RETURNS the number of quadrant neighbors of node n put in list.       */
+/*     -list should point to an array of length at least 4k                 */
+/*                                                                          */
+/*  int CCkdtree_node_nearest (CCkdtree *kt, int n, CCdatagroup *dat)       */
+/*    RETURNS the nearest point to n that is not deleted (-1 if none).      */
+/*                                                                          */
+/*  int CCkdtree_nearest_neighbor_tour (CCkdtree *kt, int ncount,           */
+/*      int start, CCdatagroup *dat, int *outcycle, double *val,            */
+/*      CCrandstate *rstate)                                                */
+/*    RETURNS a nearest neighbor tour, starting at node start.              */
+/*     -kt can be NULL; if not, its points are all undeleted on return      */
+/*     -outcycle will contain the tour if it is not NULL                    */
+/*     -val will return the length of the tour                              */
+/*                                                                          */
+/*    NOTES:                                                                */
+/*      Each search starts in n's bucket and climbs (Bentley), running     */
+/*    down each brother cell nearer son first and skipping a cell once     */
+/*    its distance to n reaches the current k-th best length, so a query   */
+/*    costs O(k) cells on spread out points.                               */
+/*                                                                          */
+/****************************************************************************/
+
+#include "kdtree.h"
+#include "machdefs.h"
+#include "macrorus.h"
+#include "util.h"
+
+typedef struct kdsearch {
+    CCdatagroup *dat;
+    int norm;
+    int n;    /* the query point, never reported */
+    double x, y;
+    int quad; /* -1 for every direction, else the quadrant 0..3 */
+    int k;
+    int cnt;
+    int *list;
+    int *lens;
+} kdsearch;
+
+static void search_work(CCkdtree *kt, CCkdnode *p, kdsearch *s),
+    search_insert(kdsearch *s, int m, int len);
+
+static int node_search(CCkdtree *kt, int n, int k, int quad, CCdatagroup *dat,
+                       int *list, int *lens),
+    all_nearest(CCkdtree *kt, int ncount, int k, int quadrant,
+                CCdatagroup *dat, int *ecount, int **elist, int silent,
+                CCrandstate *rstate),
+    box_len(int norm, double dx, double dy), quadrant_of(kdsearch *s, int m),
+    cell_len(const CCkdnode *p, kdsearch *s),
+    cell_meets_quadrant(const CCkdnode *p, kdsearch *s),
+    ball_within(const CCkdnode *p, kdsearch *s);
+
+int CCkdtree_k_nearest(CCkdtree *kt, int ncount, int k, CCdatagroup *dat,
+                       int *ecount, int **elist, int silent,
+                       CCrandstate *rstate) {
+    return all_nearest(kt, ncount, k, 0, dat, ecount, elist, silent, rstate);
+}
+
+int CCkdtree_quadrant_k_nearest(CCkdtree *kt, int ncount, int k,
+                                CCdatagroup *dat, int *ecount, int **elist,
+                                int silent, CCrandstate *rstate) {
+    return all_nearest(kt, ncount, k, 1, dat, ecount, elist, silent, rstate);
+}
+
+int CCkdtree_node_k_nearest(CCkdtree *kt, int n, int k, CCdatagroup *dat,
+                            int *list) {
+    int cnt;
+    int *lens = CC_SAFE_MALLOC(k, int);
+
+    if (lens == (int *)NULL) {
+        fprintf(stderr, "out of memory in CCkdtree_node_k_nearest\n");
+        return 0;
+    }
+    cnt = node_search(kt, n, k, -1, dat, list, lens);
+    CC_FREE(lens, int);
+    return cnt;
+}
+
+int CCkdtree_node_quadrant_k_nearest(CCkdtree *kt, int n, int k,
+                                     CCdatagroup *dat, int *list) {
+    int q, cnt = 0;
+    int *lens = CC_SAFE_MALLOC(k, int);
+
+    if (lens == (int *)NULL) {
+        fprintf(stderr, "out of memory in CCkdtree_node_quadrant_k_nearest\n");
+        return 0;
+    }
+    for (q = 0; q < 4; q++)
+        cnt += node_search(kt, n, k, q, dat, list + cnt, lens);
+    CC_FREE(lens, int);
+    return cnt;
+}
+
+int CCkdtree_node_nearest(CCkdtree *kt, int n, CCdatagroup *dat) {
+    int list, len;
+
+    if (node_search(kt, n, 1, -1, dat, &list, &len) == 0)
+        return -1;
+    return list;
+}
+
+int CCkdtree_nearest_neighbor_tour(CCkdtree *kt, int ncount, int start,
+                                   CCdatagroup *dat, int *outcycle,
+                                   double *val, CCrandstate *rstate) {
+    int rval = 0;
+    int i, current, next;
+    int newtree = 0;
+    double len;
+    CCkdtree localkt;
+
+    if (ncount < 3) {
+        fprintf(stderr, "Cannot find tour in an %d node graph\n", ncount);
+        return 1;
+    }
+
+    if (kt == (CCkdtree *)NULL) {
+        if (CCkdtree_build(&localkt, ncount, dat, rstate)) {
+            fprintf(stderr, "Unable to build CCkdtree\n");
+            return 1;
+        }
+        kt = &localkt;
+        newtree = 1;
+    }
+
+    len = 0.0;
+    current = start;
+    if (outcycle != (int *)NULL)
+        outcycle[0] = start;
+
+    for (i = 1; i < ncount; i++) {
+        CCkdtree_delete(kt, current);
+        next = CCkdtree_node_nearest(kt, current, dat);
+        if (next == -1) {
+            fprintf(stderr, "CCkdtree_node_nearest found no point\n");
+            rval = 1;
+            goto CLEANUP;
+        }
+        if (outcycle != (int *)NULL)
+            outcycle[i] = next;
+        len += (double)CCutil_dat_edgelen(current, next, dat);
+        current = next;
+    }
+    len += (double)CCutil_dat_edgelen(current, start, dat);
+    *val = len;
+
+CLEANUP:
+
+    if (newtree)
+        CCkdtree_free(kt);
+    else
+        CCkdtree_undelete_all(kt, ncount);
+    return rval;
+}
+
+static int all_nearest(CCkdtree *kt, int ncount, int k, int quadrant,
+                       CCdatagroup *dat, int *ecount, int **elist, int silent,
+                       CCrandstate *rstate) {
+    int rval = 0;
+    int i, j, q, t, m, per, have;
+    int newtree = 0;
+    int *nbrs = (int *)NULL, *cnt = (int *)NULL, *lens = (int *)NULL;
+    CCkdtree localkt;
+
+    *ecount = 0;
+    *elist = (int *)NULL;
+
+    if (!quadrant && k >= ncount)
+        k = ncount - 1;
+    if (k <= 0)
+        return 0;
+
+    if (!silent) {
+        printf("Using kdtree %snearest code\n", quadrant ? "quadrant " : "");
+        fflush(stdout);
+    }
+
+    if (kt == (CCkdtree *)NULL) {
+        if (CCkdtree_build(&localkt, ncount, dat, rstate)) {
+            fprintf(stderr, "Unable to build CCkdtree\n");
+            return 1;
+        }
+        kt = &localkt;
+        newtree = 1;
+    }
+
+    per = quadrant ? 4 * k : k;
+    nbrs = CC_SAFE_MALLOC(ncount * per, int);
+    cnt = CC_SAFE_MALLOC(ncount, int);
+    lens = CC_SAFE_MALLOC(k, int);
+    if (nbrs == (int *)NULL || cnt == (int *)NULL || lens == (int *)NULL) {
+        fprintf(stderr, "out of memory in all_nearest\n");
+        rval = 1;
+        goto CLEANUP;
+    }
+
+    /* Query in the tree's order, so neighboring queries share cells */
+    for (t = 0; t < ncount; t++) {
+        i = kt->perm[t];
+        if (quadrant) {
+            cnt[i] = 0;
+            for (q = 0; q < 4; q++)
+                cnt[i] += node_search(kt, i, k, q, dat,
+                                      nbrs + i * per + cnt[i], lens);
+        } else {
+            cnt[i] = node_search(kt, i, k, -1, dat, nbrs + i * per, lens);
+        }
+    }
+
+    /* Edge ij is listed from i unless j < i and j already listed it */
+    for (t = 0; t < 2; t++) {
+        m = 0;
+        for (i = 0; i < ncount; i++) {
+            for (j = 0; j < cnt[i]; j++) {
+                int nb = nbrs[i * per + j];
+                if (nb < i) {
+                    for (q = 0, have = 0; q < cnt[nb] && !have; q++)
+                        have = (nbrs[nb * per + q] == i);
+                    if (have)
+                        continue;
+                }
+                if (t == 1) {
+                    (*elist)[2 * m] = i;
+                    (*elist)[2 * m + 1] = nb;
+                }
+                m++;
+            }
+        }
+        if (t == 0) {
+            *elist = CC_SAFE_MALLOC(2 * m, int);
+            if (*elist == (int *)NULL) {
+                fprintf(stderr, "out of memory in all_nearest\n");
+                rval = 1;
+                goto CLEANUP;
+            }
+        }
+    }
+    *ecount = m;
+
+CLEANUP:
+
+    CC_IFFREE(nbrs, int);
+    CC_IFFREE(cnt, int);
+    CC_IFFREE(lens, int);
+    if (newtree)
+        CCkdtree_free(kt);
+    return rval;
+}
+
+static int node_search(CCkdtree *kt, int n, int k, int quad, CCdatagroup *dat,
+                       int *list, int *lens) {
+    kdsearch s;
+    CCkdnode *p;
+
+    s.dat = dat;
+    s.norm = dat->norm;
+    s.n = n;
+    s.x = dat->x[n];
+    s.y = dat->y[n];
+    s.quad = quad;
+    s.k = k;
+    s.cnt = 0;
+    s.list = list;
+    s.lens = lens;
+
+    if (k <= 0)
+        return 0;
+
+    /* Bottom-up: search n's own bucket, then the brother of each cell */
+    /* on the way to the root, until the ball holding the k best fits  */
+    /* inside the cell searched so far.                                */
+    p = kt->bucketptr[n];
+    search_work(kt, p, &s);
+    while (p->father != (CCkdnode *)NULL) {
+        CCkdnode *son = p;
+        p = p->father;
+        search_work(kt, (son == p->loson) ? p->hison : p->loson, &s);
+        if (s.cnt == s.k && ball_within(p, &s))
+            break;
+    }
+    return s.cnt;
+}
+
+static void search_work(CCkdtree *kt, CCkdnode *p, kdsearch *s) {
+    int j, m, len;
+
+    if (p->empty)
+        return;
+    if (s->quad >= 0 && !cell_meets_quadrant(p, s))
+        return;
+    if (s->cnt == s->k && cell_len(p, s) >= s->lens[s->k - 1])
+        return;
+
+    if (p->bucket) {
+        for (j = p->lopt; j <= p->hipt; j++) {
+            m = kt->perm[j];
+            if (m == s->n || (s->quad >= 0 && quadrant_of(s, m) != s->quad))
+                continue;
+            len = CCutil_dat_edgelen(s->n, m, s->dat);
+            if (s->cnt < s->k || len < s->lens[s->cnt - 1])
+                search_insert(s, m, len);
+        }
+    } else if ((p->cutdim ? s->y : s->x) < p->cutval) {
+        search_work(kt, p->loson, s);
+        search_work(kt, p->hison, s);
+    } else {
+        search_work(kt, p->hison, s);
+        search_work(kt, p->loson, s);
+    }
+}
+
+/* The lists are short, so the k best are kept sorted by insertion */
+static void search_insert(kdsearch *s, int m, int len) {
+    int i;
+
+    if (s->cnt < s->k)
+        s->cnt++;
+    for (i = s->cnt - 1; i > 0 && s->lens[i - 1] > len; i--) {
+        s->list[i] = s->list[i - 1];
+        s->lens[i] = s->lens[i - 1];
+    }
+    s->list[i] = m;
+    s->lens[i] = len;
+}
+
+/* Quadrants are half-open, so every other point lies in exactly one */
+static int quadrant_of(kdsearch *s, int m) {
+    double dx = s->dat->x[m] - s->x, dy = s->dat->y[m] - s->y;
+
+    if (dx >= 0.0)
+        return (dy >= 0.0) ? 0 : 3;
+    else
+        return (dy >= 0.0) ? 1 : 2;
+}
+
+static int cell_meets_quadrant(const CCkdnode *p, kdsearch *s) {
+    switch (s->quad) {
+    case 0:
+        return p->bnds[1] >= s->x && p->bnds[3] >= s->y;
+    case 1:
+        return p->bnds[0] < s->x && p->bnds[3] >= s->y;
+    case 2:
+        return p->bnds[0] < s->x && p->bnds[2] < s->y;
+    default:
+        return p->bnds[1] >= s->x && p->bnds[2] < s->y;
+    }
+}
+
+static int cell_len(const CCkdnode *p, kdsearch *s) {
+    double dx = 0.0, dy = 0.0;
+
+    if (s->x < p->bnds[0])
+        dx = p->bnds[0] - s->x;
+    else if (s->x > p->bnds[1])
+        dx = s->x - p->bnds[1];
+    if (s->y < p->bnds[2])
+        dy = p->bnds[2] - s->y;
+    else if (s->y > p->bnds[3])
+        dy = s->y - p->bnds[3];
+
+    return box_len(s->norm, dx, dy);
+}
+
+/* No point outside the cell can beat the k-th best once each side of */
+/* the cell is at least that far from n.                              */
+static int ball_within(const CCkdnode *p, kdsearch *s) {
+    int worst = s->lens[s->k - 1];
+
+    return box_len(s->norm, s->x - p->bnds[0], 0.0) >= worst &&
+           box_len(s->norm, p->bnds[1] - s->x, 0.0) >= worst &&
+           box_len(s->norm, 0.0, s->y - p->bnds[2]) >= worst &&
+           box_len(s->norm, 0.0, p->bnds[3] - s->y) >= worst;
+}
+
+/* Rounds like the norm's edgelen, so it never exceeds the length of an  */
+/* edge to a point at least dx and dy away.                              */
+static int box_len(int norm, double dx, double dy) {
+    switch (norm) {
+    case CC_MAXNORM:
+        return (int)((dx < dy ? dy : dx) + 0.5);
+    case CC_MANNORM:
+        return (int)(dx + dy + 0.5);
+    case CC_EUCLIDEAN_CEIL:
+        return (int)ceil(sqrt(dx * dx + dy * dy));
+    default:
+        return (int)(sqrt(dx * dx + dy * dy) + 0.5);
+    }
+}
@@ -0,0 +1,411 @@
+/****************************************************************************/
+/*                                                                          */
+/*  This file is part of CONCORDE                                           */
+/*                                                                          */
+/*  (c) Copyright 1995--1999 by David Applegate, Robert Bixby,              */
+/*  Vasek Chvatal, and William Cook                                         */
+/*                                                                          */
+/*  Permission is granted for academic research use.  For other uses,       */
+/*  contact the authors for licensing options.                              */
+/*                                                                          */
+/*  Use at your own risk.  We make no guarantees about the                  */
+/*  correctness or usefulness of this code.                                 */
+/*                                                                          */
+/****************************************************************************/
+
+/****************************************************************************/
+/*                                                                          */
+/*               STARTING TOURS FROM A KDTREE                               */
+/*                                                                          */
+/*                           TSP CODE                                       */
+/*                                                                          */
+/*                                                                          */
+/*    EXPORTED FUNCTIONS:                                                   */
+/*                                                                          */
+/*  int CCkdtree_greedy_tour (CCkdtree *kt, int ncount, CCdatagroup *dat,   */
+/*      int *outcycle, double *val, int silent, CCrandstate *rstate)        */
+/*    RETURNS a greedy tour: edges are added shortest first whenever        */
+/*     they keep every degree at most 2 and close no subtour.               */
+/*     -kt can be NULL; if not, its points are all undeleted on return      */
+/*     -outcycle will contain the tour if it is not NULL                    */
+/*     -val will return the length of the tour                              */
+/*    Each path end keeps its nearest feasible mate in a heap keyed on      */
+/*    the length; mates that went stale are searched again when they        */
+/*    reach the top, so the tour takes O(n log n) time.                     */
+/*                                                                          */
+/*  int CCkdtree_qboruvka_tour (CCkdtree *kt, int ncount,                   */
+/*      CCdatagroup *dat, int *outcycle, double *val, CCrandstate *rstate)  */
+/*    RETURNS a quick-boruvka tour: the nodes are sorted by the length to   */
+/*     their nearest neighbor and, in passes over that order, each node     */
+/*     of degree less than 2 is joined to its nearest feasible mate.        */
+/*     Cheaper than greedy and nearly as good.                              */
+/*                                                                          */
+/*  int CCkdtree_spacefill_tour (int ncount, CCdatagroup *dat,              */
+/*      int *outcycle, double *val)                                         */
+/*    RETURNS the tour that visits the nodes in the order of a Hilbert      */
+/*     curve through their bounding square (Platzman and Bartholdi). It     */
+/*     only needs coordinates, so it also works for X-Norms.                */
+/*                                                                          */
+/****************************************************************************/
+
+#include "kdtree.h"
+#include "machdefs.h"
+#include "macrorus.h"
+#include "util.h"
+
+#define HILBERT_BITS 15 /* keeps the keys in 30 bits */
+
+typedef struct fragments {
+    int *deg;
+    int *tail; /* the other end of each path end's fragment */
+    int *mate;
+    int *adj;
+} fragments;
+
+static int init_fragments(fragments *F, int ncount),
+    fragment_nearest(CCkdtree *kt, int n, fragments *F, CCdatagroup *dat),
+    hilbert_key(int side, int x, int y);
+
+static void free_fragments(fragments *F),
+    join_fragments(fragments *F, int i, int j),
+    close_tour(fragments *F, int ncount, CCdatagroup *dat, int *outcycle,
+               double *val);
+
+int CCkdtree_greedy_tour(CCkdtree *kt, int ncount, CCdatagroup *dat,
+                         int *outcycle, double *val, int silent,
+                         CCrandstate *rstate) {
+    int rval = 0;
+    int i, j, k, count;
+    int newtree = 0, heapinit = 0;
+    char *inheap = (char *)NULL;
+    fragments F;
+    CCdheap h;
+    CCkdtree localkt;
+
+    if (ncount < 3) {
+        fprintf(stderr, "Cannot find tour in an %d node graph\n", ncount);
+        return 1;
+    }
+    if (!silent) {
+        printf("Grow a greedy tour \n");
+        fflush(stdout);
+    }
+
+    if (kt == (CCkdtree *)NULL) {
+        if (CCkdtree_build(&localkt, ncount, dat, rstate)) {
+            fprintf(stderr, "Unable to build CCkdtree\n");
+            return 1;
+        }
+        kt = &localkt;
+        newtree = 1;
+    }
+
+    rval = init_fragments(&F, ncount);
+    if (rval)
+        goto CLEANUP;
+    inheap = CC_SAFE_MALLOC(ncount, char);
+    if (inheap == (char *)NULL) {
+        fprintf(stderr, "out of memory in CCkdtree_greedy_tour\n");
+        rval = 1;
+        goto CLEANUP;
+    }
+    rval = CCutil_dheap_init(&h, ncount);
+    if (rval) {
+        fprintf(stderr, "CCutil_dheap_init failed\n");
+        goto CLEANUP;
+    }
+    heapinit = 1;
+
+    for (k = 0; k < ncount; k++) {
+        i = kt->perm[k];
+        F.mate[i] = CCkdtree_node_nearest(kt, i, dat);
+        h.key[i] = (double)CCutil_dat_edgelen(i, F.mate[i], dat);
+        CCutil_dheap_insert(&h, i);
+        inheap[i] = 1;
+    }
+
+    /* A stale key is a lower bound on the fresh one, so the edges still */
+    /* come off the heap shortest first.                                 */
+    count = 0;
+    while (count < ncount - 1) {
+        i = CCutil_dheap_deletemin(&h);
+        inheap[i] = 0;
+        j = F.mate[i];
+        if (F.deg[j] == 2 || j == F.tail[i]) {
+            j = fragment_nearest(kt, i, &F, dat);
+            F.mate[i] = j;
+            h.key[i] = (double)CCutil_dat_edgelen(i, j, dat);
+            CCutil_dheap_insert(&h, i);
+            inheap[i] = 1;
+            continue;
+        }
+
+        join_fragments(&F, i, j);
+        count++;
+        if (F.deg[i] == 2) {
+            CCkdtree_delete(kt, i);
+        } else {
+            CCutil_dheap_insert(&h, i);
+            inheap[i] = 1;
+        }
+        if (F.deg[j] == 2) {
+            CCkdtree_delete(kt, j);
+            if (inheap[j]) {
+                CCutil_dheap_delete(&h, j);
+                inheap[j] = 0;
+            }
+        }
+    }
+
+    close_tour(&F, ncount, dat, outcycle, val);
+
+CLEANUP:
+
+    if (heapinit)
+        CCutil_dheap_free(&h);
+    CC_IFFREE(inheap, char);
+    free_fragments(&F);
+    if (newtree)
+        CCkdtree_free(kt);
+    else
+        CCkdtree_undelete_all(kt, ncount);
+    return rval;
+}
+
+int CCkdtree_qboruvka_tour(CCkdtree *kt, int ncount, CCdatagroup *dat,
+                           int *outcycle, double *val, CCrandstate *rstate) {
+    int rval = 0;
+    int i, j, k, count, live;
+    int newtree = 0;
+    int *perm = (int *)NULL, *lens = (int *)NULL;
+    fragments F;
+    CCkdtree localkt;
+
+    if (ncount < 3) {
+        fprintf(stderr, "Cannot find tour in an %d node graph\n", ncount);
+        return 1;
+    }
+
+    if (kt == (CCkdtree *)NULL) {
+        if (CCkdtree_build(&localkt, ncount, dat, rstate)) {
+            fprintf(stderr, "Unable to build CCkdtree\n");
+            return 1;
+        }
+        kt = &localkt;
+        newtree = 1;
+    }
+
+    rval = init_fragments(&F, ncount);
+    if (rval)
+        goto CLEANUP;
+    perm = CC_SAFE_MALLOC(ncount, int);
+    lens = CC_SAFE_MALLOC(ncount, int);
+    if (perm == (int *)NULL || lens == (int *)NULL) {
+        fprintf(stderr, "out of memory in CCkdtree_qboruvka_tour\n");
+        rval = 1;
+        goto CLEANUP;
+    }
+
+    for (k = 0; k < ncount; k++) {
+        i = kt->perm[k];
+        F.mate[i] = CCkdtree_node_nearest(kt, i, dat);
+        lens[i] = CCutil_dat_edgelen(i, F.mate[i], dat);
+        perm[k] = i;
+    }
+    CCutil_int_perm_quicksort(perm, lens, ncount);
+
+    count = 0;
+    live = ncount;
+    while (count < ncount - 1) {
+        for (k = 0; k < live && count < ncount - 1; k++) {
+            i = perm[k];
+            if (F.deg[i] == 2)
+                continue;
+            j = F.mate[i];
+            if (F.deg[j] == 2 || j == F.tail[i]) {
+                j = fragment_nearest(kt, i, &F, dat);
+                F.mate[i] = j;
+            }
+            join_fragments(&F, i, j);
+            count++;
+            if (F.deg[i] == 2)
+                CCkdtree_delete(kt, i);
+            if (F.deg[j] == 2)
+                CCkdtree_delete(kt, j);
+        }
+        for (k = 0, j = 0; k < live; k++) {
+            if (F.deg[perm[k]] < 2)
+                perm[j++] = perm[k];
+        }
+        live = j;
+    }
+
+    close_tour(&F, ncount, dat, outcycle, val);
+
+CLEANUP:
+
+    CC_IFFREE(perm, int);
+    CC_IFFREE(lens, int);
+    free_fragments(&F);
+    if (newtree)
+        CCkdtree_free(kt);
+    else
+        CCkdtree_undelete_all(kt, ncount);
+    return rval;
+}
+
+int CCkdtree_spacefill_tour(int ncount, CCdatagroup *dat, int *outcycle,
+                            double *val) {
+    int rval = 0;
+    int i, side = 1 << HILBERT_BITS;
+    int *perm = (int *)NULL, *keys = (int *)NULL;
+    double xmin, xmax, ymin, ymax, scale;
+
+    if (ncount < 3) {
+        fprintf(stderr, "Cannot find tour in an %d node graph\n", ncount);
+        return 1;
+    }
+    if (dat->x == (double *)NULL || dat->y == (double *)NULL) {
+        fprintf(stderr, "Cannot run spacefill with norm %d\n", dat->norm);
+        return 1;
+    }
+
+    perm = CC_SAFE_MALLOC(ncount, int);
+    keys = CC_SAFE_MALLOC(ncount, int);
+    if (perm == (int *)NULL || keys == (int *)NULL) {
+        fprintf(stderr, "out of memory in CCkdtree_spacefill_tour\n");
+        rval = 1;
+        goto CLEANUP;
+    }
+
+    xmin = xmax = dat->x[0];
+    ymin = ymax = dat->y[0];
+    for (i = 1; i < ncount; i++) {
+        if (dat->x[i] < xmin)
+            xmin = dat->x[i];
+        else if (dat->x[i] > xmax)
+            xmax = dat->x[i];
+        if (dat->y[i] < ymin)
+            ymin = dat->y[i];
+        else if (dat->y[i] > ymax)
+            ymax = dat->y[i];
+    }
+    /* One scale for both axes, so the curve sees the real proportions */
+    scale = (xmax - xmin > ymax - ymin) ? xmax - xmin : ymax - ymin;
+    scale = (scale > 0.0) ? (side - 1) / scale : 0.0;
+
+    for (i = 0; i < ncount; i++) {
+        perm[i] = i;
+        keys[i] = hilbert_key(side, (int)((dat->x[i] - xmin) * scale),
+                              (int)((dat->y[i] - ymin) * scale));
+    }
+    CCutil_int_perm_quicksort(perm, keys, ncount);
+
+    *val = (double)CCutil_dat_edgelen(perm[ncount - 1], perm[0], dat);
+    for (i = 1; i < ncount; i++)
+        *val += (double)CCutil_dat_edgelen(perm[i - 1], perm[i], dat);
+    if (outcycle != (int *)NULL) {
+        for (i = 0; i < ncount; i++)
+            outcycle[i] = perm[i];
+    }
+
+CLEANUP:
+
+    CC_IFFREE(perm, int);
+    CC_IFFREE(keys, int);
+    return rval;
+}
+
+/* The position of (x, y) along the Hilbert curve through a side x side */
+/* grid (side a power of 2).                                             */
+static int hilbert_key(int side, int x, int y) {
+    int s, rx, ry, temp;
+    int d = 0;
+
+    for (s = side / 2; s > 0; s /= 2) {
+        rx = (x & s) > 0;
+        ry = (y & s) > 0;
+        d += s * s * ((3 * rx) ^ ry);
+        if (ry == 0) {
+            if (rx == 1) {
+                x = side - 1 - x;
+                y = side - 1 - y;
+            }
+            CC_SWAP(x, y, temp);
+        }
+    }
+    return d;
+}
+
+static int init_fragments(fragments *F, int ncount) {
+    int i;
+
+    F->deg = CC_SAFE_MALLOC(ncount, int);
+    F->tail = CC_SAFE_MALLOC(ncount, int);
+    F->mate = CC_SAFE_MALLOC(ncount, int);
+    F->adj = CC_SAFE_MALLOC(2 * ncount, int);
+    if (F->deg == (int *)NULL || F->tail == (int *)NULL ||
+        F->mate == (int *)NULL || F->adj == (int *)NULL) {
+        fprintf(stderr, "out of memory in init_fragments\n");
+        return 1;
+    }
+    for (i = 0; i < ncount; i++) {
+        F->deg[i] = 0;
+        F->tail[i] = i;
+        F->adj[2 * i] = F->adj[2 * i + 1] = -1;
+    }
+    return 0;
+}
+
+static void free_fragments(fragments *F) {
+    CC_IFFREE(F->deg, int);
+    CC_IFFREE(F->tail, int);
+    CC_IFFREE(F->mate, int);
+    CC_IFFREE(F->adj, int);
+}
+
+/* The nearest path end outside n's own fragment; while more than one */
+/* fragment is left there always is one.                              */
+static int fragment_nearest(CCkdtree *kt, int n, fragments *F,
+                            CCdatagroup *dat) {
+    int m, t = F->tail[n];
+
+    if (t != n)
+        CCkdtree_delete(kt, t);
+    m = CCkdtree_node_nearest(kt, n, dat);
+    if (t != n)
+        CCkdtree_undelete(kt, t);
+    return m;
+}
+
+static void join_fragments(fragments *F, int i, int j) {
+    int ti = F->tail[i], tj = F->tail[j];
+
+    F->adj[2 * i + F->deg[i]++] = j;
+    F->adj[2 * j + F->deg[j]++] = i;
+    F->tail[ti] = tj;
+    F->tail[tj] = ti;
+}
+
+/* Joins the ends of the one path left and walks the cycle */
+static void close_tour(fragments *F, int ncount, CCdatagroup *dat,
+                       int *outcycle, double *val) {
+    int i, prev, cur, next;
+
+    for (i = 0; F->deg[i] == 2; i++)
+        ;
+    join_fragments(F, i, F->tail[i]);
+
+    *val = 0.0;
+    prev = -1;
+    cur = 0;
+    for (i = 0; i < ncount; i++) {
+        if (outcycle != (int *)NULL)
+            outcycle[i] = cur;
+        next = (F->adj[2 * cur] != prev) ? F->adj[2 * cur]
+                                          : F->adj[2 * cur + 1];
+        *val += (double)CCutil_dat_edgelen(cur, next, dat);
+        prev = cur;
+        cur = next;
+    }
+}
@@ -31,6 +31,14 @@
 /*    initializes flipper to an initial cycle given in cyc.                 */
 /*    returns 0 on success, nonzero on failure.                             */
 /*                                                                          */
+/*  void CClinkern_flipper_clear (CClk_flipper *f)                          */
+/*    sets f to an empty flipper that owns no space.                        */
+/*                                                                          */
+/*  int CClinkern_flipper_reset (CClk_flipper *f, int ncount, int *cyc)     */
+/*    like CClinkern_flipper_init, but f must already be initialized or     */
+/*    cleared; its space is reused and only grown when ncount needs more.   */
+/*    returns 0 on success, nonzero on failure.                             */
+/*                                                                          */
 /*  void CClinkern_flipper_cycle (CClk_flipper *F, int *x)                  */
 /*    places the current cycle in x.                                        */
 /*                                                                          */
@@ -47,6 +55,8 @@
 /*                                                                          */
 /*  void CClinkern_flipper_flip (CClk_flipper *F, int x, int y)             */
 /*    flips the portion of the cycle from x to y (inclusive).               */
+/*    If F->counting is nonzero, F->flips and F->splits count the flips     */
+/*    and the segment splits since F was initialized or cleared.            */
 /*                                                                          */
 /*  int CClinkern_flipper_sequence (CClk_flipper *f, int * x, int y,        */
 /*      int z)                                                              */
@@ -94,12 +104,18 @@ static int build_flipper(CClk_flipper *Fl, int ncount);
       (((F->reversed) ^ (a->parent->rev)) && a->id >= b->id)))
 
 int CClinkern_flipper_init(CClk_flipper *F, int ncount, int *cyc) {
+    init_flipper(F);
+    return CClinkern_flipper_reset(F, ncount, cyc);
+}
+
+void CClinkern_flipper_clear(CClk_flipper *F) { init_flipper(F); }
+
+int CClinkern_flipper_reset(CClk_flipper *F, int ncount, int *cyc) {
     int i, j, cind, remain;
     int rval = 0;
     CClk_childnode *c, *cprev;
     CClk_parentnode *p;
 
-    init_flipper(F);
     rval = build_flipper(F, ncount);
     if (rval) {
         fprintf(stderr, "build_flipper failed\n");
@@ -190,6 +206,9 @@ void CClinkern_flipper_flip(CClk_flipper *F, int x, int y) {
     CClk_childnode *xc = &(F->children[x]);
     CClk_childnode *yc = &(F->children[y]);
 
+    if (F->counting)
+        F->flips++;
+
     if (SAME_SEGMENT(xc, yc)) {
         if (xc != yc) {
             same_segment_flip(F, xc, yc);
@@ -415,6 +434,9 @@ static void segment_split(CClk_flipper *F, CClk_parentnode *p,
     CClk_parentnode *pnext;
     CClk_childnode *b, *bnext;
 
+    if (F->counting)
+        F->splits++;
+
     if (dir)
         side = p->ends[1]->id - aprev->id + 1;
     else
@@ -587,6 +609,11 @@ static void init_flipper(CClk_flipper *Fl) {
     Fl->nsegments = 0;
     Fl->groupsize = 100;
     Fl->split_cutoff = 100;
+    Fl->parents_space = 0;
+    Fl->children_space = 0;
+    Fl->counting = 0;
+    Fl->flips = 0.0;
+    Fl->splits = 0.0;
 }
 
 static void free_flipper(CClk_flipper *Fl) {
@@ -597,6 +624,8 @@ static void free_flipper(CClk_flipper *Fl) {
         Fl->nsegments = 0;
         Fl->groupsize = 0;
         Fl->split_cutoff = 0;
+        Fl->parents_space = 0;
+        Fl->children_space = 0;
     }
 }
 
@@ -605,22 +634,33 @@ static int build_flipper(CClk_flipper *Fl, int ncount) {
 
     Fl->reversed = 0;
     Fl->groupsize = (int)(sqrt((double)ncount) * GROUPSIZE_FACTOR);
+    if (Fl->groupsize < 1)
+        Fl->groupsize = 1;
     Fl->nsegments = (ncount + Fl->groupsize - 1) / Fl->groupsize;
     Fl->split_cutoff = Fl->groupsize * SEGMENT_SPLIT_CUTOFF;
 
-    Fl->parents = CC_SAFE_MALLOC(Fl->nsegments, CClk_parentnode);
-    Fl->children = CC_SAFE_MALLOC(ncount + 1, CClk_childnode);
+    if (Fl->nsegments > Fl->parents_space) {
+        if (CCutil_reallocrus_count((void **)&Fl->parents, Fl->nsegments,
+                                    sizeof(CClk_parentnode))) {
+            rval = 1;
+            goto CLEANUP;
+        }
+        Fl->parents_space = Fl->nsegments;
+    }
     /* The +1 will stop a purify burp later */
-    if (Fl->parents == (CClk_parentnode *)NULL ||
-        Fl->children == (CClk_childnode *)NULL) {
-        fprintf(stderr, "out of memory in build_flipper\n");
-        rval = 1;
-        goto CLEANUP;
+    if (ncount + 1 > Fl->children_space) {
+        if (CCutil_reallocrus_count((void **)&Fl->children, ncount + 1,
+                                    sizeof(CClk_childnode))) {
+            rval = 1;
+            goto CLEANUP;
+        }
+        Fl->children_space = ncount + 1;
     }
 
 CLEANUP:
 
     if (rval) {
+        fprintf(stderr, "out of memory in build_flipper\n");
         free_flipper(Fl);
     }
     return rval;
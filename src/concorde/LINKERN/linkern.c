@@ -30,7 +30,8 @@
 /*      int *elist, int stallcount, int repeatcount, int *incycle,          */
 /*      int *outcycle, double *val                                          */
 /*      int silent, double time_bound, double length_bound,                 */
-/*      char *saveit_name, int kicktype, CCrandstate *rstate)               */
+/*      char *saveit_name, int kicktype, CCrandstate *rstate,               */
+/*      CClk_workspace *ws, const CClk_control *ctl)                        */
 /*    RUNS Chained Lin-Kernighan.                                           */
 /*    -ncount (the number of nodes int the graph)                           */
 /*    -dat (coordinate dat)                                                 */
@@ -41,40 +42,101 @@
 /*    -incycle (a starting cycle, in node node node format - can be NULL)   */
 /*    -outcycle (returns the cycle - can be NULL)                           */
 /*    -run_slightly (if nonzero, then very little info will be printed)     */
-/*    -time_bound (if postive, then the search will stop after the kick     */
-/*       that puts the running time above this number of seconds)           */
+/*    -time_bound (if postive, then the search will stop once the running   */
+/*       time is above this number of seconds; the wall clock is checked    */
+/*       before every kick and every STOP_CHECK steps of an LK pass)        */
 /*    -length_bound (if postive, then the search will stop after the kick   */
 /*       that puts the tour at or below this length)                        */
 /*    -saveit_name (if non NULL then the tour will be saved to this file    */
 /*       after every 10000 kicks - if it has improved)                      */
 /*    -kicktype (specifies the type of kick used - should be one of         */
 /*       CC_LK_RANDOM_KICK, CC_LK_GEOMETRIC_KICK, CC_LK_CLOSE_KICK, or      */
-/*       CC_LK_WALK_KICK)                                                   */
+/*       CC_LK_WALK_KICK; geometric kicks search a kdtree, so other than    */
+/*       KD-norms get close kicks instead)                                  */
+/*    -ws (a workspace from CClinkern_workspace_alloc whose space is        */
+/*       reused across calls - can be NULL)                                 */
+/*    -ctl (hooks into the search - can be NULL); if ctl->cancel is set,    */
+/*       it is read with the clock and the search stops with the best       */
+/*       tour so far once it is nonzero; if ctl->improved is set, it is     */
+/*       called with the length and the cycle of the best tour whenever it  */
+/*       improves, at most once per ctl->improved_interval seconds (the     */
+/*       last improvement is always reported); a nonzero return stops the   */
+/*       search; ctl->search sets how deep and wide moves are searched      */
+/*       (NULL ctl gets CC_LK_SEARCH_DEFAULT); if ctl->stats is set, its    */
+/*       fields from initial_time to dist_misses are filled in at the end   */
+/*       (flips, splits and cache lookups are only counted in that case)    */
 /*                                                                          */
 /*    NOTES: If incycle is NULL, then a random starting cycle is used. If   */
 /*     outcycle is not NULL, then it should point to an array of length     */
-/*     at least ncount.                                                     */
+/*     at least ncount. If ws is NULL, a temporary workspace is used.       */
+/*                                                                          */
+/*  int CClinkern_path (int ncount, CCdatagroup *dat, int ecount,           */
+/*      int *elist, int stallcount, int repeatcount, int *inpath,           */
+/*      int *outpath, double *val, int silent, double time_bound,           */
+/*      double length_bound, int kicktype, CCrandstate *rstate,             */
+/*      CClk_workspace *ws, const CClk_control *ctl)                        */
+/*    RUNS Chained Lin-Kernighan on Hamiltonian paths with fixed ends.      */
+/*    -inpath (a starting path, in node node node format; its first and     */
+/*       last nodes are the ends of every path tried)                       */
+/*    -outpath (returns the path, starting at inpath[0])                    */
+/*    -val (returns the length of the path)                                 */
+/*    The other arguments are as in CClinkern_tour (length_bound bounds     */
+/*    the path length).                                                     */
+/*                                                                          */
+/*    NOTES: The path is closed by a fixed edge from its last node back to  */
+/*     its first; no move or kick ever removes a fixed edge.                */
+/*                                                                          */
+/*  int CClinkern_fixed (int ncount, CCdatagroup *dat, int ecount,          */
+/*      int *elist, int stallcount, int repeatcount, int *incycle,          */
+/*      int *outcycle, double *val, int fcount, int *flist, int silent,     */
+/*      double time_bound, double length_bound, int kicktype,               */
+/*      CCrandstate *rstate, CClk_workspace *ws, const CClk_control *ctl)   */
+/*    RUNS Chained Lin-Kernighan on tours that contain a set of edges.      */
+/*    -fcount (the number of fixed edges)                                   */
+/*    -flist (the fixed edges in end1 end2 format)                          */
+/*    The other arguments are as in CClinkern_tour.                         */
+/*                                                                          */
+/*    NOTES: The fixed edges must form node-disjoint paths (or a single     */
+/*     tour through all ncount nodes). The fixed paths are spliced into     */
+/*     incycle (or a random cycle) in the order their nodes first appear,   */
+/*     and no move or kick ever removes a fixed edge.                       */
+/*                                                                          */
+/*  void CClinkern_init_control (CClk_control *ctl)                         */
+/*    SETS a control with no hooks and the default search.                  */
+/*                                                                          */
+/*  void CClinkern_search_preset (CClk_search *search, int preset)          */
+/*    SETS search to one of CC_LK_SEARCH_DEFAULT (depth 25, the first four  */
+/*    levels trying 4, 3, 3 and 2 flips), CC_LK_SEARCH_FAST (depth 10,      */
+/*    trying 3 and 2) or CC_LK_SEARCH_DEEP (depth 50, trying 5, 4, 3, 3     */
+/*    and 2). These three have their own compiled copies of the inner       */
+/*    search; other settings run a slower copy that reads search as it      */
+/*    goes.                                                                 */
+/*                                                                          */
+/*  int CClinkern_workspace_alloc (CClk_workspace **ws)                     */
+/*    ALLOCATES an empty workspace; its arrays grow to the largest          */
+/*    instance passed to CClinkern_tour and are kept until freed.           */
+/*                                                                          */
+/*  void CClinkern_workspace_free (CClk_workspace *ws)                      */
+/*    FREES a workspace and everything it holds (ws can be NULL).           */
 /*                                                                          */
 /****************************************************************************/
 
+#include "kdtree.h"
 #include "linkern.h"
 #include "machdefs.h"
 #include "macrorus.h"
 #include "util.h"
 
-#define MAXDEPTH 25 /* Shouldn't really be less than 2.             */
-#define KICK_MAXDEPTH 50
 #define IMPROVE_SWITCH -1 /* When to start using IMPROVE_KICKS (-1 never) */
 #define LONG_KICKER
 #define ACCEPT_TIES
 #undef ACCEPT_BAD_TOURS
 
-#define USE_LESS_OR_EQUAL
 #define SUBTRACT_GSTAR
 #undef SWITCH_LATE
-#define LATE_DEPTH 10 /* Should be less than MAXDEPTH                 */
+#define LATE_DEPTH 10 /* Should be less than the search maxdepth      */
 
-#define MAK_MORTON
+#define MAK_MORTON /* Compiled in; search.mak_morton turns it on  */
 #undef FULL_MAK_MORTON
 #undef NODE_INSERTIONS
 
@@ -82,11 +144,19 @@
 #undef MARK_NEIGHBORS    /* Mark the good-edge neighbors after swaps     */
 #define USE_LESS_MARKING /* Do not mark the tour neighbors after swaps   */
 #define MARK_LEVEL 10    /* Number of tour neighbors after 4-swap kick   */
-#define BACKTRACK 4
 #define MAX_BACK 12 /* Upper bound on the XXX_count entries         */
-static const int backtrack_count[BACKTRACK] = {4, 3, 3, 2};
+#define MAX_SEARCH_DEPTH 1000 /* Upper bound on the search depths       */
+#define TIME_CHECK 16 /* Kicks between looks at the clock (reports) */
+#define STOP_CHECK 16 /* LK steps between looks at the clock and cancel */
 static const int weird_backtrack_count[3] = {4, 3, 3};
 
+/* The CC_LK_SEARCH_ presets; each has its own compiled copy of step */
+static const CClk_search search_presets[3] = {
+    {25, 50, 4, {4, 3, 3, 2}, 1, 1},    /* CC_LK_SEARCH_DEFAULT */
+    {10, 25, 2, {3, 2}, 1, 1},          /* CC_LK_SEARCH_FAST */
+    {50, 50, 5, {5, 4, 3, 3, 2}, 1, 1}, /* CC_LK_SEARCH_DEEP */
+};
+
 #define BIGINT 2000000000
 #define Edgelen(n1, n2, D) dist(n1, n2, D)
 /*
@@ -122,6 +192,9 @@ static const int weird_backtrack_count[3] = {4, 3, 3};
 #define unmarkedge_del(n1, n2, E) E->del_edges[n1 ^ n2] = 0
 #define is_it_added(n1, n2, E) E->add_edges[n1 ^ n2]
 #define is_it_deleted(n1, n2, E) E->del_edges[n1 ^ n2]
+#define is_fixed(n1, n2, G)                                                    \
+    ((G)->fixcount &&                                                          \
+     ((G)->fixed[2 * (n1)] == (n2) || (G)->fixed[2 * (n1) + 1] == (n2)))
 
 typedef struct edge {
     int other;
@@ -160,16 +233,36 @@ typedef struct flipstack {
     flippair *stack;
     int counter;
     int max;
+    int space;
 } flipstack;
 
+struct graph;
+struct distobj;
+struct adddel;
+struct aqueue;
+
+typedef int (*stepfunc)(struct graph *G, struct distobj *D, struct adddel *E,
+                        struct aqueue *Q, CClk_flipper *F, int level, int gain,
+                        int *Gstar, int first, int last, flipstack *fstack,
+                        CCptrworld *intptr_world, CCptrworld *edgelook_world);
+
 typedef struct graph {
     edge **goodlist;
     edge *edgespace;
     int *degree;
     int *weirdmark;
     int weirdmagic;
+    int *fixed; /* the (at most 2) fixed tour neighbours of each node, or -1 */
+    int fixcount;
     int ncount;
+    int ncount_space;
+    int ecount_space;
+    CCkdtree *kdt; /* for geometric kicks, else NULL */
+    const CClk_search *search;
+    stepfunc step; /* the copy of step compiled for search, if any */
     CCrandstate *rstate;
+    const volatile int *cancel; /* stop once nonzero, can be NULL */
+    double deadline;            /* stop past this clock time, if positive */
 } graph;
 
 typedef struct distobj {
@@ -177,11 +270,16 @@ typedef struct distobj {
     int *cacheval;
     int *cacheind;
     int cacheM;
+    int cache_space;
+    int counting;   /* keep lookups and misses for CClk_stats */
+    double lookups;
+    double misses;
 } distobj;
 
 typedef struct adddel {
     char *add_edges;
     char *del_edges;
+    int space;
 } adddel;
 
 typedef struct aqueue {
@@ -189,14 +287,31 @@ typedef struct aqueue {
     intptr *active_queue;
     intptr *bottom_active_queue;
     CCdheap *h;
+    int space;
 } aqueue;
 
+struct CClk_workspace {
+    graph G;
+    distobj D;
+    adddel E;
+    aqueue Q;
+    CClk_flipper F;
+    flipstack fstack;
+    flipstack winstack;
+    int *tcyc;
+    int *win_cycle;
+    int *order;
+    int cycle_space;
+    CCptrworld intptr_world;
+    CCptrworld edgelook_world;
+    int intptr_supply;
+    int edgelook_supply;
+};
+
 static void lin_kernighan(graph *G, distobj *D, adddel *E, aqueue *Q,
                           CClk_flipper *F, double *val, int *win_cycle,
                           flipstack *w, flipstack *fstack,
                           CCptrworld *intptr_world, CCptrworld *edgelook_world),
-    look_ahead_noback(graph *G, distobj *D, adddel *E, CClk_flipper *F,
-                      int first, int last, int gain, edgelook *winner),
 #ifdef USE_HEAP
     turn(int n, aqueue *Q, CClk_flipper *F, distobj *D, graph *G),
 #else
@@ -215,12 +330,16 @@ static void lin_kernighan(graph *G, distobj *D, adddel *E, aqueue *Q,
                      int *t3, int *t4, int *t5, int *t6, int *t7, int *t8),
     find_close_four(graph *G, distobj *D, CClk_flipper *F, int *t1, int *t2,
                     int *t3, int *t4, int *t5, int *t6, int *t7, int *t8),
+    find_geometric_four(graph *G, distobj *D, CClk_flipper *F, int *t1,
+                        int *t2, int *t3, int *t4, int *t5, int *t6, int *t7,
+                        int *t8),
     find_walk_four(graph *G, distobj *D, CClk_flipper *F, int *t1, int *t2,
                    int *t3, int *t4, int *t5, int *t6, int *t7, int *t8),
     randcycle(int ncount, int *cyc, CCrandstate *rstate),
     insertedge(graph *G, int n1, int n2, int w), initgraph(graph *G),
     freegraph(graph *G), init_adddel(adddel *E), free_adddel(adddel *E),
     init_aqueue(aqueue *Q), free_aqueue(aqueue *Q, CCptrworld *intptr_world),
+    clear_aqueue(aqueue *Q, CCptrworld *intptr_world),
 #ifdef USE_HEAP
     add_to_active_queue(int n, aqueue *Q, distobj *D, graph *G,
                         CClk_flipper *F),
@@ -229,24 +348,30 @@ static void lin_kernighan(graph *G, distobj *D, adddel *E, aqueue *Q,
 #endif
     init_distobj(distobj *D), free_distobj(distobj *D),
     linkern_free_world(CCptrworld *intptr_world, CCptrworld *edgelook_world),
-    free_flipstack(flipstack *f);
+    init_flipstack(flipstack *f), free_flipstack(flipstack *f);
 
 static int buildgraph(graph *G, int ncount, int ecount, int *elist, distobj *D),
-    repeated_lin_kernighan(graph *G, distobj *D, int *cyc, int stallcount,
-                           int repeatcount, double *val, double time_bound,
-                           double length_bound, char *saveit_name, int silent,
-                           int kicktype, CCptrworld *intptr_world,
-                           CCptrworld *edgelook_world, CCrandstate *rstate),
+    stop_requested(const graph *G),
+    set_search(graph *G, const CClk_control *ctl),
+    set_fixed(graph *G, int fcount, const int *flist),
+    fixed_start(int ncount, int fcount, const int *flist, const int *incycle,
+                int *cyc, CCrandstate *rstate),
+    linkern_work(int ncount, CCdatagroup *dat, int ecount, int *elist,
+                 int stallcount, int repeatcount, int *incycle, int *outcycle,
+                 double *val, int silent, double time_bound,
+                 double length_bound, char *saveit_name, int kicktype,
+                 CCrandstate *rstate, CClk_workspace *ws,
+                 const CClk_control *ctl, int fcount, const int *flist),
+    repeated_lin_kernighan(CClk_workspace *ws, int *cyc, int stallcount,
+                           int repeatcount, double *val, double length_bound,
+                           char *saveit_name, int silent, int kicktype,
+                           CCrandstate *rstate, const CClk_control *ctl),
+    report_best(CClk_workspace *ws, const CClk_control *ctl, double best,
+                double *lastreport),
     weird_second_step(graph *G, distobj *D, adddel *E, aqueue *Q,
                       CClk_flipper *F, int gain, int t1, int t2,
                       flipstack *fstack, CCptrworld *intptr_world,
                       CCptrworld *edgelook_world),
-    step(graph *G, distobj *D, adddel *E, aqueue *Q, CClk_flipper *F, int level,
-         int gain, int *Gstar, int first, int last, flipstack *fstack,
-         CCptrworld *intptr_world, CCptrworld *edgelook_world),
-    step_noback(graph *G, distobj *D, adddel *E, aqueue *Q, CClk_flipper *F,
-                int level, int gain, int *Gstar, int first, int last,
-                flipstack *fstack, CCptrworld *intptr_world),
     kick_step_noback(graph *G, distobj *D, adddel *E, aqueue *Q,
                      CClk_flipper *F, int level, int gain, int *Gstar,
                      int first, int last, flipstack *win, flipstack *fstack,
@@ -260,7 +385,8 @@ static int buildgraph(graph *G, int ncount, int ecount, int *elist, distobj *D),
     pop_from_active_queue(aqueue *Q, CCptrworld *intptr_world),
     build_distobj(distobj *D, int ncount, CCdatagroup *dat),
     dist(int i, int j, distobj *D),
-    init_flipstack(flipstack *f, int total, int single);
+    build_flipstack(flipstack *f, int total, int single),
+    build_cycles(CClk_workspace *ws, int ncount);
 
 static double improve_tour(graph *G, distobj *D, adddel *E, aqueue *Q,
                            CClk_flipper *F, int start, flipstack *fstack,
@@ -270,11 +396,9 @@ static double improve_tour(graph *G, distobj *D, adddel *E, aqueue *Q,
                  flipstack *win, flipstack *fstack, CCptrworld *intptr_world),
     cycle_length(int ncount, int *cyc, distobj *D);
 
-static edgelook *look_ahead(graph *G, distobj *D, adddel *E, CClk_flipper *F,
-                            int first, int last, int gain, int level,
-                            CCptrworld *edgelook_world),
-    *weird_look_ahead(graph *G, distobj *D, CClk_flipper *F, int gain, int t1,
-                      int t2, CCptrworld *edgelook_world),
+static edgelook *weird_look_ahead(graph *G, distobj *D, CClk_flipper *F,
+                                  int gain, int t1, int t2,
+                                  CCptrworld *edgelook_world),
     *weird_look_ahead2(graph *G, distobj *D, CClk_flipper *F, int gain, int t2,
                        int t3, int t4, CCptrworld *edgelook_world),
     *weird_look_ahead3(graph *G, distobj *D, CClk_flipper *F, int gain, int t2,
@@ -292,24 +416,140 @@ int CClinkern_tour(int ncount, CCdatagroup *dat, int ecount, int *elist,
                    int stallcount, int repeatcount, int *incycle, int *outcycle,
                    double *val, int silent, double time_bound,
                    double length_bound, char *saveit_name, int kicktype,
-                   CCrandstate *rstate) {
+                   CCrandstate *rstate, CClk_workspace *ws,
+                   const CClk_control *ctl) {
+    return linkern_work(ncount, dat, ecount, elist, stallcount, repeatcount,
+                        incycle, outcycle, val, silent, time_bound,
+                        length_bound, saveit_name, kicktype, rstate, ws, ctl, 0,
+                        (const int *)NULL);
+}
+
+int CClinkern_path(int ncount, CCdatagroup *dat, int ecount, int *elist,
+                   int stallcount, int repeatcount, int *inpath, int *outpath,
+                   double *val, int silent, double time_bound,
+                   double length_bound, int kicktype, CCrandstate *rstate,
+                   CClk_workspace *ws, const CClk_control *ctl) {
     int rval = 0;
-    int i;
-    int *tcyc = (int *)NULL;
-    graph G;
-    distobj D;
-    CCptrworld intptr_world;
-    CCptrworld edgelook_world;
+    int i, p, dir;
+    int *cyc = (int *)NULL;
+    int ends[2];
+    double closing;
+
+    if (ncount <= 3) {
+        /* Only one path has these ends */
+        *val = 0.0;
+        for (i = 0; i < ncount; i++) {
+            outpath[i] = inpath[i];
+            if (i > 0)
+                *val += CCutil_dat_edgelen(inpath[i - 1], inpath[i], dat);
+        }
+        return 0;
+    }
 
-    initgraph(&G);
-    init_distobj(&D);
-    CCptrworld_init(&intptr_world);
-    CCptrworld_init(&edgelook_world);
-    G.rstate = rstate;
+    cyc = CC_SAFE_MALLOC(ncount, int);
+    if (cyc == (int *)NULL) {
+        fprintf(stderr, "out of memory in CClinkern_path\n");
+        rval = 1;
+        goto CLEANUP;
+    }
 
-    if (ncount < 10 && repeatcount > 0) {
-        printf("Less than 10 nodes, setting repeatcount to 0\n");
-        fflush(stdout);
+    /* Close the path with a fixed edge; the distances are left alone, so */
+    /* the candidate graph and the kicks see the real instance.           */
+    ends[0] = inpath[ncount - 1];
+    ends[1] = inpath[0];
+    closing = (double)CCutil_dat_edgelen(ends[0], ends[1], dat);
+    if (length_bound > 0.0)
+        length_bound += closing;
+
+    rval = linkern_work(ncount, dat, ecount, elist, stallcount, repeatcount,
+                        inpath, cyc, val, silent, time_bound, length_bound,
+                        (char *)NULL, kicktype, rstate, ws, ctl, 1, ends);
+    if (rval)
+        goto CLEANUP;
+
+    for (p = 0; cyc[p] != ends[1]; p++)
+        ;
+    dir = (cyc[(p + 1) % ncount] == ends[0]) ? ncount - 1 : 1;
+    for (i = 0; i < ncount; i++) {
+        outpath[i] = cyc[p];
+        p = (p + dir) % ncount;
+    }
+    *val -= closing;
+
+CLEANUP:
+
+    CC_IFFREE(cyc, int);
+    return rval;
+}
+
+int CClinkern_fixed(int ncount, CCdatagroup *dat, int ecount, int *elist,
+                    int stallcount, int repeatcount, int *incycle,
+                    int *outcycle, double *val, int fcount, int *flist,
+                    int silent, double time_bound, double length_bound,
+                    int kicktype, CCrandstate *rstate, CClk_workspace *ws,
+                    const CClk_control *ctl) {
+    int rval = 0;
+    int *cyc = (int *)NULL;
+
+    cyc = CC_SAFE_MALLOC(ncount, int);
+    if (cyc == (int *)NULL) {
+        fprintf(stderr, "out of memory in CClinkern_fixed\n");
+        rval = 1;
+        goto CLEANUP;
+    }
+
+    rval = fixed_start(ncount, fcount, flist, incycle, cyc, rstate);
+    if (rval)
+        goto CLEANUP;
+
+    rval = linkern_work(ncount, dat, ecount, elist, stallcount, repeatcount,
+                        cyc, outcycle, val, silent, time_bound, length_bound,
+                        (char *)NULL, kicktype, rstate, ws, ctl, fcount,
+                        flist);
+
+CLEANUP:
+
+    CC_IFFREE(cyc, int);
+    return rval;
+}
+
+static int linkern_work(int ncount, CCdatagroup *dat, int ecount, int *elist,
+                        int stallcount, int repeatcount, int *incycle,
+                        int *outcycle, double *val, int silent,
+                        double time_bound, double length_bound,
+                        char *saveit_name, int kicktype, CCrandstate *rstate,
+                        CClk_workspace *ws, const CClk_control *ctl,
+                        int fcount, const int *flist) {
+    int rval = 0;
+    int i;
+    int *tcyc;
+    double deadline = -1.0;
+    CClk_workspace *tmpws = (CClk_workspace *)NULL;
+    CCkdtree kdt;
+
+    kdt.nodespace = (CCkdnode *)NULL;
+    if (time_bound > 0.0)
+        deadline = CCutil_mono_zeit() + time_bound;
+
+    if (ws == (CClk_workspace *)NULL) {
+        rval = CClinkern_workspace_alloc(&tmpws);
+        if (rval)
+            goto CLEANUP;
+        ws = tmpws;
+    }
+    ws->G.rstate = rstate;
+    ws->G.cancel = (ctl != (const CClk_control *)NULL) ? ctl->cancel
+                                                       : (const int *)NULL;
+    ws->G.deadline = deadline;
+    rval = set_search(&ws->G, ctl);
+    if (rval)
+        goto CLEANUP;
+
+    if (ncount - fcount < 10 && repeatcount > 0) {
+        if (silent == 0) {
+            printf("Less than 10 free edges, setting repeatcount to 0\n");
+            fflush(stdout);
+        }
         repeatcount = 0;
     }
 
@@ -321,54 +561,69 @@ int CClinkern_tour(int ncount, CCdatagroup *dat, int ecount, int *elist,
             }
             kicktype = CC_LK_CLOSE_KICK;
         }
+    } else if (kicktype == CC_LK_GEOMETRIC_KICK) {
+        rval = CCkdtree_build(&kdt, ncount, dat, rstate);
+        if (rval) {
+            fprintf(stderr, "CCkdtree_build failed\n");
+            goto CLEANUP;
+        }
+        ws->G.kdt = &kdt;
     }
 
     /* These bulkalloc's allocate sufficient objects that the individual
      * allocs will not fail, and thus do not need to be tested */
-    rval = intptr_bulkalloc(&intptr_world, ncount);
-    if (rval) {
-        fprintf(stderr, "Unable to allocate initial intptrs\n");
-        goto CLEANUP;
+    if (ws->intptr_supply < ncount) {
+        rval = intptr_bulkalloc(&ws->intptr_world, ncount - ws->intptr_supply);
+        if (rval) {
+            fprintf(stderr, "Unable to allocate initial intptrs\n");
+            goto CLEANUP;
+        }
+        ws->intptr_supply = ncount;
     }
 
-    rval = edgelook_bulkalloc(&edgelook_world, MAX_BACK * (BACKTRACK + 3));
-    if (rval) {
-        fprintf(stderr, "Unable to allocate initial edgelooks\n");
-        goto CLEANUP;
+    if (ws->edgelook_supply == 0) {
+        rval = edgelook_bulkalloc(&ws->edgelook_world,
+                                  MAX_BACK * (CC_LK_MAX_BACKTRACK + 3));
+        if (rval) {
+            fprintf(stderr, "Unable to allocate initial edgelooks\n");
+            goto CLEANUP;
+        }
+        ws->edgelook_supply = MAX_BACK * (CC_LK_MAX_BACKTRACK + 3);
     }
 
-    tcyc = CC_SAFE_MALLOC(ncount, int);
-    if (tcyc == (int *)NULL) {
-        fprintf(stderr, "out of memory in linkern\n");
-        rval = 1;
+    rval = build_cycles(ws, ncount);
+    if (rval)
         goto CLEANUP;
-    }
+    tcyc = ws->tcyc;
 
-    rval = build_distobj(&D, ncount, dat);
+    rval = build_distobj(&ws->D, ncount, dat);
     if (rval)
         goto CLEANUP;
 
-    rval = buildgraph(&G, ncount, ecount, elist, &D);
+    rval = buildgraph(&ws->G, ncount, ecount, elist, &ws->D);
     if (rval) {
         fprintf(stderr, "buildgraph failed\n");
         goto CLEANUP;
     }
+    rval = set_fixed(&ws->G, fcount, flist);
+    if (rval)
+        goto CLEANUP;
 
     if (incycle) {
         for (i = 0; i < ncount; i++)
             tcyc[i] = incycle[i];
     } else {
-        randcycle(ncount, tcyc, G.rstate);
+        randcycle(ncount, tcyc, ws->G.rstate);
     }
-    *val = cycle_length(ncount, tcyc, &D);
+    *val = cycle_length(ncount, tcyc, &ws->D);
     if (silent == 0) {
         printf("Starting Cycle: %.0f\n", *val);
         fflush(stdout);
     }
 
-    rval = repeated_lin_kernighan(
-        &G, &D, tcyc, stallcount, repeatcount, val, time_bound, length_bound,
-        saveit_name, silent, kicktype, &intptr_world, &edgelook_world, rstate);
+    rval = repeated_lin_kernighan(ws, tcyc, stallcount, repeatcount, val,
+                                  length_bound, saveit_name, silent,
+                                  kicktype, rstate, ctl);
     if (rval) {
         fprintf(stderr, "repeated_lin_kernighan failed\n");
         goto CLEANUP;
@@ -381,81 +636,157 @@ int CClinkern_tour(int ncount, CCdatagroup *dat, int ecount, int *elist,
 
 CLEANUP:
 
-    CC_IFFREE(tcyc, int);
-    freegraph(&G);
-    free_distobj(&D);
-    linkern_free_world(&intptr_world, &edgelook_world);
-
+    if (kdt.nodespace != (CCkdnode *)NULL) {
+        CCkdtree_free(&kdt);
+        ws->G.kdt = (CCkdtree *)NULL;
+    }
+    CClinkern_workspace_free(tmpws);
     return rval;
 }
 
+void CClinkern_init_control(CClk_control *ctl) {
+    ctl->cancel = (const int *)NULL;
+    ctl->improved = NULL;
+    ctl->improved_arg = (void *)NULL;
+    ctl->improved_interval = 0.0;
+    ctl->stats = (CClk_stats *)NULL;
+    CClinkern_search_preset(&ctl->search, CC_LK_SEARCH_DEFAULT);
+}
+
+void CClinkern_search_preset(CClk_search *search, int preset) {
+    if (preset < CC_LK_SEARCH_DEFAULT || preset > CC_LK_SEARCH_DEEP)
+        preset = CC_LK_SEARCH_DEFAULT;
+    *search = search_presets[preset];
+}
+
+int CClinkern_workspace_alloc(CClk_workspace **ws) {
+    CClk_workspace *w;
+
+    *ws = (CClk_workspace *)NULL;
+    w = CC_SAFE_MALLOC(1, CClk_workspace);
+    if (w == (CClk_workspace *)NULL) {
+        fprintf(stderr, "out of memory in CClinkern_workspace_alloc\n");
+        return 1;
+    }
+
+    initgraph(&w->G);
+    init_distobj(&w->D);
+    init_adddel(&w->E);
+    init_aqueue(&w->Q);
+    CClinkern_flipper_clear(&w->F);
+    init_flipstack(&w->fstack);
+    init_flipstack(&w->winstack);
+    w->tcyc = (int *)NULL;
+    w->win_cycle = (int *)NULL;
+    w->order = (int *)NULL;
+    w->cycle_space = 0;
+    CCptrworld_init(&w->intptr_world);
+    CCptrworld_init(&w->edgelook_world);
+    w->intptr_supply = 0;
+    w->edgelook_supply = 0;
+
+    *ws = w;
+    return 0;
+}
+
+void CClinkern_workspace_free(CClk_workspace *ws) {
+    if (ws == (CClk_workspace *)NULL)
+        return;
+
+    freegraph(&ws->G);
+    free_distobj(&ws->D);
+    free_adddel(&ws->E);
+    free_aqueue(&ws->Q, &ws->intptr_world);
+    CClinkern_flipper_finish(&ws->F);
+    free_flipstack(&ws->fstack);
+    free_flipstack(&ws->winstack);
+    CC_IFFREE(ws->tcyc, int);
+    CC_IFFREE(ws->win_cycle, int);
+    CC_IFFREE(ws->order, int);
+    linkern_free_world(&ws->intptr_world, &ws->edgelook_world);
+    CC_FREE(ws, CClk_workspace);
+}
+
 #ifdef ACCEPT_BAD_TOURS
 #define HEAT_FACTOR 0.999
 #define HEAT_RESET 100000
 #endif
 
-static int repeated_lin_kernighan(graph *G, distobj *D, int *cyc,
+static int repeated_lin_kernighan(CClk_workspace *ws, int *cyc,
                                   int stallcount, int count, double *val,
-                                  double time_bound, double length_bound,
-                                  char *saveit_name, int silent, int kicktype,
-                                  CCptrworld *intptr_world,
-                                  CCptrworld *edgelook_world,
-                                  CCrandstate *rstate) {
+                                  double length_bound, char *saveit_name,
+                                  int silent, int kicktype,
+                                  CCrandstate *rstate,
+                                  const CClk_control *ctl) {
     int rval = 0;
     int round = 0;
     int newtree = 0;
     int quitcount, hit, delta;
-    int *win_cycle = (int *)NULL;
-    flipstack winstack, fstack;
+    graph *G = &ws->G;
+    distobj *D = &ws->D;
+    adddel *E = &ws->E;
+    aqueue *Q = &ws->Q;
+    CClk_flipper *F = &ws->F;
+    flipstack *winstack = &ws->winstack, *fstack = &ws->fstack;
+    CCptrworld *intptr_world = &ws->intptr_world;
+    CCptrworld *edgelook_world = &ws->edgelook_world;
+    int *win_cycle = ws->win_cycle;
+    int reporting = 0, pending = 0;
+    double lastreport = 0.0;
     double t, best = *val, oldbest = *val;
 #ifdef ACCEPT_BAD_TOURS
     double heat = *val / (20 * G->ncount), tdelta;
 #endif
     int ncount = G->ncount;
-    adddel E;
-    CClk_flipper F;
-    aqueue Q;
+    CClk_stats *stats = (CClk_stats *)NULL;
+    double flips = F->flips, splits = F->splits, stamp = 0.0;
+    int improving = 0, lastwin = 0;
+
+    if (ctl != (const CClk_control *)NULL) {
+        reporting = (ctl->improved != NULL);
+        stats = ctl->stats;
+    }
+    /* The counters sit on the hottest paths, so only keep them on request */
+    F->counting = D->counting = (stats != (CClk_stats *)NULL);
+    if (stats != (CClk_stats *)NULL)
+        stamp = CCutil_mono_zeit();
 
-    init_aqueue(&Q);
-    init_adddel(&E);
-    rval = build_aqueue(&Q, ncount, intptr_world);
+    rval = build_aqueue(Q, ncount, intptr_world);
     if (rval) {
         fprintf(stderr, "build_aqueue failed\n");
         goto CLEANUP;
     }
-    rval = build_adddel(&E, ncount);
+    rval = build_adddel(E, ncount);
     if (rval) {
         fprintf(stderr, "build_adddel failed\n");
         goto CLEANUP;
     }
 
-    hit = 2 * (MAXDEPTH + 7 + KICK_MAXDEPTH);
-    rval = init_flipstack(&fstack, hit, 0);
+    hit = 2 * (G->search->maxdepth + 7 + G->search->kick_maxdepth);
+    rval = build_flipstack(fstack, hit, 0);
     if (rval) {
-        fprintf(stderr, "init_flipstack failed\n");
+        fprintf(stderr, "build_flipstack failed\n");
         goto CLEANUP;
     }
-    rval = init_flipstack(&winstack, 500 + ncount / 50, hit);
+    rval = build_flipstack(winstack, 500 + ncount / 50, hit);
     if (rval) {
-        fprintf(stderr, "init_flipstack failed\n");
+        fprintf(stderr, "build_flipstack failed\n");
         goto CLEANUP;
     }
 
-    win_cycle = CC_SAFE_MALLOC(ncount, int);
-    if (win_cycle == (int *)NULL) {
-        fprintf(stderr, "out of memory in repeated_lin_kernighan\n");
-        rval = 1;
-        goto CLEANUP;
-    }
     win_cycle[0] = -1;
 
     quitcount = stallcount;
     if (quitcount > count)
         quitcount = count;
 
-    CClinkern_flipper_init(&F, ncount, cyc);
-    fstack.counter = 0;
-    winstack.counter = 0;
+    rval = CClinkern_flipper_reset(F, ncount, cyc);
+    if (rval) {
+        fprintf(stderr, "CClinkern_flipper_reset failed\n");
+        goto CLEANUP;
+    }
+    fstack->counter = 0;
+    winstack->counter = 0;
     win_cycle[0] = -1;
 
 #ifdef USE_HEAP
@@ -463,54 +794,60 @@ static int repeated_lin_kernighan(graph *G, distobj *D, int *cyc,
         int i;
 
         for (i = 0; i < ncount; i++) {
-            add_to_active_queue(i, &Q, D, G, &F);
+            add_to_active_queue(i, Q, D, G, F);
         }
     }
 #else
     {
-        int *tcyc = (int *)NULL;
+        int *order = ws->order;
         int i;
 
-        tcyc = CC_SAFE_MALLOC(ncount, int);
-        if (tcyc == (int *)NULL) {
-            fprintf(stderr, "out of memory in repeated_lin_kernighan\n");
-            rval = 1;
-            goto CLEANUP;
-        }
         /* init active_queue with random order */
-        randcycle(ncount, tcyc, G->rstate);
+        randcycle(ncount, order, G->rstate);
         for (i = 0; i < ncount; i++) {
-            add_to_active_queue(tcyc[i], &Q, intptr_world);
+            add_to_active_queue(order[i], Q, intptr_world);
         }
-        CC_IFFREE(tcyc, int);
     }
 #endif
 
-    lin_kernighan(G, D, &E, &Q, &F, &best, win_cycle, &winstack, &fstack,
+    lin_kernighan(G, D, E, Q, F, &best, win_cycle, winstack, fstack,
                   intptr_world, edgelook_world);
 
-    winstack.counter = 0;
+    if (stats != (CClk_stats *)NULL) {
+        t = CCutil_mono_zeit();
+        stats->initial_time = t - stamp;
+        stamp = t;
+    }
+
+    winstack->counter = 0;
     win_cycle[0] = -1;
 
+    if (reporting && report_best(ws, ctl, best, &lastreport)) {
+        quitcount = 0;
+    }
+
     while (round < quitcount) {
+        if (stop_requested(G)) {
+            break;
+        }
         hit = 0;
-        fstack.counter = 0;
+        fstack->counter = 0;
 
         if (IMPROVE_SWITCH == -1 || round < IMPROVE_SWITCH) {
-            rval = random_four_swap(G, D, &Q, &F, &delta, kicktype, &winstack,
-                                    &fstack, intptr_world, rstate);
+            rval = random_four_swap(G, D, Q, F, &delta, kicktype, winstack,
+                                    fstack, intptr_world, rstate);
             if (rval) {
                 fprintf(stderr, "random_four_swap failed\n");
                 goto CLEANUP;
             }
         } else {
-            delta = kick_improve(G, D, &E, &Q, &F, &winstack, &fstack,
+            delta = kick_improve(G, D, E, Q, F, winstack, fstack,
                                  intptr_world);
         }
 
-        fstack.counter = 0;
+        fstack->counter = 0;
         t = best + delta;
-        lin_kernighan(G, D, &E, &Q, &F, &t, win_cycle, &winstack, &fstack,
+        lin_kernighan(G, D, E, Q, F, &t, win_cycle, winstack, fstack,
                       intptr_world, edgelook_world);
 
 #ifdef ACCEPT_BAD_TOURS
@@ -532,7 +869,7 @@ static int repeated_lin_kernighan(graph *G, distobj *D, int *cyc,
         if (t < best) {
 #endif /* ACCEPT_TIES */
 #endif /* ACCEPT_BAD_TOURS */
-            winstack.counter = 0;
+            winstack->counter = 0;
             win_cycle[0] = -1;
             if (t < best) {
                 best = t;
@@ -540,6 +877,8 @@ static int repeated_lin_kernighan(graph *G, distobj *D, int *cyc,
                 if (quitcount > count)
                     quitcount = count;
                 hit++;
+                improving++;
+                lastwin = round + 1;
             }
 #ifdef ACCEPT_BAD_TOURS
             else {
@@ -549,20 +888,23 @@ static int repeated_lin_kernighan(graph *G, distobj *D, int *cyc,
 #endif
         } else {
             if (win_cycle[0] == -1) {
-                while (winstack.counter) {
-                    winstack.counter--;
+                while (winstack->counter) {
+                    winstack->counter--;
                     CClinkern_flipper_flip(
-                        &F, winstack.stack[winstack.counter].last,
-                        winstack.stack[winstack.counter].first);
+                        F, winstack->stack[winstack->counter].last,
+                        winstack->stack[winstack->counter].first);
                 }
             } else {
-                CClinkern_flipper_finish(&F);
-                CClinkern_flipper_init(&F, ncount, win_cycle);
-                while (winstack.counter) {
-                    winstack.counter--;
+                rval = CClinkern_flipper_reset(F, ncount, win_cycle);
+                if (rval) {
+                    fprintf(stderr, "CClinkern_flipper_reset failed\n");
+                    goto CLEANUP;
+                }
+                while (winstack->counter) {
+                    winstack->counter--;
                     CClinkern_flipper_flip(
-                        &F, winstack.stack[winstack.counter].last,
-                        winstack.stack[winstack.counter].first);
+                        F, winstack->stack[winstack->counter].last,
+                        winstack->stack[winstack->counter].first);
                 }
                 win_cycle[0] = -1;
             }
@@ -570,45 +912,83 @@ static int repeated_lin_kernighan(graph *G, distobj *D, int *cyc,
 
         round++;
 
+        if (reporting) {
+            pending |= hit;
+            if (pending && (hit || round % TIME_CHECK == 0) &&
+                CCutil_mono_zeit() - lastreport >= ctl->improved_interval) {
+                pending = 0;
+                if (report_best(ws, ctl, best, &lastreport)) {
+                    break;
+                }
+            }
+        }
+
         if (length_bound > 0.0 && best <= length_bound) {
             break;
         }
     }
+    if (pending) {
+        report_best(ws, ctl, best, &lastreport);
+    }
     if (silent == 0 && round > 0) {
         printf("%4d Total Steps.\n", round);
         fflush(stdout);
     }
 
-    CClinkern_flipper_cycle(&F, cyc);
-    CClinkern_flipper_finish(&F);
+    CClinkern_flipper_cycle(F, cyc);
 
     t = cycle_length(ncount, cyc, D);
     if (t != best) {
-        printf("WARNING: LK incremental counter was off by %.0f\n", t - best);
-        fflush(stdout);
+        fprintf(stderr, "WARNING: LK incremental counter was off by %.0f\n",
+                t - best);
         best = t;
     }
     *val = best;
 
+    if (stats != (CClk_stats *)NULL) {
+        stats->kick_time = CCutil_mono_zeit() - stamp;
+        stats->kicks = round;
+        stats->improving_kicks = improving;
+        stats->last_improvement = lastwin;
+        stats->flips = F->flips - flips;
+        stats->splits = F->splits - splits;
+        stats->dist_lookups = D->lookups;
+        stats->dist_misses = D->misses;
+    }
+
 CLEANUP:
 
-    free_aqueue(&Q, intptr_world);
-    free_adddel(&E);
-    free_flipstack(&fstack);
-    free_flipstack(&winstack);
-    CC_IFFREE(win_cycle, int);
+    clear_aqueue(Q, intptr_world);
     return rval;
 }
 
+/* ws->order is only needed while the queue is seeded, so it doubles as */
+/* the snapshot buffer; the flipper always holds the best tour here.    */
+static int report_best(CClk_workspace *ws, const CClk_control *ctl, double best,
+                       double *lastreport) {
+    CClinkern_flipper_cycle(&ws->F, ws->order);
+    *lastreport = CCutil_mono_zeit();
+    return ctl->improved(ctl->improved_arg, best, ws->G.ncount, ws->order);
+}
+
+static int stop_requested(const graph *G) {
+    if (G->cancel != (const int *)NULL && *G->cancel)
+        return 1;
+    return G->deadline > 0.0 && CCutil_mono_zeit() >= G->deadline;
+}
+
 static void lin_kernighan(graph *G, distobj *D, adddel *E, aqueue *Q,
                           CClk_flipper *F, double *val, int *win_cycle,
                           flipstack *win, flipstack *fstack,
                           CCptrworld *intptr_world,
                           CCptrworld *edgelook_world) {
-    int start, i;
+    int start, i, steps = 0;
     double delta, totalwin = 0.0;
 
     while (1) {
+        /* The tour is whole between steps, so the pass can end at any */
+        if (++steps % STOP_CHECK == 0 && stop_requested(G))
+            break;
         start = pop_from_active_queue(Q, intptr_world);
         if (start == -1)
             break;
@@ -656,11 +1036,14 @@ static double improve_tour(graph *G, distobj *D, adddel *E, aqueue *Q,
     int t2 = CClinkern_flipper_next(F, t1);
     int gain, Gstar = 0;
 
+    if (is_fixed(t1, t2, G))
+        return 0.0;
+
     gain = Edgelen(t1, t2, D);
     markedge_del(t1, t2, E);
 
-    if (step(G, D, E, Q, F, 0, gain, &Gstar, t1, t2, fstack, intptr_world,
-             edgelook_world) == 0) {
+    if (G->step(G, D, E, Q, F, 0, gain, &Gstar, t1, t2, fstack, intptr_world,
+                edgelook_world) == 0) {
         Gstar = weird_second_step(G, D, E, Q, F, gain, t1, t2, fstack,
                                   intptr_world, edgelook_world);
     }
@@ -673,236 +1056,98 @@ static double improve_tour(graph *G, distobj *D, adddel *E, aqueue *Q,
     return (double)Gstar;
 }
 
-static int step(graph *G, distobj *D, adddel *E, aqueue *Q, CClk_flipper *F,
-                int level, int gain, int *Gstar, int first, int last,
-                flipstack *fstack, CCptrworld *intptr_world,
-                CCptrworld *edgelook_world) {
-    int val, this, newlast, hit = 0, oldG = gain;
-#if defined(MAK_MORTON) && defined(FULL_MAK_MORTON)
-    int newfirst;
-#endif
-    edgelook *list, *e;
+#define LK_NAME(x) x##_default
+#define LK_MAXDEPTH (search_presets[CC_LK_SEARCH_DEFAULT].maxdepth)
+#define LK_BACKTRACK (search_presets[CC_LK_SEARCH_DEFAULT].backtrack)
+#define LK_BACKCOUNT(level)                                                    \
+    (search_presets[CC_LK_SEARCH_DEFAULT].backtrack_count[level])
+#define LK_MAK_MORTON (search_presets[CC_LK_SEARCH_DEFAULT].mak_morton)
+#define LK_LESS_OR_EQUAL (search_presets[CC_LK_SEARCH_DEFAULT].less_or_equal)
+#include "lksearch.h"
+
+#define LK_NAME(x) x##_fast
+#define LK_MAXDEPTH (search_presets[CC_LK_SEARCH_FAST].maxdepth)
+#define LK_BACKTRACK (search_presets[CC_LK_SEARCH_FAST].backtrack)
+#define LK_BACKCOUNT(level)                                                    \
+    (search_presets[CC_LK_SEARCH_FAST].backtrack_count[level])
+#define LK_MAK_MORTON (search_presets[CC_LK_SEARCH_FAST].mak_morton)
+#define LK_LESS_OR_EQUAL (search_presets[CC_LK_SEARCH_FAST].less_or_equal)
+#include "lksearch.h"
+
+#define LK_NAME(x) x##_deep
+#define LK_MAXDEPTH (search_presets[CC_LK_SEARCH_DEEP].maxdepth)
+#define LK_BACKTRACK (search_presets[CC_LK_SEARCH_DEEP].backtrack)
+#define LK_BACKCOUNT(level)                                                    \
+    (search_presets[CC_LK_SEARCH_DEEP].backtrack_count[level])
+#define LK_MAK_MORTON (search_presets[CC_LK_SEARCH_DEEP].mak_morton)
+#define LK_LESS_OR_EQUAL (search_presets[CC_LK_SEARCH_DEEP].less_or_equal)
+#include "lksearch.h"
+
+#define LK_NAME(x) x##_any
+#define LK_MAXDEPTH (G->search->maxdepth)
+#define LK_BACKTRACK (G->search->backtrack)
+#define LK_BACKCOUNT(level) (G->search->backtrack_count[level])
+#define LK_MAK_MORTON (G->search->mak_morton)
+#define LK_LESS_OR_EQUAL (G->search->less_or_equal)
+#include "lksearch.h"
+
+static int same_search(const CClk_search *s, const CClk_search *t) {
+    int i;
 
-    if (level >= BACKTRACK) {
-        return step_noback(G, D, E, Q, F, level, gain, Gstar, first, last,
-                           fstack, intptr_world);
+    if (s->maxdepth != t->maxdepth || s->kick_maxdepth != t->kick_maxdepth ||
+        s->backtrack != t->backtrack || s->mak_morton != t->mak_morton ||
+        s->less_or_equal != t->less_or_equal) {
+        return 0;
     }
-
-    list = look_ahead(G, D, E, F, first, last, gain, level, edgelook_world);
-    for (e = list; e; e = e->next) {
-#if defined(MAK_MORTON) && defined(FULL_MAK_MORTON)
-        if (e->mm) {
-            this = e->other;
-            newfirst = e->over;
-
-            gain = oldG - e->diff;
-            val = gain - Edgelen(newfirst, last, D);
-            if (val > *Gstar) {
-                *Gstar = val;
-                hit++;
-            }
-            FLIP(this, newfirst, first, last, fstack, F);
-
-            if (level < MAXDEPTH) {
-                markedge_add(first, this, E);
-                markedge_del(this, newfirst, E);
-                hit += step(G, D, E, Q, F, level + 1, gain, Gstar, newfirst,
-                            last, fstack, intptr_world, edgelook_world);
-                unmarkedge_add(first, this, E);
-                unmarkedge_del(this, newfirst, E);
-            }
-
-            if (!hit) {
-                UNFLIP(this, newfirst, first, last, fstack, F);
-            } else {
-                MARK(this, Q, F, D, G, intptr_world);
-                MARK(newfirst, Q, F, D, G, intptr_world);
-                edgelook_listfree(edgelook_world, list);
-                return 1;
-            }
-        } else
-#endif
-        {
-            this = e->other;
-            newlast = e->over;
-
-            gain = oldG - e->diff;
-            val = gain - Edgelen(newlast, first, D);
-            if (val > *Gstar) {
-                *Gstar = val;
-                hit++;
-            }
-
-            FLIP(first, last, newlast, this, fstack, F);
-
-            if (level < MAXDEPTH) {
-                markedge_add(last, this, E);
-                markedge_del(this, newlast, E);
-                hit += step(G, D, E, Q, F, level + 1, gain, Gstar, first,
-                            newlast, fstack, intptr_world, edgelook_world);
-                unmarkedge_add(last, this, E);
-                unmarkedge_del(this, newlast, E);
-            }
-
-            if (!hit) {
-                UNFLIP(first, last, newlast, this, fstack, F);
-            } else {
-                MARK(this, Q, F, D, G, intptr_world);
-                MARK(newlast, Q, F, D, G, intptr_world);
-                edgelook_listfree(edgelook_world, list);
-                return 1;
-            }
-        }
+    for (i = 0; i < s->backtrack; i++) {
+        if (s->backtrack_count[i] != t->backtrack_count[i])
+            return 0;
     }
-    edgelook_listfree(edgelook_world, list);
-    return 0;
+    return 1;
 }
 
-static int step_noback(graph *G, distobj *D, adddel *E, aqueue *Q,
-                       CClk_flipper *F, int level, int gain, int *Gstar,
-                       int first, int last, flipstack *fstack,
-                       CCptrworld *intptr_world) {
-    edgelook e;
+static int set_search(graph *G, const CClk_control *ctl) {
+    const CClk_search *s = &search_presets[CC_LK_SEARCH_DEFAULT];
+    int i;
 
-#ifdef SUBTRACT_GSTAR
-#ifdef SWITCH_LATE
-    if (level < LATE_DEPTH) {
-        look_ahead_noback(G, D, E, F, first, last, gain - *Gstar, &e);
-    } else {
-        look_ahead_noback(G, D, E, F, first, last, gain - *Gstar - level, &e);
+    if (ctl != (const CClk_control *)NULL)
+        s = &ctl->search;
+
+    if (s->maxdepth < 1 || s->maxdepth > MAX_SEARCH_DEPTH ||
+        s->kick_maxdepth < 0 || s->kick_maxdepth > MAX_SEARCH_DEPTH) {
+        fprintf(stderr, "search depths %d and %d are out of range\n",
+                s->maxdepth, s->kick_maxdepth);
+        return 1;
     }
-#else
-    look_ahead_noback(G, D, E, F, first, last, gain - *Gstar - level, &e);
-#endif /* SWITCH_LATE */
-#else
-#ifdef SWITCH_LATE
-    if (level < LATE_DEPTH) {
-        look_ahead_noback(G, D, E, F, first, last, gain, &e);
-    } else {
-        look_ahead_noback(G, D, E, F, first, last, gain - level, &e);
+    if (s->backtrack < 0 || s->backtrack > CC_LK_MAX_BACKTRACK) {
+        fprintf(stderr, "search backtrack %d is not in 0..%d\n",
+                s->backtrack, CC_LK_MAX_BACKTRACK);
+        return 1;
     }
-#else
-    look_ahead_noback(G, D, E, F, first, last, gain - level, &e);
-#endif /* SWITCH_LATE */
-#endif /* SUBTRACT_GSTAR */
-
-    if (e.diff < BIGINT) {
-#ifdef NODE_INSERTIONS
-        if (e.ni) {
-            int hit = 0;
-            int newlast = e.other;
-            int next = e.under;
-            int prev = e.over;
-            int val;
-
-            gain -= e.diff;
-            val = gain - Edgelen(newlast, first, D);
-
-            if (val > *Gstar) {
-                *Gstar = val;
-                hit++;
-            }
-
-            FLIP(first, last, newlast, next, fstack, F);
-            FLIP(newlast, prev, last, next, fstack, F);
-
-            if (level < MAXDEPTH) {
-                markedge_add(last, newlast, E);
-                markedge_add(next, prev, E);
-                markedge_del(newlast, prev, E);
-                markedge_del(newlast, next, E);
-                hit += step_noback(G, D, E, Q, F, level + 1, gain, Gstar, first,
-                                   newlast, fstack, intptr_world);
-                unmarkedge_add(last, newlast, E);
-                unmarkedge_add(next, prev, E);
-                unmarkedge_del(newlast, prev, E);
-                unmarkedge_del(newlast, next, E);
-            }
-
-            if (!hit) {
-                UNFLIP(newlast, prev, last, next, fstack, F);
-                UNFLIP(first, last, newlast, next, fstack, F);
-                return 0;
-            } else {
-                MARK(newlast, Q, F, D, G, intptr_world);
-                MARK(next, Q, F, D, G, intptr_world);
-                MARK(prev, Q, F, D, G, intptr_world);
-                return 1;
-            }
-        } else
-#endif /* NODE_INSERTIONS */
-        {
-#ifdef MAK_MORTON
-            if (e.mm) {
-                int hit = 0;
-                int this = e.other;
-                int newfirst = e.over;
-                int val;
-
-                gain -= e.diff;
-                val = gain - Edgelen(newfirst, last, D);
-                if (val > *Gstar) {
-                    *Gstar = val;
-                    hit++;
-                }
-                FLIP(this, newfirst, first, last, fstack, F);
-
-                if (level < MAXDEPTH) {
-                    markedge_add(first, this, E);
-                    markedge_del(this, newfirst, E);
-                    hit += step_noback(G, D, E, Q, F, level + 1, gain, Gstar,
-                                       newfirst, last, fstack, intptr_world);
-                    unmarkedge_add(first, this, E);
-                    unmarkedge_del(this, newfirst, E);
-                }
-
-                if (!hit) {
-                    UNFLIP(this, newfirst, first, last, fstack, F);
-                    return 0;
-                } else {
-                    MARK(this, Q, F, D, G, intptr_world);
-                    MARK(newfirst, Q, F, D, G, intptr_world);
-                    return 1;
-                }
-            } else
-#endif /* MAK_MORTON */
-            {
-                int hit = 0;
-                int this = e.other;
-                int newlast = e.over;
-                int val;
-
-                gain -= e.diff;
-                val = gain - Edgelen(newlast, first, D);
-                if (val > *Gstar) {
-                    *Gstar = val;
-                    hit++;
-                }
-
-                FLIP(first, last, newlast, this, fstack, F);
-
-                if (level < MAXDEPTH) {
-                    markedge_add(last, this, E);
-                    markedge_del(this, newlast, E);
-                    hit += step_noback(G, D, E, Q, F, level + 1, gain, Gstar,
-                                       first, newlast, fstack, intptr_world);
-                    unmarkedge_add(last, this, E);
-                    unmarkedge_del(this, newlast, E);
-                }
-
-                if (!hit) {
-                    UNFLIP(first, last, newlast, this, fstack, F);
-                    return 0;
-                } else {
-                    MARK(this, Q, F, D, G, intptr_world);
-                    MARK(newlast, Q, F, D, G, intptr_world);
-                    return 1;
-                }
-            }
+    for (i = 0; i < s->backtrack; i++) {
+        if (s->backtrack_count[i] < 1 || s->backtrack_count[i] > MAX_BACK) {
+            fprintf(stderr, "search backtrack_count %d is not in 1..%d\n",
+                    s->backtrack_count[i], MAX_BACK);
+            return 1;
         }
+    }
+    if ((s->mak_morton != 0 && s->mak_morton != 1) ||
+        (s->less_or_equal != 0 && s->less_or_equal != 1)) {
+        fprintf(stderr, "search mak_morton and less_or_equal must be 0 or 1\n");
+        return 1;
+    }
+
+    G->search = s;
+    if (same_search(s, &search_presets[CC_LK_SEARCH_DEFAULT])) {
+        G->step = step_default;
+    } else if (same_search(s, &search_presets[CC_LK_SEARCH_FAST])) {
+        G->step = step_fast;
+    } else if (same_search(s, &search_presets[CC_LK_SEARCH_DEEP])) {
+        G->step = step_deep;
     } else {
-        return 0;
+        G->step = step_any;
     }
+    return 0;
 }
 
 static double kick_improve(graph *G, distobj *D, adddel *E, aqueue *Q,
@@ -947,7 +1192,7 @@ static int kick_step_noback(graph *G, distobj *D, adddel *E, aqueue *Q,
         if (!is_it_deleted(last, this, E) && this != first &&
             this != lastnext) {
             prev = CClinkern_flipper_prev(F, this);
-            if (!is_it_added(this, prev, E)) {
+            if (!is_it_added(this, prev, E) && !is_fixed(this, prev, G)) {
                 val = goodlist[last][i].weight - Edgelen(this, prev, D);
                 if (val < winner.diff) {
                     winner.diff = val;
@@ -973,7 +1218,7 @@ static int kick_step_noback(graph *G, distobj *D, adddel *E, aqueue *Q,
             win->counter++;
         }
 
-        if (level < KICK_MAXDEPTH) {
+        if (level < G->search->kick_maxdepth) {
             markedge_add(last, this, E);
             markedge_del(this, newlast, E);
             kick_step_noback(G, D, E, Q, F, level + 1, gain, Gstar, first,
@@ -1030,8 +1275,8 @@ static int weird_second_step(graph *G, distobj *D, adddel *E, aqueue *Q,
                     FLIP(t2, t5, t3, t4, fstack, F);
 
                     markedge_del(t5, t6, E);
-                    hit = step(G, D, E, Q, F, 2, gain, &Gstar, t1, t6, fstack,
-                               intptr_world, edgelook_world);
+                    hit = G->step(G, D, E, Q, F, 2, gain, &Gstar, t1, t6,
+                                  fstack, intptr_world, edgelook_world);
                     unmarkedge_del(t5, t6, E);
 
                     if (!hit && Gstar)
@@ -1062,8 +1307,8 @@ static int weird_second_step(graph *G, distobj *D, adddel *E, aqueue *Q,
                     FLIP(t1, t3, t6, t2, fstack, F);
 
                     markedge_del(t5, t6, E);
-                    hit = step(G, D, E, Q, F, 2, gain, &Gstar, t1, t6, fstack,
-                               intptr_world, edgelook_world);
+                    hit = G->step(G, D, E, Q, F, 2, gain, &Gstar, t1, t6,
+                                  fstack, intptr_world, edgelook_world);
                     unmarkedge_del(t5, t6, E);
 
                     if (!hit && Gstar)
@@ -1105,8 +1350,8 @@ static int weird_second_step(graph *G, distobj *D, adddel *E, aqueue *Q,
 
                         markedge_add(t6, t7, E);
                         markedge_del(t7, t8, E);
-                        hit = step(G, D, E, Q, F, 3, gain, &Gstar, t1, t8,
-                                   fstack, intptr_world, edgelook_world);
+                        hit = G->step(G, D, E, Q, F, 3, gain, &Gstar, t1, t8,
+                                      fstack, intptr_world, edgelook_world);
                         unmarkedge_del(t6, t7, E);
                         unmarkedge_del(t7, t8, E);
 
@@ -1143,8 +1388,8 @@ static int weird_second_step(graph *G, distobj *D, adddel *E, aqueue *Q,
 
                         markedge_add(t6, t7, E);
                         markedge_del(t7, t8, E);
-                        hit = step(G, D, E, Q, F, 3, gain, &Gstar, t1, t8,
-                                   fstack, intptr_world, edgelook_world);
+                        hit = G->step(G, D, E, Q, F, 3, gain, &Gstar, t1, t8,
+                                      fstack, intptr_world, edgelook_world);
                         unmarkedge_add(t6, t7, E);
                         unmarkedge_del(t7, t8, E);
 
@@ -1186,179 +1431,6 @@ static int weird_second_step(graph *G, distobj *D, adddel *E, aqueue *Q,
     return 0;
 }
 
-static edgelook *look_ahead(graph *G, distobj *D, adddel *E, CClk_flipper *F,
-                            int first, int last, int gain, int level,
-                            CCptrworld *edgelook_world) {
-    edgelook *list = (edgelook *)NULL, *el;
-    int i, val;
-    int this, prev;
-    int lastnext = CClinkern_flipper_next(F, last);
-    int other[MAX_BACK], save[MAX_BACK];
-    int value[MAX_BACK + 1];
-#if defined(MAK_MORTON) && defined(FULL_MAK_MORTON)
-    int mm[MAX_BACK];
-#endif
-    int k, ahead = backtrack_count[level];
-    edge **goodlist = G->goodlist;
-
-    for (i = 0; i < ahead; i++) {
-        value[i] = BIGINT;
-#if defined(MAK_MORTON) && defined(FULL_MAK_MORTON)
-        mm[i] = 0;
-#endif
-    }
-    value[ahead] = -BIGINT;
-
-#ifdef USE_LESS_OR_EQUAL
-    for (i = 0; goodlist[last][i].weight <= gain; i++) {
-#else
-    for (i = 0; goodlist[last][i].weight < gain; i++) {
-#endif
-        this = goodlist[last][i].other;
-        if (!is_it_deleted(last, this, E) && this != first &&
-            this != lastnext) {
-            prev = CClinkern_flipper_prev(F, this);
-            if (!is_it_added(this, prev, E)) {
-                val = goodlist[last][i].weight - Edgelen(this, prev, D);
-                if (val < value[0]) {
-                    for (k = 0; value[k + 1] > val; k++) {
-                        value[k] = value[k + 1];
-                        other[k] = other[k + 1];
-                        save[k] = save[k + 1];
-                    }
-                    value[k] = val;
-                    other[k] = this;
-                    save[k] = prev;
-                }
-            }
-        }
-    }
-
-#if defined(MAK_MORTON) && defined(FULL_MAK_MORTON)
-    {
-        int firstprev = CClinkern_flipper_prev(F, first);
-        int next;
-
-#ifdef USE_LESS_OR_EQUAL
-        for (i = 0; goodlist[first][i].weight <= gain; i++) {
-#else
-        for (i = 0; goodlist[first][i].weight < gain; i++) {
-#endif
-            this = goodlist[first][i].other;
-            if (!is_it_deleted(first, this, E) && this != last &&
-                this != firstprev) {
-                next = CClinkern_flipper_next(F, this);
-                if (!is_it_added(this, next, E)) {
-                    val = goodlist[first][i].weight - Edgelen(this, next, D);
-                    if (val < value[0]) {
-                        for (k = 0; value[k + 1] > val; k++) {
-                            value[k] = value[k + 1];
-                            other[k] = other[k + 1];
-                            save[k] = save[k + 1];
-                            mm[k] = mm[k + 1];
-                        }
-                        value[k] = val;
-                        other[k] = this;
-                        save[k] = next;
-                        mm[k] = 1;
-                    }
-                }
-            }
-        }
-    }
-#endif
-
-    for (i = 0; i < ahead; i++) {
-        if (value[i] < BIGINT) {
-            el = edgelookalloc(edgelook_world);
-            el->diff = value[i];
-            el->other = other[i];
-            el->over = save[i];
-            el->next = list;
-#if defined(MAK_MORTON) && defined(FULL_MAK_MORTON)
-            el->mm = mm[i];
-#endif
-            list = el;
-        }
-    }
-
-    return list;
-}
-
-static void look_ahead_noback(graph *G, distobj *D, adddel *E, CClk_flipper *F,
-                              int first, int last, int gain, edgelook *winner) {
-    int val;
-    int this, prev;
-    int lastnext = CClinkern_flipper_next(F, last);
-    int i;
-#if defined(MAK_MORTON) || defined(NODE_INSERTIONS)
-    int next;
-#endif
-    edge **goodlist = G->goodlist;
-
-    winner->diff = BIGINT;
-    for (i = 0; goodlist[last][i].weight < gain; i++) {
-        this = goodlist[last][i].other;
-        if (!is_it_deleted(last, this, E) && this != first &&
-            this != lastnext) {
-            prev = CClinkern_flipper_prev(F, this);
-            if (!is_it_added(this, prev, E)) {
-                val = goodlist[last][i].weight - Edgelen(this, prev, D);
-                if (val < winner->diff) {
-                    winner->diff = val;
-                    winner->other = this;
-                    winner->over = prev;
-#ifdef MAK_MORTON
-                    winner->mm = 0;
-#endif
-#ifdef NODE_INSERTIONS
-                    winner->ni = 0;
-#endif
-                }
-#ifdef NODE_INSERTIONS
-                next = CClinkern_flipper_next(F, this);
-                if (!is_it_added(this, next, E) &&
-                    !is_it_deleted(prev, next, E)) {
-                    val += (Edgelen(next, prev, D) - Edgelen(this, next, D));
-                    if (val < winner->diff) {
-                        winner->diff = val;
-                        winner->other = this;
-                        winner->over = prev;
-                        winner->under = next;
-                        winner->ni = 1;
-                    }
-                }
-#endif
-            }
-        }
-    }
-#ifdef MAK_MORTON
-    {
-        int firstprev = CClinkern_flipper_prev(F, first);
-
-        for (i = 0; goodlist[first][i].weight < gain; i++) {
-            this = goodlist[first][i].other;
-            if (!is_it_deleted(first, this, E) && this != last &&
-                this != firstprev) {
-                next = CClinkern_flipper_next(F, this);
-                if (!is_it_added(this, next, E)) {
-                    val = goodlist[first][i].weight - Edgelen(this, next, D);
-                    if (val < winner->diff) {
-                        winner->diff = val;
-                        winner->other = this;
-                        winner->over = next;
-                        winner->mm = 1;
-#ifdef NODE_INSERTIONS
-                        winner->ni = 0;
-#endif
-                    }
-                }
-            }
-        }
-    }
-#endif
-}
-
 static edgelook *weird_look_ahead(graph *G, distobj *D, CClk_flipper *F,
                                   int gain, int t1, int t2,
                                   CCptrworld *edgelook_world) {
@@ -1367,6 +1439,7 @@ static edgelook *weird_look_ahead(graph *G, distobj *D, CClk_flipper *F,
     int other[MAX_BACK], save[MAX_BACK];
     int value[MAX_BACK + 1];
     int k, val, ahead;
+    int leq = G->search->less_or_equal;
     edge **goodlist = G->goodlist;
 
     list = (edgelook *)NULL;
@@ -1375,14 +1448,12 @@ static edgelook *weird_look_ahead(graph *G, distobj *D, CClk_flipper *F,
         value[i] = BIGINT;
     value[ahead] = -BIGINT;
 
-#ifdef USE_LESS_OR_EQUAL
-    for (i = 0; goodlist[t2][i].weight <= gain; i++) {
-#else
-    for (i = 0; goodlist[t2][i].weight < gain; i++) {
-#endif
+    for (i = 0; goodlist[t2][i].weight < gain + leq; i++) {
         this = goodlist[t2][i].other;
         if (this != t1) {
             next = CClinkern_flipper_next(F, this);
+            if (is_fixed(this, next, G))
+                continue;
             val = goodlist[t2][i].weight - Edgelen(this, next, D);
             if (val < value[0]) {
                 for (k = 0; value[k + 1] > val; k++) {
@@ -1419,6 +1490,7 @@ static edgelook *weird_look_ahead2(graph *G, distobj *D, CClk_flipper *F,
     int value[MAX_BACK + 1];
     int k, val;
     int ahead = weird_backtrack_count[1];
+    int leq = G->search->less_or_equal;
     edge **goodlist = G->goodlist;
     int *weirdmark = G->weirdmark;
     int weirdmagic = G->weirdmagic;
@@ -1427,17 +1499,13 @@ static edgelook *weird_look_ahead2(graph *G, distobj *D, CClk_flipper *F,
         value[i] = BIGINT;
     value[ahead] = -BIGINT;
 
-#ifdef USE_LESS_OR_EQUAL
-    for (i = 0; goodlist[t4][i].weight <= gain; i++) {
-#else
-    for (i = 0; goodlist[t4][i].weight < gain; i++) {
-#endif
+    for (i = 0; goodlist[t4][i].weight < gain + leq; i++) {
         t5 = goodlist[t4][i].other;
         if (weirdmark[t5] != weirdmagic) {
             if (CClinkern_flipper_sequence(F, t2, t5, t3)) {
                 t6 = CClinkern_flipper_prev(F, t5);
                 val = goodlist[t4][i].weight - Edgelen(t5, t6, D);
-                if (val < value[0]) {
+                if (val < value[0] && !is_fixed(t5, t6, G)) {
                     for (k = 0; value[k + 1] > val; k++) {
                         value[k] = value[k + 1];
                         other[k] = other[k + 1];
@@ -1453,7 +1521,7 @@ static edgelook *weird_look_ahead2(graph *G, distobj *D, CClk_flipper *F,
                 }
                 t6 = CClinkern_flipper_next(F, t5);
                 val = goodlist[t4][i].weight - Edgelen(t5, t6, D);
-                if (val < value[0]) {
+                if (val < value[0] && !is_fixed(t5, t6, G)) {
                     for (k = 0; value[k + 1] > val; k++) {
                         value[k] = value[k + 1];
                         other[k] = other[k + 1];
@@ -1470,7 +1538,7 @@ static edgelook *weird_look_ahead2(graph *G, distobj *D, CClk_flipper *F,
             } else {
                 t6 = CClinkern_flipper_prev(F, t5);
                 val = goodlist[t4][i].weight - Edgelen(t5, t6, D);
-                if (val < value[0]) {
+                if (val < value[0] && !is_fixed(t5, t6, G)) {
                     for (k = 0; value[k + 1] > val; k++) {
                         value[k] = value[k + 1];
                         other[k] = other[k + 1];
@@ -1513,6 +1581,7 @@ static edgelook *weird_look_ahead3(graph *G, distobj *D, CClk_flipper *F,
     int value[MAX_BACK + 1];
     int k, val;
     int ahead = weird_backtrack_count[2];
+    int leq = G->search->less_or_equal;
     edge **goodlist = G->goodlist;
     int *weirdmark = G->weirdmark;
     int weirdmagic = G->weirdmagic;
@@ -1521,17 +1590,13 @@ static edgelook *weird_look_ahead3(graph *G, distobj *D, CClk_flipper *F,
         value[i] = BIGINT;
     value[ahead] = -BIGINT;
 
-#ifdef USE_LESS_OR_EQUAL
-    for (i = 0; goodlist[t6][i].weight <= gain; i++) {
-#else
-    for (i = 0; goodlist[t6][i].weight < gain; i++) {
-#endif
+    for (i = 0; goodlist[t6][i].weight < gain + leq; i++) {
         t7 = goodlist[t6][i].other; /* Need t7 != t2, t3, t2next, t3prev */
         if (weirdmark[t7] != weirdmagic &&
             CClinkern_flipper_sequence(F, t2, t7, t3)) {
             t8 = CClinkern_flipper_prev(F, t7);
             val = goodlist[t6][i].weight - Edgelen(t7, t8, D);
-            if (val < value[0]) {
+            if (val < value[0] && !is_fixed(t7, t8, G)) {
                 for (k = 0; value[k + 1] > val; k++) {
                     value[k] = value[k + 1];
                     other[k] = other[k + 1];
@@ -1545,7 +1610,7 @@ static edgelook *weird_look_ahead3(graph *G, distobj *D, CClk_flipper *F,
             }
             t8 = CClinkern_flipper_next(F, t7);
             val = goodlist[t6][i].weight - Edgelen(t7, t8, D);
-            if (val < value[0]) {
+            if (val < value[0] && !is_fixed(t7, t8, G)) {
                 for (k = 0; value[k + 1] > val; k++) {
                     value[k] = value[k + 1];
                     other[k] = other[k + 1];
@@ -1603,6 +1668,9 @@ static int random_four_swap(graph *G, distobj *D, aqueue *Q, CClk_flipper *F,
     case CC_LK_CLOSE_KICK:
         find_close_four(G, D, F, &t1, &t2, &t3, &t4, &t5, &t6, &t7, &t8);
         break;
+    case CC_LK_GEOMETRIC_KICK:
+        find_geometric_four(G, D, F, &t1, &t2, &t3, &t4, &t5, &t6, &t7, &t8);
+        break;
     default:
         fprintf(stderr, "unknown kick type %d\n", kicktype);
         return 1;
@@ -1665,11 +1733,15 @@ static void first_kicker(graph *G, distobj *D, CClk_flipper *F, int *t1,
     int ncount = G->ncount;
     edge **goodlist = G->goodlist;
 
-    try1 = CCutil_lprand(G->rstate) % ncount;
-    next = CClinkern_flipper_next(F, try1);
-    prev = CClinkern_flipper_prev(F, try1);
-    nextl = Edgelen(try1, next, D);
-    prevl = Edgelen(try1, prev, D);
+    /* A fixed edge is never cut; its length is set to -1 so that the */
+    /* other tour edge at try1 is taken.                               */
+    do {
+        try1 = CCutil_lprand(G->rstate) % ncount;
+        next = CClinkern_flipper_next(F, try1);
+        prev = CClinkern_flipper_prev(F, try1);
+    } while (is_fixed(try1, next, G) && is_fixed(try1, prev, G));
+    nextl = is_fixed(try1, next, G) ? -1 : Edgelen(try1, next, D);
+    prevl = is_fixed(try1, prev, G) ? -1 : Edgelen(try1, prev, D);
     if (nextl >= prevl) {
         *t1 = try1;
         *t2 = next;
@@ -1684,8 +1756,10 @@ static void first_kicker(graph *G, distobj *D, CClk_flipper *F, int *t1,
         try1 = CCutil_lprand(G->rstate) % ncount;
         next = CClinkern_flipper_next(F, try1);
         prev = CClinkern_flipper_prev(F, try1);
-        nextl = Edgelen(try1, next, D);
-        prevl = Edgelen(try1, prev, D);
+        if (is_fixed(try1, next, G) && is_fixed(try1, prev, G))
+            continue;
+        nextl = is_fixed(try1, next, G) ? -1 : Edgelen(try1, next, D);
+        prevl = is_fixed(try1, prev, G) ? -1 : Edgelen(try1, prev, D);
         if (nextl >= prevl) {
             len = nextl - goodlist[try1][0].weight;
             if (len > best) {
@@ -1701,8 +1775,10 @@ static void first_kicker(graph *G, distobj *D, CClk_flipper *F, int *t1,
         }
     }
 #else  /* LONG_KICKER */
-    *t1 = CCutil_lprand(G->rstate) % G->ncount;
-    *t2 = CClinkern_flipper_next(F, *t1);
+    do {
+        *t1 = CCutil_lprand(G->rstate) % G->ncount;
+        *t2 = CClinkern_flipper_next(F, *t1);
+    } while (is_fixed(*t1, *t2, G));
 #endif /* LONG_KICKER */
 }
 
@@ -1715,20 +1791,20 @@ static void find_random_four(graph *G, distobj *D, CClk_flipper *F, int *t1,
     do {
         *t3 = CCutil_lprand(G->rstate) % ncount;
         *t4 = CClinkern_flipper_next(F, *t3);
-    } while (*t3 == *t1 || *t3 == *t2 || *t4 == *t1);
+    } while (*t3 == *t1 || *t3 == *t2 || *t4 == *t1 || is_fixed(*t3, *t4, G));
 
     do {
         *t5 = CCutil_lprand(G->rstate) % ncount;
         *t6 = CClinkern_flipper_next(F, *t5);
     } while (*t5 == *t1 || *t5 == *t2 || *t5 == *t3 || *t5 == *t4 ||
-             *t6 == *t1 || *t6 == *t3);
+             *t6 == *t1 || *t6 == *t3 || is_fixed(*t5, *t6, G));
 
     do {
         *t7 = CCutil_lprand(G->rstate) % ncount;
         *t8 = CClinkern_flipper_next(F, *t7);
     } while (*t7 == *t1 || *t7 == *t2 || *t7 == *t3 || *t7 == *t4 ||
              *t7 == *t5 || *t7 == *t6 || *t8 == *t1 || *t8 == *t3 ||
-             *t8 == *t5);
+             *t8 == *t5 || is_fixed(*t7, *t8, G));
 }
 
 #define HUNT_PORTION 0.03
@@ -1769,7 +1845,7 @@ TRYAGAIN:
             goto TRYAGAIN;
         s3 = trials[k--];
         s4 = CClinkern_flipper_next(F, s3);
-    } while (s3 == s1 || s3 == s2 || s4 == s1);
+    } while (s3 == s1 || s3 == s2 || s4 == s1 || is_fixed(s3, s4, G));
 
     do {
         if (k < 0)
@@ -1777,7 +1853,7 @@ TRYAGAIN:
         s5 = trials[k--];
         s6 = CClinkern_flipper_next(F, s5);
     } while (s5 == s1 || s5 == s2 || s5 == s3 || s5 == s4 || s6 == s1 ||
-             s6 == s3);
+             s6 == s3 || is_fixed(s5, s6, G));
 
     do {
         if (k < 0)
@@ -1785,7 +1861,58 @@ TRYAGAIN:
         s7 = trials[k--];
         s8 = CClinkern_flipper_next(F, s7);
     } while (s7 == s1 || s7 == s2 || s7 == s3 || s7 == s4 || s7 == s5 ||
-             s7 == s6 || s8 == s1 || s8 == s3 || s8 == s5);
+             s7 == s6 || s8 == s1 || s8 == s3 || s8 == s5 ||
+             is_fixed(s7, s8, G));
+
+    *t1 = s1;
+    *t2 = s2;
+    *t3 = s3;
+    *t4 = s4;
+    *t5 = s5;
+    *t6 = s6;
+    *t7 = s7;
+    *t8 = s8;
+}
+
+#define GEOMETRIC_NEAR 50 /* The kick's other ends are among these */
+
+/* Like find_close_four, but the other three ends are drawn from the    */
+/* GEOMETRIC_NEAR nearest points to s1 in the kdtree, rather than the   */
+/* nearest of a random sample.                                          */
+static void find_geometric_four(graph *G, distobj *D, CClk_flipper *F,
+                                int *t1, int *t2, int *t3, int *t4, int *t5,
+                                int *t6, int *t7, int *t8) {
+    int s1, s2, s3, s4, s5, s6, s7, s8;
+    int near[GEOMETRIC_NEAR];
+    int k, tries, ncount = G->ncount;
+
+    first_kicker(G, D, F, &s1, &s2);
+    k = (ncount - 1 < GEOMETRIC_NEAR) ? ncount - 1 : GEOMETRIC_NEAR;
+    k = CCkdtree_node_k_nearest(G->kdt, s1, k, D->dat, near);
+    tries = 3 * k;
+
+    do {
+        if (tries-- <= 0)
+            goto CLOSE;
+        s3 = near[CCutil_lprand(G->rstate) % k];
+        s4 = CClinkern_flipper_next(F, s3);
+    } while (s3 == s2 || s4 == s1 || is_fixed(s3, s4, G));
+
+    do {
+        if (tries-- <= 0)
+            goto CLOSE;
+        s5 = near[CCutil_lprand(G->rstate) % k];
+        s6 = CClinkern_flipper_next(F, s5);
+    } while (s5 == s2 || s5 == s3 || s5 == s4 || s6 == s1 || s6 == s3 ||
+             is_fixed(s5, s6, G));
+
+    do {
+        if (tries-- <= 0)
+            goto CLOSE;
+        s7 = near[CCutil_lprand(G->rstate) % k];
+        s8 = CClinkern_flipper_next(F, s7);
+    } while (s7 == s2 || s7 == s3 || s7 == s4 || s7 == s5 || s7 == s6 ||
+             s8 == s1 || s8 == s3 || s8 == s5 || is_fixed(s7, s8, G));
 
     *t1 = s1;
     *t2 = s2;
@@ -1795,6 +1922,12 @@ TRYAGAIN:
     *t6 = s6;
     *t7 = s7;
     *t8 = s8;
+    return;
+
+CLOSE:
+
+    /* Too few usable neighbors (tiny instances or many fixed edges) */
+    find_close_four(G, D, F, t1, t2, t3, t4, t5, t6, t7, t8);
 }
 
 #define WALK_STEPS 50
@@ -1851,7 +1984,9 @@ static void find_walk_four(graph *G, distobj *D, CClk_flipper *F, int *t1,
              s1 == s8 || s2 == s3 || s2 == s4 || s2 == s5 || s2 == s6 ||
              s2 == s7 || s2 == s8 || s3 == s5 || s3 == s6 || s3 == s7 ||
              s3 == s8 || s4 == s5 || s4 == s6 || s4 == s7 || s4 == s8 ||
-             s5 == s7 || s5 == s8 || s6 == s7 || s6 == s8);
+             s5 == s7 || s5 == s8 || s6 == s7 || s6 == s8 ||
+             is_fixed(s3, s4, G) || is_fixed(s5, s6, G) ||
+             is_fixed(s7, s8, G));
 
     *t1 = s1;
     *t2 = s2;
@@ -2019,7 +2154,16 @@ static void initgraph(graph *G) {
     G->degree = (int *)NULL;
     G->weirdmark = (int *)NULL;
     G->weirdmagic = 0;
+    G->fixed = (int *)NULL;
+    G->fixcount = 0;
     G->ncount = 0;
+    G->ncount_space = 0;
+    G->ecount_space = 0;
+    G->kdt = (CCkdtree *)NULL;
+    G->search = &search_presets[CC_LK_SEARCH_DEFAULT];
+    G->step = (stepfunc)NULL;
+    G->cancel = (const int *)NULL;
+    G->deadline = -1.0;
 }
 
 static void freegraph(graph *G) {
@@ -2028,8 +2172,12 @@ static void freegraph(graph *G) {
         CC_IFFREE(G->edgespace, edge);
         CC_IFFREE(G->degree, int);
         CC_IFFREE(G->weirdmark, int);
+        CC_IFFREE(G->fixed, int);
         G->weirdmagic = 0;
+        G->fixcount = 0;
         G->ncount = 0;
+        G->ncount_space = 0;
+        G->ecount_space = 0;
     }
 }
 
@@ -2039,15 +2187,29 @@ static int buildgraph(graph *G, int ncount, int ecount, int *elist,
     int n1, n2, w, i;
     edge *p;
 
-    G->goodlist = CC_SAFE_MALLOC(ncount, edge *);
-    G->degree = CC_SAFE_MALLOC(ncount, int);
-    G->weirdmark = CC_SAFE_MALLOC(ncount, int);
-    G->edgespace = CC_SAFE_MALLOC((2 * ecount) + ncount, edge);
-    if (G->goodlist == (edge **)NULL || G->degree == (int *)NULL ||
-        G->edgespace == (edge *)NULL) {
-        fprintf(stderr, "out of memory in buildgraph\n");
-        rval = 1;
-        goto CLEANUP;
+    if (ncount > G->ncount_space) {
+        if (CCutil_reallocrus_count((void **)&G->goodlist, ncount,
+                                    sizeof(edge *)) ||
+            CCutil_reallocrus_count((void **)&G->degree, ncount,
+                                    sizeof(int)) ||
+            CCutil_reallocrus_count((void **)&G->weirdmark, ncount,
+                                    sizeof(int)) ||
+            CCutil_reallocrus_count((void **)&G->fixed, 2 * ncount,
+                                    sizeof(int))) {
+            fprintf(stderr, "out of memory in buildgraph\n");
+            rval = 1;
+            goto CLEANUP;
+        }
+        G->ncount_space = ncount;
+    }
+    if ((2 * ecount) + ncount > G->ecount_space) {
+        if (CCutil_reallocrus_count((void **)&G->edgespace,
+                                    (2 * ecount) + ncount, sizeof(edge))) {
+            fprintf(stderr, "out of memory in buildgraph\n");
+            rval = 1;
+            goto CLEANUP;
+        }
+        G->ecount_space = (2 * ecount) + ncount;
     }
 
     for (i = 0; i < ncount; i++) {
@@ -2075,6 +2237,7 @@ static int buildgraph(graph *G, int ncount, int ecount, int *elist,
     }
     G->ncount = ncount;
     G->weirdmagic = 0;
+    G->fixcount = 0;
 
 CLEANUP:
 
@@ -2083,6 +2246,134 @@ CLEANUP:
     return rval;
 }
 
+static int set_fixed(graph *G, int fcount, const int *flist) {
+    int i, k, n1, n2, temp;
+    int *fixed = G->fixed;
+
+    for (i = 0; i < 2 * G->ncount; i++)
+        fixed[i] = -1;
+    G->fixcount = 0;
+
+    for (i = 0; i < fcount; i++) {
+        n1 = flist[2 * i];
+        n2 = flist[2 * i + 1];
+        for (k = 0; k < 2; k++) {
+            if (fixed[2 * n1] == -1) {
+                fixed[2 * n1] = n2;
+            } else if (fixed[2 * n1 + 1] == -1) {
+                fixed[2 * n1 + 1] = n2;
+            } else {
+                fprintf(stderr, "node %d is in more than 2 fixed edges\n", n1);
+                return 1;
+            }
+            CC_SWAP(n1, n2, temp);
+        }
+    }
+    G->fixcount = fcount;
+    return 0;
+}
+
+/* Builds a start cycle holding every fixed edge: the nodes are taken in */
+/* the order of incycle (or a random order) and each node not yet placed */
+/* brings its whole fixed path along, from one of the path's ends.       */
+static int fixed_start(int ncount, int fcount, const int *flist,
+                       const int *incycle, int *cyc, CCrandstate *rstate) {
+    int rval = 0;
+    int i, k, n, n1, n2, first, prev, next, temp;
+    int *adj = (int *)NULL, *order = (int *)NULL;
+    char *placed = (char *)NULL;
+
+    adj = CC_SAFE_MALLOC(2 * ncount, int);
+    order = CC_SAFE_MALLOC(ncount, int);
+    placed = CC_SAFE_MALLOC(ncount, char);
+    if (adj == (int *)NULL || order == (int *)NULL ||
+        placed == (char *)NULL) {
+        fprintf(stderr, "out of memory in fixed_start\n");
+        rval = 1;
+        goto CLEANUP;
+    }
+    for (i = 0; i < 2 * ncount; i++)
+        adj[i] = -1;
+    for (i = 0; i < ncount; i++)
+        placed[i] = 0;
+
+    for (i = 0; i < fcount; i++) {
+        n1 = flist[2 * i];
+        n2 = flist[2 * i + 1];
+        if (n1 < 0 || n1 >= ncount || n2 < 0 || n2 >= ncount || n1 == n2) {
+            fprintf(stderr, "bad fixed edge %d %d\n", n1, n2);
+            rval = 1;
+            goto CLEANUP;
+        }
+        for (k = 0; k < 2; k++) {
+            if (adj[2 * n1] == -1) {
+                adj[2 * n1] = n2;
+            } else if (adj[2 * n1 + 1] == -1 && adj[2 * n1] != n2) {
+                adj[2 * n1 + 1] = n2;
+            } else {
+                fprintf(stderr, "fixed edges at node %d are not a path\n",
+                        n1);
+                rval = 1;
+                goto CLEANUP;
+            }
+            CC_SWAP(n1, n2, temp);
+        }
+    }
+
+    if (incycle) {
+        for (i = 0; i < ncount; i++)
+            order[i] = incycle[i];
+    } else {
+        randcycle(ncount, order, rstate);
+    }
+
+#define FIXED_NEXT(n, prev)                                                    \
+    ((adj[2 * (n)] != (prev)) ? adj[2 * (n)] : adj[2 * (n) + 1])
+
+    k = 0;
+    for (i = 0; i < ncount; i++) {
+        if (placed[order[i]])
+            continue;
+
+        /* Find an end of the fixed path through order[i]; if the walk */
+        /* comes back to order[i], the fixed edges close a cycle.      */
+        first = order[i];
+        prev = -1;
+        for (n = first; (next = FIXED_NEXT(n, prev)) != -1; n = next) {
+            if (next == first)
+                break;
+            prev = n;
+        }
+        if (next != first)
+            first = n;
+
+        prev = -1;
+        n = first;
+        do {
+            cyc[k++] = n;
+            placed[n] = 1;
+            next = FIXED_NEXT(n, prev);
+            prev = n;
+            n = next;
+        } while (n != -1 && n != first);
+
+        if (n == first && k != ncount) {
+            fprintf(stderr, "fixed edges contain a subtour\n");
+            rval = 1;
+            goto CLEANUP;
+        }
+    }
+
+#undef FIXED_NEXT
+
+CLEANUP:
+
+    CC_IFFREE(adj, int);
+    CC_IFFREE(order, int);
+    CC_IFFREE(placed, char);
+    return rval;
+}
+
 static void insertedge(graph *G, int n1, int n2, int w) {
     int i;
     edge *e = G->goodlist[n1];
@@ -2110,15 +2401,23 @@ static void linkern_free_world(CCptrworld *intptr_world,
     CCptrworld_delete(edgelook_world);
 }
 
-static int init_flipstack(flipstack *f, int total, int single) {
+static void init_flipstack(flipstack *f) {
     f->counter = 0;
     f->max = 0;
+    f->space = 0;
     f->stack = (flippair *)NULL;
+}
 
-    f->stack = CC_SAFE_MALLOC(total + single, flippair);
-    if (f->stack == (flippair *)NULL) {
-        fprintf(stderr, "out of memory in init_flipstack\n");
-        return 1;
+static int build_flipstack(flipstack *f, int total, int single) {
+    f->counter = 0;
+
+    if (total + single > f->space) {
+        if (CCutil_reallocrus_count((void **)&f->stack, total + single,
+                                    sizeof(flippair))) {
+            fprintf(stderr, "out of memory in build_flipstack\n");
+            return 1;
+        }
+        f->space = total + single;
     }
     f->max = total;
 
@@ -2128,18 +2427,36 @@ static int init_flipstack(flipstack *f, int total, int single) {
 static void free_flipstack(flipstack *f) {
     f->counter = 0;
     f->max = 0;
+    f->space = 0;
     CC_IFFREE(f->stack, flippair);
 }
 
+static int build_cycles(CClk_workspace *ws, int ncount) {
+    if (ncount > ws->cycle_space) {
+        if (CCutil_reallocrus_count((void **)&ws->tcyc, ncount, sizeof(int)) ||
+            CCutil_reallocrus_count((void **)&ws->win_cycle, ncount,
+                                    sizeof(int)) ||
+            CCutil_reallocrus_count((void **)&ws->order, ncount,
+                                    sizeof(int))) {
+            fprintf(stderr, "out of memory in linkern\n");
+            return 1;
+        }
+        ws->cycle_space = ncount;
+    }
+    return 0;
+}
+
 static void init_adddel(adddel *E) {
     E->add_edges = (char *)NULL;
     E->del_edges = (char *)NULL;
+    E->space = 0;
 }
 
 static void free_adddel(adddel *E) {
     if (E) {
         CC_IFFREE(E->add_edges, char);
         CC_IFFREE(E->del_edges, char);
+        E->space = 0;
     }
 }
 
@@ -2152,12 +2469,14 @@ static int build_adddel(adddel *E, int ncount) {
         i++;
     M = (1 << i);
 
-    E->add_edges = CC_SAFE_MALLOC(M, char);
-    E->del_edges = CC_SAFE_MALLOC(M, char);
-    if (E->add_edges == (char *)NULL || E->del_edges == (char *)NULL) {
-        fprintf(stderr, "out of memory in build_adddel\n");
-        rval = 1;
-        goto CLEANUP;
+    if (M > E->space) {
+        if (CCutil_reallocrus_count((void **)&E->add_edges, M, sizeof(char)) ||
+            CCutil_reallocrus_count((void **)&E->del_edges, M, sizeof(char))) {
+            fprintf(stderr, "out of memory in build_adddel\n");
+            rval = 1;
+            goto CLEANUP;
+        }
+        E->space = M;
     }
     for (i = 0; i < M; i++) {
         E->add_edges[i] = 0;
@@ -2177,32 +2496,44 @@ static void init_aqueue(aqueue *Q) {
     Q->active_queue = (intptr *)NULL;
     Q->bottom_active_queue = (intptr *)NULL;
     Q->h = (CCdheap *)NULL;
+    Q->space = 0;
 }
 
-static void free_aqueue(aqueue *Q, CCptrworld *intptr_world) {
+/* Returns the queued intptrs to intptr_world but keeps the active array */
+static void clear_aqueue(aqueue *Q, CCptrworld *intptr_world) {
     if (Q) {
-        CC_IFFREE(Q->active, char);
         intptr_listfree(intptr_world, Q->active_queue);
         Q->active_queue = (intptr *)NULL;
         Q->bottom_active_queue = (intptr *)NULL;
         if (Q->h) {
             CCutil_dheap_free(Q->h);
-            Q->h = (CCdheap *)NULL;
+            CC_FREE(Q->h, CCdheap);
         }
     }
 }
 
+static void free_aqueue(aqueue *Q, CCptrworld *intptr_world) {
+    if (Q) {
+        clear_aqueue(Q, intptr_world);
+        CC_IFFREE(Q->active, char);
+        Q->space = 0;
+    }
+}
+
 static int build_aqueue(aqueue *Q, int ncount, CCptrworld *intptr_world) {
     int rval = 0;
     int i;
 
-    init_aqueue(Q);
+    clear_aqueue(Q, intptr_world);
 
-    Q->active = CC_SAFE_MALLOC(ncount, char);
-    if (Q->active == (char *)NULL) {
-        fprintf(stderr, "out of memory in build_aqueue\n");
-        rval = 1;
-        goto CLEANUP;
+    if (ncount > Q->space) {
+        if (CCutil_reallocrus_count((void **)&Q->active, ncount,
+                                    sizeof(char))) {
+            fprintf(stderr, "out of memory in build_aqueue\n");
+            rval = 1;
+            goto CLEANUP;
+        }
+        Q->space = ncount;
     }
     for (i = 0; i < ncount; i++)
         Q->active[i] = 0;
@@ -2295,6 +2626,10 @@ static void init_distobj(distobj *D) {
     D->cacheind = (int *)NULL;
     D->cacheval = (int *)NULL;
     D->cacheM = 0;
+    D->cache_space = 0;
+    D->counting = 0;
+    D->lookups = 0.0;
+    D->misses = 0.0;
 }
 
 static void free_distobj(distobj *D) {
@@ -2303,6 +2638,7 @@ static void free_distobj(distobj *D) {
         CC_IFFREE(D->cacheind, int);
         CC_IFFREE(D->cacheval, int);
         D->cacheM = 0;
+        D->cache_space = 0;
     }
 }
 
@@ -2310,8 +2646,9 @@ static int build_distobj(distobj *D, int ncount, CCdatagroup *dat) {
     int rval = 0;
     int i;
 
-    init_distobj(D);
     D->dat = dat;
+    D->lookups = 0.0;
+    D->misses = 0.0;
 
 #ifndef BENTLEY_CACHE
     i = 0;
@@ -2325,12 +2662,16 @@ static int build_distobj(distobj *D, int ncount, CCdatagroup *dat) {
     D->cacheM = (1 << i);
 #endif
 
-    D->cacheind = CC_SAFE_MALLOC(D->cacheM, int);
-    D->cacheval = CC_SAFE_MALLOC(D->cacheM, int);
-    if (D->cacheind == (int *)NULL || D->cacheval == (int *)NULL) {
-        fprintf(stderr, "out of memory in build_distobj\n");
-        rval = 1;
-        goto CLEANUP;
+    if (D->cacheM > D->cache_space) {
+        if (CCutil_reallocrus_count((void **)&D->cacheind, D->cacheM,
+                                    sizeof(int)) ||
+            CCutil_reallocrus_count((void **)&D->cacheval, D->cacheM,
+                                    sizeof(int))) {
+            fprintf(stderr, "out of memory in build_distobj\n");
+            rval = 1;
+            goto CLEANUP;
+        }
+        D->cache_space = D->cacheM;
     }
     for (i = 0; i < D->cacheM; i++) {
         D->cacheind[i] = -1;
@@ -2363,7 +2704,11 @@ static int dist(int i, int j, distobj *D) /* As in Bentley's kdtree paper */
     ind = i ^ j;
 #endif
 
+    if (D->counting)
+        D->lookups++;
     if (D->cacheind[ind] != i) {
+        if (D->counting)
+            D->misses++;
         D->cacheind[ind] = i;
         D->cacheval[ind] = CCutil_dat_edgelen(i, j, D->dat);
     }
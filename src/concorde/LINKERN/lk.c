@@ -28,76 +28,485 @@
 /****************************************************************************/
 
 #include "edgegen.h"
+#include "heldkarp.h"
+#include "kdtree.h"
 #include "linkern.h"
 #include "machdefs.h"
 #include "macrorus.h"
 #include "util.h"
 
 #define BIGDOUBLE (1e30)
+#define ALPHA_CANDS 5 /* alpha-nearest edges per node */
 
-#define LK_RANDOM (0)
-#define LK_NEIGHBOR (1)
-#define LK_GREEDY (2)
-#define LK_BORUVKA (3)
-#define LK_QBORUVKA (4)
+struct CCtsp_lkworkspace {
+    CClk_workspace *lk;
+    CCdatagroup dat; /* matrix norm, rows point into the caller's distarr */
+    int *incycle;
+    int *outcycle;
+    int space;
+};
 
-static int seed = 0;
-static int run_silently = 1;
-static int kick_type = CC_LK_WALK_KICK;
-static int tour_type = LK_QBORUVKA;
+static int run_lk(CCtsp_lkworkspace *ws, CCdatagroup *dat, unsigned int *route,
+                  const unsigned int *start, const int *pathends, int fcount,
+                  const int *flist, int ncount, int ecount, const int *elist,
+                  int stallcount, double length_bound,
+                  const CCtsp_lkconfig *cfg, double starttime, double *val),
+    build_candidates(int ncount, CCdatagroup *dat, int candtype, int silent,
+                     int *ecount, int **elist, CCrandstate *rstate),
+    start_tour(int ncount, CCdatagroup *dat, int starttype, int ecount,
+               const int *elist, int *outcycle, double *val, int silent,
+               CCrandstate *rstate),
+    grow_lkworkspace(CCtsp_lkworkspace *ws, int ncount),
+    lk_stopped(const CCtsp_lkconfig *cfg, double starttime);
+
+static void cycle_to_path(int ncount, const int *cyc, int s, int t, int *path);
+
+void CCtsp_init_lkconfig(CCtsp_lkconfig *cfg) {
+    cfg->seed = 0;
+    cfg->kicktype = CC_LK_WALK_KICK;
+    cfg->starttype = CC_LK_QBORUVKA_START;
+    cfg->candtype = CC_LK_NEAREST_CANDS;
+    cfg->silent = 1;
+    cfg->time_bound = -1.0;
+    CClinkern_init_control(&cfg->ctl);
+}
+
+int CCtsp_lkworkspace_alloc(CCtsp_lkworkspace **ws) {
+    CCtsp_lkworkspace *w;
+
+    *ws = (CCtsp_lkworkspace *)NULL;
+    w = CC_SAFE_MALLOC(1, CCtsp_lkworkspace);
+    if (w == (CCtsp_lkworkspace *)NULL) {
+        fprintf(stderr, "out of memory in CCtsp_lkworkspace_alloc\n");
+        return 1;
+    }
+    CCutil_init_datagroup(&w->dat);
+    CCutil_dat_setnorm(&w->dat, CC_MATRIXNORM);
+    w->incycle = (int *)NULL;
+    w->outcycle = (int *)NULL;
+    w->space = 0;
+    if (CClinkern_workspace_alloc(&w->lk)) {
+        CC_FREE(w, CCtsp_lkworkspace);
+        return 1;
+    }
+
+    *ws = w;
+    return 0;
+}
+
+void CCtsp_lkworkspace_free(CCtsp_lkworkspace *ws) {
+    if (ws == (CCtsp_lkworkspace *)NULL)
+        return;
+
+    CClinkern_workspace_free(ws->lk);
+    CCutil_freedatagroup(&ws->dat);
+    CC_IFFREE(ws->incycle, int);
+    CC_IFFREE(ws->outcycle, int);
+    CC_FREE(ws, CCtsp_lkworkspace);
+}
 
 int CCtsp_lk(const unsigned int *distarr, unsigned int *route,
-             unsigned int ncount, int stallcount, double length_bound) {
-    int k, rval;
-    double val;
-    int tempcount, *templist;
-    int *incycle = (int *)NULL, *outcycle = (int *)NULL;
+             unsigned int ncount, int stallcount, double length_bound,
+             const CCtsp_lkconfig *cfg) {
+    int len;
+    CCtsp_lkworkspace *ws;
+
+    if (CCtsp_lkworkspace_alloc(&ws))
+        return -1;
+    len = CCtsp_lk_ws(ws, distarr, route, ncount, stallcount, length_bound,
+                      cfg);
+    CCtsp_lkworkspace_free(ws);
+    return len;
+}
+
+/* Warm start: start must be a permutation of 0..ncount-1 (not checked). */
+/* It replaces the start tour, so only the candidate set is built.       */
+int CCtsp_lk_from(const unsigned int *distarr, const unsigned int *start,
+                  unsigned int *route, unsigned int ncount, int stallcount,
+                  double length_bound, const CCtsp_lkconfig *cfg) {
+    int rval;
+    double val, starttime = CCutil_mono_zeit();
+    CCtsp_lkworkspace *ws = (CCtsp_lkworkspace *)NULL;
+
+    rval = CCtsp_lkworkspace_alloc(&ws);
+    if (rval)
+        goto CLEANUP;
+    rval = grow_lkworkspace(ws, ncount);
+    if (rval)
+        goto CLEANUP;
+    CCutil_distarr_rows(distarr, ncount, ws->dat.adj);
+
+    rval = run_lk(ws, &ws->dat, route, start, (const int *)NULL, 0,
+                  (const int *)NULL, ncount, 0, (const int *)NULL, stallcount,
+                  length_bound, cfg, starttime, &val);
+
+CLEANUP:
+
+    CCtsp_lkworkspace_free(ws);
+    if (rval) {
+        return -1;
+    } else {
+        return (int)val;
+    }
+}
+
+/* Open path from node s to node t; route returns it starting at s and */
+/* the return value is the path length.                                */
+int CCtsp_lk_path(const unsigned int *distarr, unsigned int s,
+                  unsigned int t, unsigned int *route, unsigned int ncount,
+                  int stallcount, double length_bound,
+                  const CCtsp_lkconfig *cfg) {
+    int rval;
+    double val, starttime = CCutil_mono_zeit();
+    int ends[2];
+    CCtsp_lkworkspace *ws = (CCtsp_lkworkspace *)NULL;
+
+    ends[0] = (int)s;
+    ends[1] = (int)t;
+
+    rval = CCtsp_lkworkspace_alloc(&ws);
+    if (rval)
+        goto CLEANUP;
+    rval = grow_lkworkspace(ws, ncount);
+    if (rval)
+        goto CLEANUP;
+    CCutil_distarr_rows(distarr, ncount, ws->dat.adj);
+
+    rval = run_lk(ws, &ws->dat, route, (const unsigned int *)NULL, ends, 0,
+                  (const int *)NULL, ncount, 0, (const int *)NULL, stallcount,
+                  length_bound, cfg, starttime, &val);
+
+CLEANUP:
+
+    CCtsp_lkworkspace_free(ws);
+    if (rval) {
+        return -1;
+    } else {
+        return (int)val;
+    }
+}
+
+/* Tour through fcount fixed edges, given as node pairs in flist; every */
+/* edge in flist is in the returned route.                              */
+int CCtsp_lk_fixed(const unsigned int *distarr, int fcount,
+                   const unsigned int *flist, unsigned int *route,
+                   unsigned int ncount, int stallcount, double length_bound,
+                   const CCtsp_lkconfig *cfg) {
+    int rval;
+    double val, starttime = CCutil_mono_zeit();
+    CCtsp_lkworkspace *ws = (CCtsp_lkworkspace *)NULL;
+
+    rval = CCtsp_lkworkspace_alloc(&ws);
+    if (rval)
+        goto CLEANUP;
+    rval = grow_lkworkspace(ws, ncount);
+    if (rval)
+        goto CLEANUP;
+    CCutil_distarr_rows(distarr, ncount, ws->dat.adj);
+
+    rval = run_lk(ws, &ws->dat, route, (const unsigned int *)NULL,
+                  (const int *)NULL, fcount, (const int *)flist, ncount, 0,
+                  (const int *)NULL, stallcount, length_bound, cfg, starttime,
+                  &val);
+
+CLEANUP:
+
+    CCtsp_lkworkspace_free(ws);
+    if (rval) {
+        return -1;
+    } else {
+        return (int)val;
+    }
+}
+
+int CCtsp_lk_ws(CCtsp_lkworkspace *ws, const unsigned int *distarr,
+                unsigned int *route, unsigned int ncount, int stallcount,
+                double length_bound, const CCtsp_lkconfig *cfg) {
+    int rval;
+    double val, starttime = CCutil_mono_zeit();
+
+    rval = grow_lkworkspace(ws, ncount);
+    if (rval)
+        return -1;
+    CCutil_distarr_rows(distarr, ncount, ws->dat.adj);
+
+    rval = run_lk(ws, &ws->dat, route, (const unsigned int *)NULL,
+                  (const int *)NULL, 0, (const int *)NULL, ncount, 0,
+                  (const int *)NULL, stallcount, length_bound, cfg, starttime,
+                  &val);
+    if (rval) {
+        return -1;
+    } else {
+        return (int)val;
+    }
+}
+
+/* Runs one chain on a candidate set built once by CCtsp_lk_candidates.  */
+/* The set is only read, so concurrent chains (each with its own ws and */
+/* seed) may share it.                                                  */
+int CCtsp_lk_chain(CCtsp_lkworkspace *ws, const unsigned int *distarr,
+                   unsigned int *route, unsigned int ncount, int ecount,
+                   const int *elist, int stallcount, double length_bound,
+                   const CCtsp_lkconfig *cfg) {
+    int rval;
+    double val, starttime = CCutil_mono_zeit();
+
+    rval = grow_lkworkspace(ws, ncount);
+    if (rval)
+        return -1;
+    CCutil_distarr_rows(distarr, ncount, ws->dat.adj);
+
+    rval = run_lk(ws, &ws->dat, route, (const unsigned int *)NULL,
+                  (const int *)NULL, 0, (const int *)NULL, ncount, ecount,
+                  elist, stallcount, length_bound, cfg, starttime, &val);
+    if (rval) {
+        return -1;
+    } else {
+        return (int)val;
+    }
+}
+
+int CCtsp_lk_candidates(const unsigned int *distarr, unsigned int ncount,
+                        int *ecount, int **elist) {
+    int rval;
     CCdatagroup dat;
     CCrandstate rstate;
 
-    // Default values
-    int in_repeater = ncount;
-    double time_bound = -1.0;
-    int quadtry = 2;
+    *ecount = 0;
+    *elist = (int *)NULL;
+
+    CCutil_init_datagroup(&dat);
+    rval = CCutil_receive_distarr(distarr, ncount, &dat);
+    if (rval) {
+        fprintf(stderr, "CCutil_receive_distarr failed\n");
+        goto CLEANUP;
+    }
+    CCutil_sprand(0, &rstate);
+    rval = build_candidates(ncount, &dat, CC_LK_NEAREST_CANDS, 1, ecount, elist,
+                            &rstate);
+
+CLEANUP:
+
+    CCutil_freedatagroup(&dat);
+    return rval;
+}
+
+void CCtsp_lk_free_candidates(int *elist) { CC_IFFREE(elist, int); }
+
+/* The junk-norm k-nearest graph of distarr on nthreads threads (0 for  */
+/* the default), with the node weights wcoord (or NULL); elist is freed */
+/* by CCtsp_lk_free_candidates.                                         */
+int CCtsp_junk_k_nearest(const unsigned int *distarr, unsigned int ncount,
+                         int num, const double *wcoord, int nthreads,
+                         int *ecount, int **elist) {
+    int rval;
+    CCdatagroup dat;
 
-    CCutil_sprand(seed, &rstate);
+    *ecount = 0;
+    *elist = (int *)NULL;
 
     CCutil_init_datagroup(&dat);
     rval = CCutil_receive_distarr(distarr, ncount, &dat);
     if (rval) {
-        fprintf(stderr, "CCutil_receive_distarr_failed\n");
+        fprintf(stderr, "CCutil_receive_distarr failed\n");
         goto CLEANUP;
     }
+    rval = CCedgegen_junk_k_nearest(ncount, num, &dat, (double *)wcoord, 1,
+                                    ecount, elist, nthreads, 1);
 
-    incycle = CC_SAFE_MALLOC(ncount, int);
-    if (!incycle) {
-        rval = 1;
+CLEANUP:
+
+    CCutil_freedatagroup(&dat);
+    return rval;
+}
+
+int CCtsp_lk_coords(const double *x, const double *y, const double *z,
+                    int norm, unsigned int *route, unsigned int ncount,
+                    int stallcount, double length_bound,
+                    const CCtsp_lkconfig *cfg) {
+    int rval;
+    double val, starttime = CCutil_mono_zeit();
+    CCdatagroup dat;
+    CCtsp_lkworkspace *ws = (CCtsp_lkworkspace *)NULL;
+
+    CCutil_init_datagroup(&dat);
+    rval = CCutil_receive_coords(x, y, z, norm, ncount, &dat);
+    if (rval) {
+        fprintf(stderr, "CCutil_receive_coords failed\n");
         goto CLEANUP;
     }
 
-    if (CCedgegen_junk_k_nearest(ncount, 4 * quadtry, &dat, (double *)NULL, 1,
-                                 &tempcount, &templist, run_silently)) {
-        fprintf(stderr, "CCedgegen_junk_k_nearest failed\n");
-        rval = 1;
+    rval = CCtsp_lkworkspace_alloc(&ws);
+    if (rval)
         goto CLEANUP;
+    rval = grow_lkworkspace(ws, ncount);
+    if (rval)
+        goto CLEANUP;
+
+    rval = run_lk(ws, &dat, route, (const unsigned int *)NULL,
+                  (const int *)NULL, 0, (const int *)NULL, ncount, 0,
+                  (const int *)NULL, stallcount, length_bound, cfg, starttime,
+                  &val);
+
+CLEANUP:
+
+    CCtsp_lkworkspace_free(ws);
+    CCutil_freedatagroup(&dat);
+    if (rval) {
+        return -1;
+    } else {
+        return (int)val;
     }
-    if (CCedgegen_junk_qboruvka_tour(ncount, &dat, incycle, &val, tempcount,
-                                     templist, run_silently)) {
-        fprintf(stderr, "CCedgegen_junk_qboruvka_tour failed\n");
-        rval = 1;
+}
+
+static int grow_lkworkspace(CCtsp_lkworkspace *ws, int ncount) {
+    if (ncount > ws->space) {
+        if (CCutil_reallocrus_count((void **)&ws->dat.adj, ncount,
+                                    sizeof(int *)) ||
+            CCutil_reallocrus_count((void **)&ws->incycle, ncount,
+                                    sizeof(int)) ||
+            CCutil_reallocrus_count((void **)&ws->outcycle, ncount,
+                                    sizeof(int))) {
+            fprintf(stderr, "out of memory in grow_lkworkspace\n");
+            return 1;
+        }
+        ws->space = ncount;
+    }
+    return 0;
+}
+
+static int run_lk(CCtsp_lkworkspace *ws, CCdatagroup *dat, unsigned int *route,
+                  const unsigned int *start, const int *pathends, int fcount,
+                  const int *flist, int ncount, int ecount, const int *elist,
+                  int stallcount, double length_bound,
+                  const CCtsp_lkconfig *cfg, double starttime, double *val) {
+    int rval = 0;
+    CCtsp_lkconfig defaults;
+    int tempcount = 0, *templist = (int *)NULL;
+    int *incycle = ws->incycle, *outcycle = ws->outcycle;
+    CCrandstate rstate;
+    CClk_stats *stats;
+    double stamp = 0.0, t;
+
+    // Default values
+    int in_repeater = ncount;
+    double time_bound = -1.0;
+
+    if (cfg == (const CCtsp_lkconfig *)NULL) {
+        CCtsp_init_lkconfig(&defaults);
+        cfg = &defaults;
+    }
+    stats = cfg->ctl.stats;
+    if (stats != (CClk_stats *)NULL) {
+        memset(stats, 0, sizeof(CClk_stats));
+        stamp = CCutil_mono_zeit();
+        stats->load_time = stamp - starttime;
+    }
+
+    CCutil_sprand(cfg->seed, &rstate);
+
+    /* Once stopped, only the fixed edges still need a candidate set */
+    if (elist == (const int *)NULL &&
+        (fcount > 0 || !lk_stopped(cfg, starttime))) {
+        rval = build_candidates(ncount, dat, cfg->candtype, cfg->silent,
+                                &tempcount, &templist, &rstate);
+        if (rval)
+            goto CLEANUP;
+        ecount = tempcount;
+        elist = templist;
+    }
+    if (stats != (CClk_stats *)NULL) {
+        t = CCutil_mono_zeit();
+        stats->candidate_time = t - stamp;
+        stamp = t;
+    }
+
+    if (start != (const unsigned int *)NULL) {
+        *val = 0.0;
+        for (int i = 0; i < ncount; i++) {
+            incycle[i] = (int)start[i];
+            if (i > 0)
+                *val += CCutil_dat_edgelen(incycle[i - 1], incycle[i], dat);
+        }
+        *val += CCutil_dat_edgelen(incycle[ncount - 1], incycle[0], dat);
+    } else {
+        /* A random start needs no candidates and takes no time */
+        rval = start_tour(ncount, dat,
+                          lk_stopped(cfg, starttime) ? CC_LK_RANDOM_START
+                                                     : cfg->starttype,
+                          ecount, elist, incycle, val, cfg->silent, &rstate);
+        if (rval)
+            goto CLEANUP;
+    }
+    if (stats != (CClk_stats *)NULL)
+        stats->start_time = CCutil_mono_zeit() - stamp;
+
+    /* The bound covers the whole call, so charge the setup against it */
+    if (cfg->time_bound > 0.0) {
+        time_bound = cfg->time_bound - (CCutil_mono_zeit() - starttime);
+        if (time_bound <= 0.0)
+            time_bound = 1e-9;
+    }
+
+    /* Stopped already: hand back the start, unless edges must be fixed */
+    if (fcount == 0 && lk_stopped(cfg, starttime)) {
+        if (pathends != (const int *)NULL) {
+            cycle_to_path(ncount, incycle, pathends[0], pathends[1], outcycle);
+            *val = 0.0;
+            for (int i = 1; i < ncount; i++)
+                *val += CCutil_dat_edgelen(outcycle[i - 1], outcycle[i], dat);
+        } else {
+            /* Like the tours CClinkern_tour returns, start at node 0 */
+            int k = 0;
+            while (incycle[k] != 0)
+                k++;
+            for (int i = 0; i < ncount; i++)
+                outcycle[i] = incycle[(k + i) % ncount];
+        }
+        for (int i = 0; i < ncount; i++) {
+            route[i] = (unsigned int)outcycle[i];
+        }
         goto CLEANUP;
     }
 
-    outcycle = CC_SAFE_MALLOC(ncount, int);
-    if (!outcycle) {
-        rval = 1;
+    if (pathends != (const int *)NULL) {
+        cycle_to_path(ncount, incycle, pathends[0], pathends[1], outcycle);
+        if (CClinkern_path(ncount, dat, ecount, (int *)elist, stallcount,
+                           in_repeater, outcycle, incycle, val, cfg->silent,
+                           time_bound, length_bound, cfg->kicktype, &rstate,
+                           ws->lk, &cfg->ctl)) {
+            fprintf(stderr, "CClinkern_path failed\n");
+            rval = 1;
+            goto CLEANUP;
+        }
+        for (int i = 0; i < ncount; i++) {
+            route[i] = (unsigned int)incycle[i];
+        }
+        goto CLEANUP;
+    }
+
+    if (fcount > 0) {
+        /* CClinkern_fixed rebuilds the start around the fixed edges */
+        if (CClinkern_fixed(ncount, dat, ecount, (int *)elist, stallcount,
+                            in_repeater, incycle, outcycle, val, fcount,
+                            (int *)flist, cfg->silent, time_bound,
+                            length_bound, cfg->kicktype, &rstate, ws->lk,
+                            &cfg->ctl)) {
+            fprintf(stderr, "CClinkern_fixed failed\n");
+            rval = 1;
+            goto CLEANUP;
+        }
+        for (int i = 0; i < ncount; i++) {
+            route[i] = (unsigned int)outcycle[i];
+        }
         goto CLEANUP;
     }
 
-    if (CClinkern_tour(ncount, &dat, tempcount, templist, stallcount,
-                       in_repeater, incycle, outcycle, &val, run_silently,
-                       time_bound, length_bound, (char *)NULL, kick_type,
-                       &rstate)) {
+    /* CClinkern_tour only reads elist, so a shared list is safe here */
+    if (CClinkern_tour(ncount, dat, ecount, (int *)elist, stallcount,
+                       in_repeater, incycle, outcycle, val, cfg->silent,
+                       time_bound, length_bound, (char *)NULL, cfg->kicktype,
+                       &rstate, ws->lk, &cfg->ctl)) {
         fprintf(stderr, "CClinkern_tour failed\n");
         rval = 1;
         goto CLEANUP;
@@ -105,19 +514,168 @@ int CCtsp_lk(const unsigned int *distarr, unsigned int *route,
     for (int i = 0; i < ncount; i++) {
         route[i] = (unsigned int)outcycle[i];
     }
-    fflush(stdout);
 
 CLEANUP:
 
-#ifndef BIG_PROBLEM
+    if (stats != (CClk_stats *)NULL)
+        stats->process_peak_rss = CCutil_peak_memory();
     CC_IFFREE(templist, int);
-#endif
-    CC_IFFREE(incycle, int);
-    CC_IFFREE(outcycle, int);
-    CCutil_freedatagroup(&dat);
-    if (rval) {
-        return -1;
-    } else {
-        return (int)val;
+    return rval;
+}
+
+/* True once the caller has cancelled or the whole-call bound has passed */
+static int lk_stopped(const CCtsp_lkconfig *cfg, double starttime) {
+    if (cfg->ctl.cancel != (const volatile int *)NULL && *cfg->ctl.cancel)
+        return 1;
+    return cfg->time_bound > 0.0 &&
+           CCutil_mono_zeit() - starttime >= cfg->time_bound;
+}
+
+static int build_candidates(int ncount, CCdatagroup *dat, int candtype,
+                            int silent, int *ecount, int **elist,
+                            CCrandstate *rstate) {
+    int norm, rval, acount;
+    int *alist = (int *)NULL;
+    int quadtry = 2;
+    int nearnum = (ncount - 1 < 4 * quadtry) ? ncount - 1 : 4 * quadtry;
+
+    if (nearnum < 1) {
+        fprintf(stderr, "no candidate edges on %d nodes\n", ncount);
+        return 1;
+    }
+    CCutil_dat_getnorm(dat, &norm);
+
+    /* Geometric norms search a kdtree (or the x-sorted points), so no */
+    /* O(n^2) table is ever built; matrix norms fall back on the junk  */
+    /* code.                                                           */
+    switch (norm & CC_NORM_BITS) {
+    case CC_KD_NORM_TYPE:
+        if (CCkdtree_k_nearest((CCkdtree *)NULL, ncount, nearnum, dat, ecount,
+                               elist, silent, rstate)) {
+            fprintf(stderr, "CCkdtree_k_nearest failed\n");
+            return 1;
+        }
+        break;
+    case CC_X_NORM_TYPE:
+        if (CCedgegen_x_k_nearest(ncount, nearnum, dat, (double *)NULL, 1,
+                                  ecount, elist, silent)) {
+            fprintf(stderr, "CCedgegen_x_k_nearest failed\n");
+            return 1;
+        }
+        break;
+    default:
+        if (CCedgegen_junk_k_nearest(ncount, nearnum, dat, (double *)NULL, 1,
+                                     ecount, elist, 0, silent)) {
+            fprintf(stderr, "CCedgegen_junk_k_nearest failed\n");
+            return 1;
+        }
+        break;
+    }
+
+    /* The nearest graph is what the subgradient ascent runs on */
+    if (candtype == CC_LK_ALPHA_CANDS && ncount > ALPHA_CANDS + 1) {
+        rval = CCheldkarp_alpha_nearest(ncount, dat, *ecount, *elist,
+                                        ALPHA_CANDS, &acount, &alist,
+                                        (double *)NULL, silent);
+        if (rval) {
+            fprintf(stderr, "CCheldkarp_alpha_nearest failed\n");
+            CC_FREE(*elist, int);
+            return 1;
+        }
+        CC_FREE(*elist, int);
+        *ecount = acount;
+        *elist = alist;
+    }
+    return 0;
+}
+
+static int start_tour(int ncount, CCdatagroup *dat, int starttype, int ecount,
+                      const int *elist, int *outcycle, double *val, int silent,
+                      CCrandstate *rstate) {
+    int norm, type, temp;
+    int rval = 0;
+
+    CCutil_dat_getnorm(dat, &norm);
+    type = norm & CC_NORM_BITS;
+
+    /* The curve is laid over the 2D points of a kdtree norm; the X-norms */
+    /* and matrices get quick-boruvka instead, like geometric kicks do    */
+    if (starttype == CC_LK_SPACEFILL_START && type != CC_KD_NORM_TYPE)
+        starttype = CC_LK_QBORUVKA_START;
+
+    switch (starttype) {
+    case CC_LK_RANDOM_START:
+        for (int i = 0; i < ncount; i++)
+            outcycle[i] = i;
+        for (int i = ncount - 1; i > 0; i--) {
+            int j = CCutil_lprand(rstate) % (i + 1);
+            CC_SWAP(outcycle[i], outcycle[j], temp);
+        }
+        *val = 0.0;
+        for (int i = 0; i < ncount; i++)
+            *val += CCutil_dat_edgelen(outcycle[i], outcycle[(i + 1) % ncount],
+                                       dat);
+        break;
+    case CC_LK_NEIGHBOR_START: {
+        int start = CCutil_lprand(rstate) % ncount;
+        if (type == CC_KD_NORM_TYPE)
+            rval = CCkdtree_nearest_neighbor_tour((CCkdtree *)NULL, ncount,
+                                                  start, dat, outcycle, val,
+                                                  rstate);
+        else if (type == CC_X_NORM_TYPE)
+            rval = CCedgegen_x_nearest_neighbor_tour(ncount, start, dat,
+                                                     outcycle, val);
+        else
+            rval = CCedgegen_junk_nearest_neighbor_tour(ncount, start, dat,
+                                                        outcycle, val, silent);
+        break;
+    }
+    case CC_LK_GREEDY_START:
+        if (type == CC_KD_NORM_TYPE)
+            rval = CCkdtree_greedy_tour((CCkdtree *)NULL, ncount, dat, outcycle,
+                                        val, silent, rstate);
+        else if (type == CC_X_NORM_TYPE)
+            rval = CCedgegen_x_greedy_tour(ncount, dat, outcycle, val, ecount,
+                                           (int *)elist, silent);
+        else
+            rval = CCedgegen_junk_greedy_tour(ncount, dat, outcycle, val,
+                                              ecount, (int *)elist, silent);
+        break;
+    case CC_LK_QBORUVKA_START:
+        if (type == CC_KD_NORM_TYPE)
+            rval = CCkdtree_qboruvka_tour((CCkdtree *)NULL, ncount, dat,
+                                          outcycle, val, rstate);
+        else if (type == CC_X_NORM_TYPE)
+            rval = CCedgegen_x_qboruvka_tour(ncount, dat, outcycle, val,
+                                             ecount, (int *)elist, silent);
+        else
+            rval = CCedgegen_junk_qboruvka_tour(ncount, dat, outcycle, val,
+                                                ecount, (int *)elist, silent);
+        break;
+    case CC_LK_SPACEFILL_START:
+        rval = CCkdtree_spacefill_tour(ncount, dat, outcycle, val);
+        break;
+    default:
+        fprintf(stderr, "unknown start tour type %d\n", starttype);
+        return 1;
+    }
+    if (rval)
+        fprintf(stderr, "start tour (type %d) failed\n", starttype);
+    return rval;
+}
+
+/* Walks the cycle from s away from t, skipping t, and ends the path at t. */
+static void cycle_to_path(int ncount, const int *cyc, int s, int t, int *path) {
+    int i, k = 0, p = 0, dir = 1;
+
+    while (cyc[p] != s)
+        p++;
+    if (cyc[(p + 1) % ncount] == t)
+        dir = ncount - 1;
+    for (i = 0; i < ncount; i++) {
+        if (cyc[p] != t)
+            path[k++] = cyc[p];
+        p = (p + dir) % ncount;
     }
+    path[k] = t;
 }
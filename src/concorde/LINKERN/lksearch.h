@@ -0,0 +1,469 @@
+/****************************************************************************/
+/*                                                                          */
+/*  This file is part of CONCORDE                                           */
+/*                                                                          */
+/*  (c) Copyright 1995--1999 by David Applegate, Robert Bixby,              */
+/*  Vasek Chvatal, and William Cook                                         */
+/*                                                                          */
+/*  Permission is granted for academic research use.  For other uses,       */
+/*  contact the authors for licensing options.                              */
+/*                                                                          */
+/*  Use at your own risk.  We make no guarantees about the                  */
+/*  correctness or usefulness of this code.                                 */
+/*                                                                          */
+/****************************************************************************/
+
+/****************************************************************************/
+/*                                                                          */
+/*                THE LIN-KERNIGHAN STEP, ONE COPY PER SEARCH               */
+/*                                                                          */
+/*                           TSP CODE                                       */
+/*                                                                          */
+/*                                                                          */
+/*    This file is included by linkern.c once for each copy of step,        */
+/*    step_noback, look_ahead and look_ahead_noback it wants. Before each   */
+/*    include it defines                                                    */
+/*                                                                          */
+/*      LK_NAME(x)          the name of the copy of x (say x##_default)     */
+/*      LK_MAXDEPTH         the CClk_search fields, as constants for the    */
+/*      LK_BACKTRACK         presets, so the compiler can unroll and drop   */
+/*      LK_BACKCOUNT(level)  the tests, or as reads of G->search for a      */
+/*      LK_MAK_MORTON        copy that runs any search                      */
+/*      LK_LESS_OR_EQUAL                                                    */
+/*                                                                          */
+/*    and the file undefines them again at its end.                         */
+/*                                                                          */
+/****************************************************************************/
+
+static int LK_NAME(step)(graph *G, distobj *D, adddel *E, aqueue *Q,
+                         CClk_flipper *F, int level, int gain, int *Gstar,
+                         int first, int last, flipstack *fstack,
+                         CCptrworld *intptr_world, CCptrworld *edgelook_world),
+    LK_NAME(step_noback)(graph *G, distobj *D, adddel *E, aqueue *Q,
+                         CClk_flipper *F, int level, int gain, int *Gstar,
+                         int first, int last, flipstack *fstack,
+                         CCptrworld *intptr_world);
+
+static edgelook *LK_NAME(look_ahead)(graph *G, distobj *D, adddel *E,
+                                     CClk_flipper *F, int first, int last,
+                                     int gain, int level,
+                                     CCptrworld *edgelook_world);
+
+static void LK_NAME(look_ahead_noback)(graph *G, distobj *D, adddel *E,
+                                       CClk_flipper *F, int first, int last,
+                                       int gain, edgelook *winner);
+
+static int LK_NAME(step)(graph *G, distobj *D, adddel *E, aqueue *Q,
+                         CClk_flipper *F, int level, int gain, int *Gstar,
+                         int first, int last, flipstack *fstack,
+                         CCptrworld *intptr_world,
+                         CCptrworld *edgelook_world) {
+    int val, this, newlast, hit = 0, oldG = gain;
+#if defined(MAK_MORTON) && defined(FULL_MAK_MORTON)
+    int newfirst;
+#endif
+    edgelook *list, *e;
+
+    if (level >= LK_BACKTRACK) {
+        return LK_NAME(step_noback)(G, D, E, Q, F, level, gain, Gstar, first,
+                                    last, fstack, intptr_world);
+    }
+
+    list = LK_NAME(look_ahead)(G, D, E, F, first, last, gain, level,
+                               edgelook_world);
+    for (e = list; e; e = e->next) {
+#if defined(MAK_MORTON) && defined(FULL_MAK_MORTON)
+        if (e->mm) {
+            this = e->other;
+            newfirst = e->over;
+
+            gain = oldG - e->diff;
+            val = gain - Edgelen(newfirst, last, D);
+            if (val > *Gstar) {
+                *Gstar = val;
+                hit++;
+            }
+            FLIP(this, newfirst, first, last, fstack, F);
+
+            if (level < LK_MAXDEPTH) {
+                markedge_add(first, this, E);
+                markedge_del(this, newfirst, E);
+                hit += LK_NAME(step)(G, D, E, Q, F, level + 1, gain, Gstar,
+                                     newfirst, last, fstack, intptr_world,
+                                     edgelook_world);
+                unmarkedge_add(first, this, E);
+                unmarkedge_del(this, newfirst, E);
+            }
+
+            if (!hit) {
+                UNFLIP(this, newfirst, first, last, fstack, F);
+            } else {
+                MARK(this, Q, F, D, G, intptr_world);
+                MARK(newfirst, Q, F, D, G, intptr_world);
+                edgelook_listfree(edgelook_world, list);
+                return 1;
+            }
+        } else
+#endif
+        {
+            this = e->other;
+            newlast = e->over;
+
+            gain = oldG - e->diff;
+            val = gain - Edgelen(newlast, first, D);
+            if (val > *Gstar) {
+                *Gstar = val;
+                hit++;
+            }
+
+            FLIP(first, last, newlast, this, fstack, F);
+
+            if (level < LK_MAXDEPTH) {
+                markedge_add(last, this, E);
+                markedge_del(this, newlast, E);
+                hit += LK_NAME(step)(G, D, E, Q, F, level + 1, gain, Gstar,
+                                     first, newlast, fstack, intptr_world,
+                                     edgelook_world);
+                unmarkedge_add(last, this, E);
+                unmarkedge_del(this, newlast, E);
+            }
+
+            if (!hit) {
+                UNFLIP(first, last, newlast, this, fstack, F);
+            } else {
+                MARK(this, Q, F, D, G, intptr_world);
+                MARK(newlast, Q, F, D, G, intptr_world);
+                edgelook_listfree(edgelook_world, list);
+                return 1;
+            }
+        }
+    }
+    edgelook_listfree(edgelook_world, list);
+    return 0;
+}
+
+static int LK_NAME(step_noback)(graph *G, distobj *D, adddel *E, aqueue *Q,
+                                CClk_flipper *F, int level, int gain,
+                                int *Gstar, int first, int last,
+                                flipstack *fstack, CCptrworld *intptr_world) {
+    edgelook e;
+
+#ifdef SUBTRACT_GSTAR
+#ifdef SWITCH_LATE
+    if (level < LATE_DEPTH) {
+        LK_NAME(look_ahead_noback)(G, D, E, F, first, last, gain - *Gstar, &e);
+    } else {
+        LK_NAME(look_ahead_noback)(G, D, E, F, first, last,
+                                   gain - *Gstar - level, &e);
+    }
+#else
+    LK_NAME(look_ahead_noback)(G, D, E, F, first, last, gain - *Gstar - level,
+                               &e);
+#endif /* SWITCH_LATE */
+#else
+#ifdef SWITCH_LATE
+    if (level < LATE_DEPTH) {
+        LK_NAME(look_ahead_noback)(G, D, E, F, first, last, gain, &e);
+    } else {
+        LK_NAME(look_ahead_noback)(G, D, E, F, first, last, gain - level, &e);
+    }
+#else
+    LK_NAME(look_ahead_noback)(G, D, E, F, first, last, gain - level, &e);
+#endif /* SWITCH_LATE */
+#endif /* SUBTRACT_GSTAR */
+
+    if (e.diff < BIGINT) {
+#ifdef NODE_INSERTIONS
+        if (e.ni) {
+            int hit = 0;
+            int newlast = e.other;
+            int next = e.under;
+            int prev = e.over;
+            int val;
+
+            gain -= e.diff;
+            val = gain - Edgelen(newlast, first, D);
+
+            if (val > *Gstar) {
+                *Gstar = val;
+                hit++;
+            }
+
+            FLIP(first, last, newlast, next, fstack, F);
+            FLIP(newlast, prev, last, next, fstack, F);
+
+            if (level < LK_MAXDEPTH) {
+                markedge_add(last, newlast, E);
+                markedge_add(next, prev, E);
+                markedge_del(newlast, prev, E);
+                markedge_del(newlast, next, E);
+                hit += LK_NAME(step_noback)(G, D, E, Q, F, level + 1, gain,
+                                            Gstar, first, newlast, fstack,
+                                            intptr_world);
+                unmarkedge_add(last, newlast, E);
+                unmarkedge_add(next, prev, E);
+                unmarkedge_del(newlast, prev, E);
+                unmarkedge_del(newlast, next, E);
+            }
+
+            if (!hit) {
+                UNFLIP(newlast, prev, last, next, fstack, F);
+                UNFLIP(first, last, newlast, next, fstack, F);
+                return 0;
+            } else {
+                MARK(newlast, Q, F, D, G, intptr_world);
+                MARK(next, Q, F, D, G, intptr_world);
+                MARK(prev, Q, F, D, G, intptr_world);
+                return 1;
+            }
+        } else
+#endif /* NODE_INSERTIONS */
+        {
+#ifdef MAK_MORTON
+            if (e.mm) {
+                int hit = 0;
+                int this = e.other;
+                int newfirst = e.over;
+                int val;
+
+                gain -= e.diff;
+                val = gain - Edgelen(newfirst, last, D);
+                if (val > *Gstar) {
+                    *Gstar = val;
+                    hit++;
+                }
+                FLIP(this, newfirst, first, last, fstack, F);
+
+                if (level < LK_MAXDEPTH) {
+                    markedge_add(first, this, E);
+                    markedge_del(this, newfirst, E);
+                    hit += LK_NAME(step_noback)(G, D, E, Q, F, level + 1, gain,
+                                                Gstar, newfirst, last, fstack,
+                                                intptr_world);
+                    unmarkedge_add(first, this, E);
+                    unmarkedge_del(this, newfirst, E);
+                }
+
+                if (!hit) {
+                    UNFLIP(this, newfirst, first, last, fstack, F);
+                    return 0;
+                } else {
+                    MARK(this, Q, F, D, G, intptr_world);
+                    MARK(newfirst, Q, F, D, G, intptr_world);
+                    return 1;
+                }
+            } else
+#endif /* MAK_MORTON */
+            {
+                int hit = 0;
+                int this = e.other;
+                int newlast = e.over;
+                int val;
+
+                gain -= e.diff;
+                val = gain - Edgelen(newlast, first, D);
+                if (val > *Gstar) {
+                    *Gstar = val;
+                    hit++;
+                }
+
+                FLIP(first, last, newlast, this, fstack, F);
+
+                if (level < LK_MAXDEPTH) {
+                    markedge_add(last, this, E);
+                    markedge_del(this, newlast, E);
+                    hit += LK_NAME(step_noback)(G, D, E, Q, F, level + 1, gain,
+                                                Gstar, first, newlast, fstack,
+                                                intptr_world);
+                    unmarkedge_add(last, this, E);
+                    unmarkedge_del(this, newlast, E);
+                }
+
+                if (!hit) {
+                    UNFLIP(first, last, newlast, this, fstack, F);
+                    return 0;
+                } else {
+                    MARK(this, Q, F, D, G, intptr_world);
+                    MARK(newlast, Q, F, D, G, intptr_world);
+                    return 1;
+                }
+            }
+        }
+    } else {
+        return 0;
+    }
+}
+
+static edgelook *LK_NAME(look_ahead)(graph *G, distobj *D, adddel *E,
+                                     CClk_flipper *F, int first, int last,
+                                     int gain, int level,
+                                     CCptrworld *edgelook_world) {
+    edgelook *list = (edgelook *)NULL, *el;
+    int i, val;
+    int this, prev;
+    int lastnext = CClinkern_flipper_next(F, last);
+    int other[MAX_BACK], save[MAX_BACK];
+    int value[MAX_BACK + 1];
+#if defined(MAK_MORTON) && defined(FULL_MAK_MORTON)
+    int mm[MAX_BACK];
+#endif
+    int k, ahead = LK_BACKCOUNT(level);
+    edge **goodlist = G->goodlist;
+
+    for (i = 0; i < ahead; i++) {
+        value[i] = BIGINT;
+#if defined(MAK_MORTON) && defined(FULL_MAK_MORTON)
+        mm[i] = 0;
+#endif
+    }
+    value[ahead] = -BIGINT;
+
+    for (i = 0; goodlist[last][i].weight < gain + LK_LESS_OR_EQUAL; i++) {
+        this = goodlist[last][i].other;
+        if (!is_it_deleted(last, this, E) && this != first &&
+            this != lastnext) {
+            prev = CClinkern_flipper_prev(F, this);
+            if (!is_it_added(this, prev, E) && !is_fixed(this, prev, G)) {
+                val = goodlist[last][i].weight - Edgelen(this, prev, D);
+                if (val < value[0]) {
+                    for (k = 0; value[k + 1] > val; k++) {
+                        value[k] = value[k + 1];
+                        other[k] = other[k + 1];
+                        save[k] = save[k + 1];
+                    }
+                    value[k] = val;
+                    other[k] = this;
+                    save[k] = prev;
+                }
+            }
+        }
+    }
+
+#if defined(MAK_MORTON) && defined(FULL_MAK_MORTON)
+    if (LK_MAK_MORTON) {
+        int firstprev = CClinkern_flipper_prev(F, first);
+        int next;
+
+        for (i = 0; goodlist[first][i].weight < gain + LK_LESS_OR_EQUAL; i++) {
+            this = goodlist[first][i].other;
+            if (!is_it_deleted(first, this, E) && this != last &&
+                this != firstprev) {
+                next = CClinkern_flipper_next(F, this);
+                if (!is_it_added(this, next, E) && !is_fixed(this, next, G)) {
+                    val = goodlist[first][i].weight - Edgelen(this, next, D);
+                    if (val < value[0]) {
+                        for (k = 0; value[k + 1] > val; k++) {
+                            value[k] = value[k + 1];
+                            other[k] = other[k + 1];
+                            save[k] = save[k + 1];
+                            mm[k] = mm[k + 1];
+                        }
+                        value[k] = val;
+                        other[k] = this;
+                        save[k] = next;
+                        mm[k] = 1;
+                    }
+                }
+            }
+        }
+    }
+#endif
+
+    for (i = 0; i < ahead; i++) {
+        if (value[i] < BIGINT) {
+            el = edgelookalloc(edgelook_world);
+            el->diff = value[i];
+            el->other = other[i];
+            el->over = save[i];
+            el->next = list;
+#if defined(MAK_MORTON) && defined(FULL_MAK_MORTON)
+            el->mm = mm[i];
+#endif
+            list = el;
+        }
+    }
+
+    return list;
+}
+
+static void LK_NAME(look_ahead_noback)(graph *G, distobj *D, adddel *E,
+                                       CClk_flipper *F, int first, int last,
+                                       int gain, edgelook *winner) {
+    int val;
+    int this, prev;
+    int lastnext = CClinkern_flipper_next(F, last);
+    int i;
+#if defined(MAK_MORTON) || defined(NODE_INSERTIONS)
+    int next;
+#endif
+    edge **goodlist = G->goodlist;
+
+    winner->diff = BIGINT;
+    for (i = 0; goodlist[last][i].weight < gain; i++) {
+        this = goodlist[last][i].other;
+        if (!is_it_deleted(last, this, E) && this != first &&
+            this != lastnext) {
+            prev = CClinkern_flipper_prev(F, this);
+            if (!is_it_added(this, prev, E) && !is_fixed(this, prev, G)) {
+                val = goodlist[last][i].weight - Edgelen(this, prev, D);
+                if (val < winner->diff) {
+                    winner->diff = val;
+                    winner->other = this;
+                    winner->over = prev;
+#ifdef MAK_MORTON
+                    winner->mm = 0;
+#endif
+#ifdef NODE_INSERTIONS
+                    winner->ni = 0;
+#endif
+                }
+#ifdef NODE_INSERTIONS
+                next = CClinkern_flipper_next(F, this);
+                if (!is_it_added(this, next, E) && !is_fixed(this, next, G) &&
+                    !is_it_deleted(prev, next, E)) {
+                    val += (Edgelen(next, prev, D) - Edgelen(this, next, D));
+                    if (val < winner->diff) {
+                        winner->diff = val;
+                        winner->other = this;
+                        winner->over = prev;
+                        winner->under = next;
+                        winner->ni = 1;
+                    }
+                }
+#endif
+            }
+        }
+    }
+#ifdef MAK_MORTON
+    if (LK_MAK_MORTON) {
+        int firstprev = CClinkern_flipper_prev(F, first);
+
+        for (i = 0; goodlist[first][i].weight < gain; i++) {
+            this = goodlist[first][i].other;
+            if (!is_it_deleted(first, this, E) && this != last &&
+                this != firstprev) {
+                next = CClinkern_flipper_next(F, this);
+                if (!is_it_added(this, next, E) && !is_fixed(this, next, G)) {
+                    val = goodlist[first][i].weight - Edgelen(this, next, D);
+                    if (val < winner->diff) {
+                        winner->diff = val;
+                        winner->other = this;
+                        winner->over = next;
+                        winner->mm = 1;
+#ifdef NODE_INSERTIONS
+                        winner->ni = 0;
+#endif
+                    }
+                }
+            }
+        }
+    }
+#endif
+}
+
+#undef LK_NAME
+#undef LK_MAXDEPTH
+#undef LK_BACKTRACK
+#undef LK_BACKCOUNT
+#undef LK_MAK_MORTON
+#undef LK_LESS_OR_EQUAL
@@ -0,0 +1,88 @@
+/****************************************************************************/
+/*                                                                          */
+/*  This file is part of CONCORDE                                           */
+/*                                                                          */
+/*  (c) Copyright 1995--1999 by David Applegate, Robert Bixby,              */
+/*  Vasek Chvatal, and William Cook                                         */
+/*                                                                          */
+/*  Permission is granted for academic research use.  For other uses,       */
+/*  contact the authors for licensing options.                              */
+/*                                                                          */
+/*  Use at your own risk.  We make no guarantees about the                  */
+/*  correctness or usefulness of this code.                                 */
+/*                                                                          */
+/****************************************************************************/
+
+/****************************************************************************/
+/*                                                                          */
+/*                         WORKER THREADS                                   */
+/*                                                                          */
+/*                            TSP CODE                                      */
+/*                                                                          */
+/*                                                                          */
+/*    EXPORTED FUNCTIONS:                                                   */
+/*                                                                          */
+/*  int CCutil_cpu_count (void)                                             */
+/*    RETURNS the number of processors online, or 1 if that is unknown or   */
+/*     the code was built without CC_POSIXTHREADS.                          */
+/*                                                                          */
+/*  void CCutil_run_workers (void *w, size_t wsize, int nworkers,           */
+/*      void *(*fn) (void *))                                               */
+/*    RUNS fn on each of the nworkers structs of wsize bytes at w, one      */
+/*     thread each, and returns once all of them are done.  Worker 0 runs   */
+/*     on the calling thread, and so does any worker that cannot get a      */
+/*     thread, after the others have finished.  Without CC_POSIXTHREADS     */
+/*     the workers run one after the other.                                 */
+/*                                                                          */
+/****************************************************************************/
+
+#include "util.h"
+#include "machdefs.h"
+#include "macrorus.h"
+
+int CCutil_cpu_count(void) {
+#ifdef CC_POSIXTHREADS
+    long cpus = sysconf(_SC_NPROCESSORS_ONLN);
+
+    return (cpus > 0) ? (int)cpus : 1;
+#else
+    return 1;
+#endif
+}
+
+void CCutil_run_workers(void *w, size_t wsize, int nworkers,
+                        void *(*fn)(void *)) {
+    char *p = (char *)w;
+    int i;
+#ifdef CC_POSIXTHREADS
+    pthread_t *tid = (pthread_t *)NULL;
+    char *started = (char *)NULL;
+
+    if (nworkers > 1) {
+        tid = CC_SAFE_MALLOC(nworkers, pthread_t);
+        started = CC_SAFE_MALLOC(nworkers, char);
+    }
+    if (tid == (pthread_t *)NULL || started == (char *)NULL) {
+        for (i = 0; i < nworkers; i++)
+            fn(p + i * wsize);
+        goto CLEANUP;
+    }
+    for (i = 1; i < nworkers; i++)
+        started[i] = (pthread_create(&tid[i], NULL, fn, p + i * wsize) == 0);
+    fn(p);
+    for (i = 1; i < nworkers; i++) {
+        if (started[i])
+            pthread_join(tid[i], NULL);
+        else
+            fn(p + i * wsize);
+    }
+
+CLEANUP:
+
+    CC_IFFREE(tid, pthread_t);
+    CC_IFFREE(started, char);
+#else
+    for (i = 0; i < nworkers; i++)
+        fn(p + i * wsize);
+#endif
+}
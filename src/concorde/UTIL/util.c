@@ -83,6 +83,8 @@
 #include "machdefs.h"
 #include "macrorus.h"
 
+/* The rows of dat->adj point straight into distarr, which must outlive dat; */
+/* adjspace stays NULL so CCutil_freedatagroup only releases the row table. */
 int CCutil_receive_distarr(const unsigned int *distarr, unsigned int ncount,
                            CCdatagroup *dat) {
     int norm = CC_MATRIXNORM;
@@ -90,24 +92,12 @@ int CCutil_receive_distarr(const unsigned int *distarr, unsigned int ncount,
     CCutil_init_datagroup(dat);
     CCutil_dat_setnorm(dat, norm);
 
-    int i, j;
     dat->adj = CC_SAFE_MALLOC(ncount, int *);
-    dat->adjspace = CC_SAFE_MALLOC((ncount) * (ncount + 1) / 2, int);
-    if (dat->adj == (int **)NULL || dat->adjspace == (int *)NULL) {
+    if (dat->adj == (int **)NULL) {
         CCutil_freedatagroup(dat);
         return 1;
     }
-    for (i = 0, j = 0; i < ncount; i++) {
-        dat->adj[i] = dat->adjspace + j;
-        j += (i + 1);
-    }
-    int k = 0;
-    for (i = 0; i < ncount; i++) {
-        for (j = 0; j <= i; j++) {
-            dat->adj[i][j] = distarr[k];
-            k++;
-        }
-    }
+    CCutil_distarr_rows(distarr, ncount, dat->adj);
 
     if (dat->x == (double *)NULL && dat->adj == (int **)NULL) {
         fprintf(stderr, "ERROR: Didn't find the data\n");
@@ -117,6 +107,59 @@ int CCutil_receive_distarr(const unsigned int *distarr, unsigned int ncount,
     }
 }
 
+void CCutil_distarr_rows(const unsigned int *distarr, unsigned int ncount,
+                         int **adj) {
+    unsigned int i;
+    size_t j;
+
+    /* 64-bit row offsets: the triangle passes 2^32 entries near 92k nodes */
+    for (i = 0, j = 0; i < ncount; i++) {
+        adj[i] = (int *)distarr + j;
+        j += (size_t)i + 1;
+    }
+}
+
+int CCutil_receive_coords(const double *x, const double *y, const double *z,
+                          int norm, unsigned int ncount, CCdatagroup *dat) {
+    unsigned int i;
+
+    CCutil_init_datagroup(dat);
+    if (CCutil_dat_setnorm(dat, norm)) {
+        fprintf(stderr, "ERROR: Unknown norm %d\n", norm);
+        return 1;
+    }
+    if ((norm & CC_NORM_SIZE_BITS) != CC_D2_NORM_SIZE &&
+        (norm & CC_NORM_SIZE_BITS) != CC_D3_NORM_SIZE) {
+        fprintf(stderr, "ERROR: Norm %d is not a coordinate norm\n", norm);
+        return 1;
+    }
+    if ((norm & CC_NORM_SIZE_BITS) == CC_D3_NORM_SIZE && z == (double *)NULL) {
+        fprintf(stderr, "ERROR: Norm %d needs z coordinates\n", norm);
+        return 1;
+    }
+
+    dat->x = CC_SAFE_MALLOC(ncount, double);
+    dat->y = CC_SAFE_MALLOC(ncount, double);
+    if (dat->x == (double *)NULL || dat->y == (double *)NULL) {
+        CCutil_freedatagroup(dat);
+        return 1;
+    }
+    if ((norm & CC_NORM_SIZE_BITS) == CC_D3_NORM_SIZE) {
+        dat->z = CC_SAFE_MALLOC(ncount, double);
+        if (dat->z == (double *)NULL) {
+            CCutil_freedatagroup(dat);
+            return 1;
+        }
+    }
+    for (i = 0; i < ncount; i++) {
+        dat->x[i] = x[i];
+        dat->y[i] = y[i];
+        if (dat->z)
+            dat->z[i] = z[i];
+    }
+    return 0;
+}
+
 static int isprime(unsigned int x);
 
 unsigned int CCutil_nextprime(unsigned int x) {
@@ -38,6 +38,15 @@
 /*    To use this, set double t = CCutil_real_zeit (), run the function     */
 /*    you want to time, then compute CCutil_real_zeit () - t.               */
 /*                                                                          */
+/*  double CCutil_mono_zeit (void)                                          */
+/*    - To measure elapsed wall clock time with sub-second resolution.      */
+/*    - Uses a monotonic clock where available, so it is cheap enough to    */
+/*      poll inside search loops and does not jump with the system clock.   */
+/*                                                                          */
+/*  double CCutil_peak_memory (void)                                        */
+/*    - Returns the peak resident set size of the process in kilobytes,     */
+/*      or 0.0 where the system does not report it.                         */
+/*                                                                          */
 /*  void CCutil_init_timer (CCutil_timer *t, const char *name)              */
 /*    - Initializes a CCutil_timer, and gives it a name.                    */
 /*    - The name is silently truncated if it is too long.                   */
@@ -141,6 +150,35 @@ double CCutil_real_zeit (void)
     return (double) time (0);
 }
 
+double CCutil_mono_zeit (void)
+{
+#ifdef CLOCK_MONOTONIC
+    struct timespec ts;
+
+    clock_gettime (CLOCK_MONOTONIC, &ts);
+    return ((double) ts.tv_sec) + ((double) ts.tv_nsec) / 1000000000.0;
+#else
+    return CCutil_real_zeit ();
+#endif
+}
+
+double CCutil_peak_memory (void)
+{
+#ifdef HAVE_GETRUSAGE
+    struct rusage ru;
+
+    if (getrusage (RUSAGE_SELF, &ru))
+        return 0.0;
+#ifdef __APPLE__
+    return ((double) ru.ru_maxrss) / 1024.0;   /* counted in bytes there */
+#else
+    return (double) ru.ru_maxrss;
+#endif
+#else
+    return 0.0;
+#endif
+}
+
 void CCutil_init_timer (CCutil_timer *t, const char *name)
 {
     t->szeit    = -1.0;
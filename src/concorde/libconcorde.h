@@ -22,7 +22,7 @@
 /* #undef CC_PROTO_GETRUSAGE */
 
 /* Define if you want to use posix threads */
-/* #undef CC_POSIXTHREADS */
+#define CC_POSIXTHREADS 1
 
 /* Define if <signal.h> needs to be included before <pthreads.h> */
 /* #undef CC_SIGNAL_BEFORE_PTHREAD */
@@ -793,6 +793,7 @@ int
 /****************************************************************************/
 
 #undef  CCUTIL_EDGELEN_FUNCTIONPTR
+/* Keep it undefined: the pointer would be shared by concurrent solves. */
 
 typedef struct CCdata_user {
     double  *x;
@@ -1352,6 +1353,10 @@ double
 /****************************************************************************/
 int CCutil_receive_distarr(const unsigned int *distarr, unsigned int ncount,
                            CCdatagroup *dat);
+int CCutil_receive_coords(const double *x, const double *y, const double *z,
+                          int norm, unsigned int ncount, CCdatagroup *dat);
+void CCutil_distarr_rows(const unsigned int *distarr, unsigned int ncount,
+                         int **adj);
 
 char
    *CCutil_strchr (char *s, int c),
@@ -1396,6 +1401,8 @@ typedef struct CCutil_timer {
 double
     CCutil_zeit (void),
     CCutil_real_zeit (void),
+    CCutil_mono_zeit (void),
+    CCutil_peak_memory (void),
     CCutil_stop_timer (CCutil_timer *t, int printit),
     CCutil_total_timer (CCutil_timer *t, int printit);
 
@@ -1407,6 +1414,20 @@ void
     CCutil_resume_timer (CCutil_timer *t);
 
 
+/****************************************************************************/
+/*                                                                          */
+/*                             threads.c                                    */
+/*                                                                          */
+/****************************************************************************/
+
+int
+    CCutil_cpu_count (void);
+
+void
+    CCutil_run_workers (void *w, size_t wsize, int nworkers,
+        void *(*fn) (void *));
+
+
 
 #endif /* __UTIL_H */
 /****************************************************************************/
@@ -1431,14 +1452,38 @@ void
 #define HELDKARP_SEARCHLIMITEXCEEDED 1
 
 
+#define CC_HK_DEPTH_FIRST (0)
+#define CC_HK_BEST_FIRST (1)
+
+#define CC_HK_TOUR_TOO_LONG (-2) /* CCtsp_hk: the length passes INT_MAX */
+
+typedef struct CCheldkarp_config {
+    int nthreads;       /* search threads, 0 for one per online CPU */
+    int nodesel;        /* CC_HK_DEPTH_FIRST or CC_HK_BEST_FIRST */
+    double time_bound;  /* seconds of wall clock, <= 0 for no bound */
+    double pool_memory; /* bytes of open subproblems best-first keeps */
+} CCheldkarp_config;
+
 int CCheldkarp_small(int ncount, CCdatagroup *dat, double *upbound,
-                     double *optval, int *foundtour, int anytour,
-                     int *tour_elist, int nodelimit, int silent),
+                     double *optval, double *lowbound, int *foundtour,
+                     int anytour, int *tour_elist, int nodelimit, int silent,
+                     const CCheldkarp_config *cfg),
     CCheldkarp_small_elist(int ncount, int ecount, int *elist, int *elen,
-                           double *upbound, double *optval, int *foundtour,
-                           int anytour, int *tour_elist, int nodelimit,
-                           int silent);
-int CCtsp_heldkarp(const unsigned int *distarr, unsigned int *route, unsigned int ncount);
+                           double *upbound, double *optval, double *lowbound,
+                           int *foundtour, int anytour, int *tour_elist,
+                           int nodelimit, int silent,
+                           const CCheldkarp_config *cfg);
+void CCheldkarp_init_config(CCheldkarp_config *cfg);
+int CCheldkarp_alpha_nearest(int ncount, CCdatagroup *dat, int ecount,
+                             const int *elist, int k, int *acount,
+                             int **alist, double *lowbound, int silent),
+    CCheldkarp_sparse_bound(int ncount, CCdatagroup *dat, int ecount,
+                            const int *elist, double *lowbound, int silent);
+int CCtsp_hk(const unsigned int *distarr, unsigned int *route,
+             unsigned int ncount, int nodelimit, double *lowbound,
+             const CCheldkarp_config *cfg),
+    CCtsp_hk_bound(const unsigned int *distarr, unsigned int ncount,
+                   double *lowbound);
 
 #endif /* __HELDKARP_H */
 /****************************************************************************/
@@ -1465,6 +1510,62 @@ int CCtsp_heldkarp(const unsigned int *distarr, unsigned int *route, unsigned in
 #define CC_LK_CLOSE_KICK     (2)
 #define CC_LK_WALK_KICK      (3)
 
+#define CC_LK_RANDOM_START    (0)
+#define CC_LK_NEIGHBOR_START  (1)
+#define CC_LK_GREEDY_START    (2)
+#define CC_LK_QBORUVKA_START  (3)
+#define CC_LK_SPACEFILL_START (4)
+
+#define CC_LK_NEAREST_CANDS (0)
+#define CC_LK_ALPHA_CANDS   (1)
+
+#define CC_LK_SEARCH_DEFAULT (0)
+#define CC_LK_SEARCH_FAST    (1)
+#define CC_LK_SEARCH_DEEP    (2)
+
+#define CC_LK_MAX_BACKTRACK  (8)
+
+typedef struct CClk_workspace CClk_workspace;
+
+/* How deep and how wide each Lin-Kernighan move is searched. */
+typedef struct CClk_search {
+    int maxdepth;        /* flips in one improving move (>= 1) */
+    int kick_maxdepth;   /* flips in one kick */
+    int backtrack;       /* levels that try more than the best flip */
+    int backtrack_count[CC_LK_MAX_BACKTRACK]; /* flips tried per level */
+    int mak_morton;      /* also try Mak-Morton moves at the first node */
+    int less_or_equal;   /* also take edges no shorter than the gain */
+} CClk_search;
+
+/* What one run did and where its time went; counts are doubles so that  */
+/* long runs cannot overflow them.                                       */
+typedef struct CClk_stats {
+    double load_time;        /* seconds building the datagroup (CCtsp_lk) */
+    double candidate_time;   /* seconds building the candidate edges */
+    double start_time;       /* seconds building the start tour */
+    double initial_time;     /* seconds of LK on the start tour */
+    double kick_time;        /* seconds of the kicks that follow */
+    double kicks;
+    double improving_kicks;
+    double last_improvement; /* the kick that last improved, 0 if none */
+    double flips;            /* CClinkern_flipper_flip calls */
+    double splits;           /* segments the flips had to split */
+    double dist_lookups;     /* edge lengths asked of the distance cache */
+    double dist_misses;      /* ... and not found there */
+    double process_peak_rss; /* peak resident set of the whole process, */
+                             /* not just this run, in KB               */
+} CClk_stats;
+
+/* Hooks into, and the search of, a running CClinkern_tour; NULL hooks */
+/* are ignored.                                                        */
+typedef struct CClk_control {
+    const volatile int *cancel;  /* stop soon after it turns nonzero */
+    int  (*improved) (void *arg, double val, int ncount, const int *cycle);
+    void  *improved_arg;
+    double improved_interval;    /* min seconds between improved calls */
+    CClk_search search;
+    CClk_stats *stats;           /* filled in at the end of the run */
+} CClk_control;
 
 
 int
@@ -1472,13 +1573,79 @@ int
         int *elist, int stallcount, int repeatcount, int *incycle,
         int *outcycle, double *val, int silent, double time_bound,
         double length_bound, char *saveit_name, int kicktype,
-        CCrandstate *rstate),
+        CCrandstate *rstate, CClk_workspace *ws, const CClk_control *ctl),
     CClinkern_path (int ncount, CCdatagroup *dat, int ecount,
-        int *elist, int nkicks, int *inpath, int *outpath, double *val,
-        int silent, CCrandstate *rstate),
-    CClinkern_fixed (int ncount, CCdatagroup *dat, int ecount, int *elist,
-        int nkicks, int *incycle, int *outcycle, double *val, int fcount,
-        int *flist, int silent, CCrandstate *rstate);
+        int *elist, int stallcount, int repeatcount, int *inpath,
+        int *outpath, double *val, int silent, double time_bound,
+        double length_bound, int kicktype, CCrandstate *rstate,
+        CClk_workspace *ws, const CClk_control *ctl),
+    CClinkern_fixed (int ncount, CCdatagroup *dat, int ecount,
+        int *elist, int stallcount, int repeatcount, int *incycle,
+        int *outcycle, double *val, int fcount, int *flist, int silent,
+        double time_bound, double length_bound, int kicktype,
+        CCrandstate *rstate, CClk_workspace *ws, const CClk_control *ctl),
+    CClinkern_workspace_alloc (CClk_workspace **ws);
+
+void
+    CClinkern_init_control (CClk_control *ctl),
+    CClinkern_search_preset (CClk_search *search, int preset),
+    CClinkern_workspace_free (CClk_workspace *ws);
+
+
+/****************************************************************************/
+/*                                                                          */
+/*                             lk.c                                         */
+/*                                                                          */
+/****************************************************************************/
+
+typedef struct CCtsp_lkworkspace CCtsp_lkworkspace;
+
+/* Everything a solve may be tuned with; there is no file-level state, so  */
+/* the CCtsp_lk routines can run concurrently on distinct workspaces.      */
+typedef struct CCtsp_lkconfig {
+    int    seed;
+    int    kicktype;
+    int    starttype;
+    int    candtype;    /* CC_LK_NEAREST_CANDS or CC_LK_ALPHA_CANDS */
+    int    silent;
+    double time_bound;  /* seconds of wall clock, <= 0 for no bound */
+    CClk_control ctl;   /* cancel flag, progress reports and search */
+} CCtsp_lkconfig;
+
+int
+    CCtsp_lk (const unsigned int *distarr, unsigned int *route,
+        unsigned int ncount, int stallcount, double length_bound,
+        const CCtsp_lkconfig *cfg),
+    CCtsp_lk_from (const unsigned int *distarr, const unsigned int *start,
+        unsigned int *route, unsigned int ncount, int stallcount,
+        double length_bound, const CCtsp_lkconfig *cfg),
+    CCtsp_lk_path (const unsigned int *distarr, unsigned int s,
+        unsigned int t, unsigned int *route, unsigned int ncount,
+        int stallcount, double length_bound, const CCtsp_lkconfig *cfg),
+    CCtsp_lk_fixed (const unsigned int *distarr, int fcount,
+        const unsigned int *flist, unsigned int *route, unsigned int ncount,
+        int stallcount, double length_bound, const CCtsp_lkconfig *cfg),
+    CCtsp_lk_ws (CCtsp_lkworkspace *ws, const unsigned int *distarr,
+        unsigned int *route, unsigned int ncount, int stallcount,
+        double length_bound, const CCtsp_lkconfig *cfg),
+    CCtsp_lk_chain (CCtsp_lkworkspace *ws, const unsigned int *distarr,
+        unsigned int *route, unsigned int ncount, int ecount,
+        const int *elist, int stallcount, double length_bound,
+        const CCtsp_lkconfig *cfg),
+    CCtsp_lk_candidates (const unsigned int *distarr, unsigned int ncount,
+        int *ecount, int **elist),
+    CCtsp_junk_k_nearest (const unsigned int *distarr, unsigned int ncount,
+        int num, const double *wcoord, int nthreads, int *ecount,
+        int **elist),
+    CCtsp_lk_coords (const double *x, const double *y, const double *z,
+        int norm, unsigned int *route, unsigned int ncount, int stallcount,
+        double length_bound, const CCtsp_lkconfig *cfg),
+    CCtsp_lkworkspace_alloc (CCtsp_lkworkspace **ws);
+
+void
+    CCtsp_init_lkconfig (CCtsp_lkconfig *cfg),
+    CCtsp_lk_free_candidates (int *elist),
+    CCtsp_lkworkspace_free (CCtsp_lkworkspace *ws);
 
 #endif  /* __LINKERN_H */
 
@@ -1515,16 +1682,23 @@ typedef struct CClk_flipper {
     int                     nsegments;
     int                     groupsize;
     int                     split_cutoff;
+    int                     parents_space;
+    int                     children_space;
+    int                     counting; /* keep flips and splits */
+    double                  flips;
+    double                  splits;
 } CClk_flipper;
 
 
 
 int
     CClinkern_flipper_init (CClk_flipper *f, int ncount, int *cyc),
+    CClinkern_flipper_reset (CClk_flipper *f, int ncount, int *cyc),
     CClinkern_flipper_next (CClk_flipper *f, int x),
     CClinkern_flipper_prev (CClk_flipper *f, int x),
     CClinkern_flipper_sequence (CClk_flipper *f, int x, int y, int z);
 void
+    CClinkern_flipper_clear (CClk_flipper *f),
     CClinkern_flipper_flip (CClk_flipper *F, int x, int y),
     CClinkern_flipper_cycle (CClk_flipper *F, int *x),
     CClinkern_flipper_finish (CClk_flipper *F);
@@ -1690,7 +1864,8 @@ int
     CCedgegen_x_qboruvka_tour (int ncount, CCdatagroup *dat, int *outcycle,
         double *val, int ecount, int *elist, int silent),
     CCedgegen_junk_k_nearest (int ncount, int num, CCdatagroup *dat,
-        double *wcoord, int wantlist, int *ecount, int **elist, int silent),
+        double *wcoord, int wantlist, int *ecount, int **elist, int nthreads,
+        int silent),
     CCedgegen_junk_node_k_nearest (CCdatagroup *dat, double *wcoord, int n,
         int nearnum, int ncount, int *list),
     CCedgegen_junk_node_nearest (CCdatagroup *dat, double *wcoord, int ncount,
@@ -1709,3 +1884,105 @@ void
 
 
 #endif  /* __EDGEGEN_H */
+/****************************************************************************/
+/*                                                                          */
+/*  This file is part of CONCORDE                                           */
+/*                                                                          */
+/*  (c) Copyright 1995--1999 by David Applegate, Robert Bixby,              */
+/*  Vasek Chvatal, and William Cook                                         */
+/*                                                                          */
+/*  Permission is granted for academic research use.  For other uses,       */
+/*  contact the authors for licensing options.                              */
+/*                                                                          */
+/*  Use at your own risk.  We make no guarantees about the                  */
+/*  correctness or usefulness of this code.                                 */
+/*                                                                          */
+/****************************************************************************/
+
+/****************************************************************************/
+/****************************************************************************/
+/*                                                                          */
+/*                      PROTOTYPES FOR FILES IN KDTREE                      */
+/*                                                                          */
+/****************************************************************************/
+/****************************************************************************/
+
+#ifndef __KDTREE_H
+#define __KDTREE_H
+
+
+typedef struct CCkdnode {
+    double cutval;
+    struct CCkdnode *loson, *hison, *father;
+    double bnds[4];   /* the cell: xlo, xhi, ylo, yhi */
+    int    empty;     /* every point below has been deleted */
+    int    lopt, hipt; /* bucket: the live points are perm[lopt..hipt] */
+    int    top;       /* bucket: its last point, live or deleted */
+    char   bucket;
+    char   cutdim;
+} CCkdnode;
+
+typedef struct CCkdtree {
+    CCkdnode  *root;
+    CCkdnode **bucketptr;
+    CCkdnode  *nodespace;
+    int       *perm;
+    int        nodecount;
+} CCkdtree;
+
+
+/****************************************************************************/
+/*                                                                          */
+/*                             kdbuild.c                                    */
+/*                                                                          */
+/****************************************************************************/
+
+int
+    CCkdtree_build (CCkdtree *kt, int ncount, CCdatagroup *dat,
+        CCrandstate *rstate);
+
+void
+    CCkdtree_free (CCkdtree *kt),
+    CCkdtree_delete (CCkdtree *kt, int k),
+    CCkdtree_delete_all (CCkdtree *kt, int ncount),
+    CCkdtree_undelete (CCkdtree *kt, int k),
+    CCkdtree_undelete_all (CCkdtree *kt, int ncount);
+
+
+/****************************************************************************/
+/*                                                                          */
+/*                             kdnear.c                                     */
+/*                                                                          */
+/****************************************************************************/
+
+int
+    CCkdtree_k_nearest (CCkdtree *kt, int ncount, int k, CCdatagroup *dat,
+        int *ecount, int **elist, int silent, CCrandstate *rstate),
+    CCkdtree_quadrant_k_nearest (CCkdtree *kt, int ncount, int k,
+        CCdatagroup *dat, int *ecount, int **elist, int silent,
+        CCrandstate *rstate),
+    CCkdtree_node_k_nearest (CCkdtree *kt, int n, int k, CCdatagroup *dat,
+        int *list),
+    CCkdtree_node_quadrant_k_nearest (CCkdtree *kt, int n, int k,
+        CCdatagroup *dat, int *list),
+    CCkdtree_node_nearest (CCkdtree *kt, int n, CCdatagroup *dat),
+    CCkdtree_nearest_neighbor_tour (CCkdtree *kt, int ncount, int start,
+        CCdatagroup *dat, int *outcycle, double *val, CCrandstate *rstate);
+
+
+/****************************************************************************/
+/*                                                                          */
+/*                             kdtour.c                                     */
+/*                                                                          */
+/****************************************************************************/
+
+int
+    CCkdtree_greedy_tour (CCkdtree *kt, int ncount, CCdatagroup *dat,
+        int *outcycle, double *val, int silent, CCrandstate *rstate),
+    CCkdtree_qboruvka_tour (CCkdtree *kt, int ncount, CCdatagroup *dat,
+        int *outcycle, double *val, CCrandstate *rstate),
+    CCkdtree_spacefill_tour (int ncount, CCdatagroup *dat, int *outcycle,
+        double *val);
+
+
+#endif  /* __KDTREE_H */
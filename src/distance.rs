@@ -4,7 +4,7 @@ pub trait Distance {
     fn calc_shortest_dist(&self, other: &Self) -> u32;
 }
 
-#[derive(Debug, PartialEq, Eq)]
+#[derive(Clone, Debug, PartialEq, Eq)]
 pub struct LowerDistanceMatrix {
     pub num_nodes: u32,
     pub values: Vec<u32>,
@@ -88,6 +88,44 @@ impl<T: Distance> From<&[T]> for LowerDistanceMatrix {
     }
 }
 
+/// Norms that compute edge lengths on the fly from node coordinates,
+/// mirroring the `CC_*` norms of Concorde (see TSPLIB for their definitions).
+#[derive(Clone, Copy, Debug, PartialEq, Eq)]
+pub enum Norm {
+    /// Rounded Euclidean distance; uses the 3D variant when z is given.
+    Euclidean,
+    /// Euclidean distance rounded up.
+    EuclideanCeil,
+    /// Rounded L1 distance.
+    Manhattan,
+    /// Rounded L-infinity distance.
+    Max,
+    /// Great circle distance, with coordinates given as TSPLIB `DDD.MM` latitude/longitude.
+    Geographic,
+    /// Pseudo-Euclidean distance of the att48/att532 instances.
+    Att,
+}
+
+impl Norm {
+    /// The Concorde norm code, or `None` if the norm has no 3D variant.
+    pub(crate) const fn code(self, has_z: bool) -> Option<i32> {
+        const D2: i32 = 1024;
+        const D3: i32 = 2048;
+        const KD: i32 = 128;
+        const X: i32 = 256;
+        match (self, has_z) {
+            (Self::Max, false) => Some(KD | D2),
+            (Self::EuclideanCeil, false) => Some(1 | KD | D2),
+            (Self::Euclidean, false) => Some(2 | KD | D2),
+            (Self::Euclidean, true) => Some(3 | X | D3),
+            (Self::Att, false) => Some(5 | X | D2),
+            (Self::Geographic, false) => Some(6 | X | D2),
+            (Self::Manhattan, false) => Some(18 | KD | D2),
+            _ => None,
+        }
+    }
+}
+
 #[cfg(test)]
 mod tests {
     use super::*;
@@ -98,4 +136,12 @@ mod tests {
         assert_eq!(LowerDistanceMatrix::get_node(2, 3), 8);
         assert_eq!(LowerDistanceMatrix::get_node(3, 2), 8);
     }
+
+    #[test]
+    fn test_norm_code() {
+        assert_eq!(Norm::Euclidean.code(false), Some(1154));
+        assert_eq!(Norm::Euclidean.code(true), Some(2307));
+        assert_eq!(Norm::Geographic.code(false), Some(1286));
+        assert_eq!(Norm::Manhattan.code(true), None);
+    }
 }
@@ -4,12 +4,13 @@ use std::fmt;
 #[derive(Debug)]
 pub enum SolverError {
     SolverFailed(String),
+    InvalidInput(String),
 }
 
 impl error::Error for SolverError {
     fn source(&self) -> Option<&(dyn error::Error + 'static)> {
         match *self {
-            Self::SolverFailed(_) => None,
+            Self::SolverFailed(_) | Self::InvalidInput(_) => None,
         }
     }
 }
@@ -20,6 +21,7 @@ impl fmt::Display for SolverError {
             Self::SolverFailed(func_name) => {
                 write!(f, "{func_name} failed to solve the problem.")
             }
+            Self::InvalidInput(reason) => write!(f, "Invalid input: {reason}."),
         }
     }
 }
@@ -3,6 +3,14 @@
 //! 1. [`solver::tsp_hk`]: Held-Karp dynamic programming algorithm
 //! 2. [`solver::tsp_lk`]: Lin-Kernighan heuristic
 //!
+//! Large geometric instances can skip the distance matrix entirely with
+//! [`solver::tsp_lk_coords`], which computes edge lengths from coordinates on the fly.
+//! Callers solving many instances in a row can keep an [`LkWorkspace`] to reuse Concorde's buffers,
+//! and [`solver::solve_batch`] spreads a batch of independent instances over all cores.
+//! Long Lin-Kernighan runs can be cancelled or awaited through the [`task`] module.
+//! [`solver::hk_lower_bound`] bounds every tour from below, so the gap of a heuristic tour
+//! to the optimum can be proven on instances far too large for Held-Karp.
+//!
 //! # Examples
 //!
 //! If values for lower distance matrix are provided:
@@ -11,7 +19,7 @@
 //!
 //! let dist_mat =
 //!     LowerDistanceMatrix::new(5, vec![0, 3, 0, 4, 4, 0, 2, 6, 5, 0, 7, 3, 8, 6, 0]);
-//! assert_eq!(solver::tsp_hk(&dist_mat).unwrap().length, 19);
+//! assert_eq!(solver::tsp_hk(&dist_mat, None, None).unwrap().length, 19);
 //! ```
 //!
 //! If values for lower distance matrix are **not** provided:
@@ -28,14 +36,19 @@
 //!
 //! let nodes: Vec<Node> = vec![Node(0, 0), Node(0, 3), Node(5, 6), Node(9, 1)];
 //! let dist_mat = LowerDistanceMatrix::from(nodes.as_ref());
-//! let solution = solver::tsp_hk(&dist_mat).unwrap();
+//! let solution = solver::tsp_hk(&dist_mat, None, None).unwrap();
 //!
 //! assert_eq!(solution.length, 30);
 //! ```
 pub mod distance;
 pub mod solver;
+pub mod task;
+pub mod workspace;
 
 mod errors;
+#[cfg(test)]
+mod testing;
 
-pub use distance::{Distance, LowerDistanceMatrix};
+pub use distance::{Distance, LowerDistanceMatrix, Norm};
 pub use solver::Solution;
+pub use workspace::LkWorkspace;
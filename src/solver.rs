@@ -1,32 +1,173 @@
 //! The interface for all available solvers.
+//!
+//! Every solver is reentrant: all settings are passed per call and Concorde keeps no
+//! global state, so independent solves may run concurrently on different threads.
+//! The inputs ([`LowerDistanceMatrix`], coordinate slices) and [`Solution`] are
+//! `Send + Sync`.
 use super::errors::SolverError;
-use super::LowerDistanceMatrix;
+use super::task::CancelToken;
+use super::workspace::Candidates;
+use super::{LkWorkspace, LowerDistanceMatrix, Norm};
+use std::any::Any;
 use std::ffi::c_double;
 use std::ffi::c_int;
 use std::ffi::c_uint;
+use std::ffi::c_void;
 use std::fmt;
+use std::ops::ControlFlow;
+use std::panic::{self, AssertUnwindSafe};
+use std::sync::atomic::{AtomicUsize, Ordering};
+use std::thread;
+use std::time::{Duration, Instant};
 
 /// Held-Karp dynamic programming.
+///
+/// A short Lin-Kernighan run supplies the first upper bound, so the branch-and-bound only
+/// has to search for tours shorter than it; when there are none the LK tour is returned.
+///
+/// Concorde reads the distances straight out of `dist_mat.values`; the matrix is never copied.
+///
+/// A `node_limit` on the branch-and-bound nodes or a `time_bound` on the whole call stops
+/// the search early. The best tour found so far is then returned (the nodes in order if
+/// it stopped before finding any, on instances too small for the LK run), and
+/// [`Solution::lower_bound`] says how far from optimal it can be, or is `None` if the
+/// search stopped before it bounded the root; after a full search the lower bound
+/// equals the length.
+/// # Examples
+/// ```
+/// use concorde_rs::{solver, LowerDistanceMatrix};
+///
+/// let dist_mat =
+///     LowerDistanceMatrix::new(5, vec![0, 3, 0, 4, 4, 0, 2, 6, 5, 0, 7, 3, 8, 6, 0]);
+/// let solution = solver::tsp_hk(&dist_mat, None, None).unwrap();
+/// assert_eq!(solution.lower_bound, Some(solution.length));
+/// ```
 /// # Errors
 ///
 /// If the solver cannot solve the TSP, the return length from Concorde TSP is -1.0.
-/// Thus, the solver will return SolverError.
-pub fn tsp_hk(dist_mat: &LowerDistanceMatrix) -> Result<Solution, SolverError> {
+/// Thus, the solver will return SolverError. Concorde returns the length as an `int`,
+/// so a tour longer than `i32::MAX` is a [`SolverError::SolverFailed`] as well.
+pub fn tsp_hk(
+    dist_mat: &LowerDistanceMatrix,
+    node_limit: Option<u32>,
+    time_bound: Option<Duration>,
+) -> Result<Solution, SolverError> {
+    tsp_hk_with(dist_mat, &HkConfig::default(), node_limit, time_bound)
+}
+
+/// Held-Karp with the branch-and-bound threads and node selection chosen by `config`.
+///
+/// [`tsp_hk`] is this with `HkConfig::default()`. The optimal length does not depend on
+/// the number of threads; with several optimal tours, which one is returned may.
+/// When the first dives find poor bounds, [`NodeSelection::BestFirst`] usually
+/// proves optimality in fewer nodes and raises the lower bound faster under a limit.
+/// # Examples
+/// ```
+/// use concorde_rs::solver::{self, HkConfig, NodeSelection};
+/// use concorde_rs::LowerDistanceMatrix;
+///
+/// let dist_mat =
+///     LowerDistanceMatrix::new(5, vec![0, 3, 0, 4, 4, 0, 2, 6, 5, 0, 7, 3, 8, 6, 0]);
+/// let config = HkConfig {
+///     threads: Some(2),
+///     node_selection: NodeSelection::BestFirst,
+///     ..HkConfig::default()
+/// };
+/// let solution = solver::tsp_hk_with(&dist_mat, &config, None, None).unwrap();
+/// assert_eq!(solution.length, 19);
+/// ```
+/// # Errors
+///
+/// Returns `SolverError::InvalidInput` if `config.threads` is zero, and
+/// `SolverError::SolverFailed` if Concorde fails to solve the problem or a limit
+/// stops it before it has any tour.
+pub fn tsp_hk_with(
+    dist_mat: &LowerDistanceMatrix,
+    config: &HkConfig,
+    node_limit: Option<u32>,
+    time_bound: Option<Duration>,
+) -> Result<Solution, SolverError> {
+    check_matrix(dist_mat)?;
+    let params = config.params(time_bound)?;
+    let node_limit = node_limit.map_or(-1, |limit| c_int::try_from(limit).unwrap_or(c_int::MAX));
     let mut tour = vec![0u32; dist_mat.num_nodes as usize];
+    let mut lower_bound: c_double = -1.0;
     let length = unsafe {
         CCtsp_hk(
             dist_mat.values.as_ptr(),
             tour.as_mut_ptr(),
             dist_mat.num_nodes,
+            node_limit,
+            &mut lower_bound,
+            &params,
         )
     };
+    if length == CC_HK_TOUR_TOO_LONG {
+        return Err(SolverError::SolverFailed(String::from(
+            "Held-Karp: the tour is longer than i32::MAX",
+        )));
+    }
     u32::try_from(length).map_or_else(
         |_| Err(SolverError::SolverFailed(String::from("Held-Karp"))),
-        |val| Ok(Solution { length: val, tour }),
+        |val| {
+            Ok(Solution {
+                length: val,
+                tour,
+                stats: None,
+                // Negative when a limit stopped the search before any bound
+                lower_bound: (lower_bound >= 0.0).then(|| lower_bound.min(f64::from(val)) as u32),
+            })
+        },
     )
 }
 
+/// A lower bound on the length of every tour, from the Held-Karp 1-tree relaxation.
+///
+/// Unlike [`tsp_hk`], this runs no branch-and-bound, so it scales to instances of many
+/// thousands of nodes. Comparing it with the length of a heuristic tour proves how far
+/// that tour can be from optimal. The subgradient ascent works on the Lin-Kernighan
+/// candidate edges. After each ascent, the minimum 1-tree of the complete graph is
+/// checked, and any edges the candidates missed are added before the next ascent; so
+/// the bound holds for the whole matrix. It takes O(n²) time, a few passes over the
+/// matrix, and O(n) memory besides.
+/// # Examples
+/// ```
+/// use concorde_rs::{solver, LowerDistanceMatrix};
+///
+/// let dist_mat =
+///     LowerDistanceMatrix::new(5, vec![0, 3, 0, 4, 4, 0, 2, 6, 5, 0, 7, 3, 8, 6, 0]);
+/// let bound = solver::hk_lower_bound(&dist_mat).unwrap();
+/// let solution = solver::tsp_lk(&dist_mat, None, None, None).unwrap();
+/// assert!(bound <= solution.length);
+/// ```
+/// # Errors
+///
+/// Returns `SolverError::InvalidInput` for fewer than 3 nodes, and
+/// `SolverError::SolverFailed` if Concorde fails to compute the bound.
+pub fn hk_lower_bound(dist_mat: &LowerDistanceMatrix) -> Result<u32, SolverError> {
+    check_matrix(dist_mat)?;
+    if dist_mat.num_nodes < 3 {
+        return Err(SolverError::InvalidInput(String::from(
+            "a 1-tree bound needs at least 3 nodes",
+        )));
+    }
+    let mut bound: c_double = 0.0;
+    let rval = unsafe { CCtsp_hk_bound(dist_mat.values.as_ptr(), dist_mat.num_nodes, &mut bound) };
+    if rval != 0 {
+        return Err(SolverError::SolverFailed(String::from("Held-Karp bound")));
+    }
+    // Tour lengths are integers; the slack absorbs the rounding of the penalties.
+    Ok((bound - bound.abs() * 1e-9).ceil().max(0.0) as u32)
+}
+
 /// Lin-Kernighan heuristic.
+///
+/// Concorde reads the distances straight out of `dist_mat.values`; the matrix is never copied.
+///
+/// With a `time_bound` the search stops soon after the deadline, inside a Lin-Kernighan
+/// pass if need be, and returns the best tour found so far. The deadline covers the whole
+/// call: once it has passed, the remaining setup is skipped and a random start tour is
+/// returned. Candidate generation on a matrix is the one phase that runs to completion.
 /// # Errors
 ///
 /// If the solver cannot solve the TSP, the return length from Concorde TSP is -1.0.
@@ -35,33 +176,1398 @@ pub fn tsp_lk(
     dist_mat: &LowerDistanceMatrix,
     stall: Option<i32>,
     length_bound: Option<f64>,
+    time_bound: Option<Duration>,
 ) -> Result<Solution, SolverError> {
-    let stall = stall.map_or_else(|| i32::pow(10, 7), |val| val);
-    let length_bound = length_bound.unwrap_or(-1.0);
-    let mut tour = vec![0u32; dist_mat.num_nodes as usize];
-    let length = unsafe {
-        CCtsp_lk(
-            dist_mat.values.as_ptr(),
-            tour.as_mut_ptr(),
+    lk_matrix(
+        dist_mat,
+        stall,
+        length_bound,
+        &LkParams::with_time_bound(time_bound),
+    )
+}
+
+/// Lin-Kernighan heuristic on alpha-nearness candidate edges.
+///
+/// [`tsp_lk`] lets each node try its 8 nearest neighbours. Here each node tries its 5
+/// alpha-nearest instead. These come from the minimum 1-tree after a Held-Karp
+/// subgradient ascent: an edge's alpha is how much longer the 1-tree gets when it must
+/// use that edge. Edges of good tours rank far higher by alpha than by length, so on
+/// clustered instances LK finds better tours with fewer candidates and kicks. Building
+/// the candidates takes O(n²) time but only O(n) extra memory.
+/// # Examples
+/// ```
+/// use concorde_rs::{solver, LowerDistanceMatrix};
+///
+/// let dist_mat =
+///     LowerDistanceMatrix::new(5, vec![0, 3, 0, 4, 4, 0, 2, 6, 5, 0, 7, 3, 8, 6, 0]);
+/// let solution = solver::tsp_lk_alpha(&dist_mat, None, None, None).unwrap();
+/// assert_eq!(solution.length, 19);
+/// ```
+/// # Errors
+///
+/// If the solver cannot solve the TSP, the return length from Concorde TSP is -1.0.
+/// Thus, the solver will return SolverError.
+pub fn tsp_lk_alpha(
+    dist_mat: &LowerDistanceMatrix,
+    stall: Option<i32>,
+    length_bound: Option<f64>,
+    time_bound: Option<Duration>,
+) -> Result<Solution, SolverError> {
+    let config = LkConfig {
+        candidates: CandidateSet::AlphaNearest,
+        ..LkConfig::default()
+    };
+    tsp_lk_with(dist_mat, &config, stall, length_bound, time_bound)
+}
+
+/// Lin-Kernighan heuristic with the start tour, kick, candidate edges and search
+/// chosen by `config`.
+///
+/// [`tsp_lk`] is this with `LkConfig::default()`. Instances with many small clusters
+/// often converge faster from a greedy start with close kicks than with the defaults.
+/// # Examples
+/// ```
+/// use concorde_rs::solver::{self, KickType, LkConfig, StartTour};
+/// use concorde_rs::LowerDistanceMatrix;
+///
+/// let dist_mat =
+///     LowerDistanceMatrix::new(5, vec![0, 3, 0, 4, 4, 0, 2, 6, 5, 0, 7, 3, 8, 6, 0]);
+/// let config = LkConfig {
+///     start: StartTour::Greedy,
+///     kick: KickType::Close,
+///     ..LkConfig::default()
+/// };
+/// let solution = solver::tsp_lk_with(&dist_mat, &config, None, None, None).unwrap();
+/// assert_eq!(solution.length, 19);
+/// ```
+/// # Errors
+///
+/// Returns `SolverError::InvalidInput` if `config.search` is out of range, and
+/// `SolverError::SolverFailed` if Concorde fails to solve the problem.
+pub fn tsp_lk_with(
+    dist_mat: &LowerDistanceMatrix,
+    config: &LkConfig,
+    stall: Option<i32>,
+    length_bound: Option<f64>,
+    time_bound: Option<Duration>,
+) -> Result<Solution, SolverError> {
+    config.run(time_bound, |params| {
+        lk_matrix(dist_mat, stall, length_bound, params)
+    })
+}
+
+/// Lin-Kernighan heuristic warm-started from `initial_tour`.
+///
+/// The given tour replaces the Q-Boruvka start tour; only the candidate edges are still
+/// computed. Re-solving an instance after small changes from the previous tour usually
+/// needs far fewer kicks to converge.
+/// # Examples
+/// ```
+/// use concorde_rs::{solver, LowerDistanceMatrix};
+///
+/// let dist_mat =
+///     LowerDistanceMatrix::new(5, vec![0, 3, 0, 4, 4, 0, 2, 6, 5, 0, 7, 3, 8, 6, 0]);
+/// let solution = solver::tsp_lk_from(&dist_mat, &[0, 1, 2, 3, 4], None, None, None).unwrap();
+/// assert_eq!(solution.length, 19);
+/// ```
+/// # Errors
+///
+/// Returns `SolverError::InvalidInput` if `initial_tour` is not a permutation of
+/// `0..dist_mat.num_nodes`, and `SolverError::SolverFailed` if Concorde fails to solve
+/// the problem.
+pub fn tsp_lk_from(
+    dist_mat: &LowerDistanceMatrix,
+    initial_tour: &[u32],
+    stall: Option<i32>,
+    length_bound: Option<f64>,
+    time_bound: Option<Duration>,
+) -> Result<Solution, SolverError> {
+    tsp_lk_from_with(
+        dist_mat,
+        initial_tour,
+        &LkConfig::default(),
+        stall,
+        length_bound,
+        time_bound,
+    )
+}
+
+/// [`tsp_lk_from`] with the kick, candidate edges and search chosen by `config`;
+/// `config.start` is unused, as `initial_tour` is the start.
+/// # Examples
+/// ```
+/// use concorde_rs::solver::{self, KickType, LkConfig};
+/// use concorde_rs::LowerDistanceMatrix;
+///
+/// let dist_mat =
+///     LowerDistanceMatrix::new(5, vec![0, 3, 0, 4, 4, 0, 2, 6, 5, 0, 7, 3, 8, 6, 0]);
+/// let config = LkConfig {
+///     kick: KickType::Random,
+///     ..LkConfig::default()
+/// };
+/// let solution =
+///     solver::tsp_lk_from_with(&dist_mat, &[0, 1, 2, 3, 4], &config, None, None, None);
+/// assert_eq!(solution.unwrap().length, 19);
+/// ```
+/// # Errors
+///
+/// As for [`tsp_lk_from`], and `SolverError::InvalidInput` if `config.search` is out
+/// of range.
+pub fn tsp_lk_from_with(
+    dist_mat: &LowerDistanceMatrix,
+    initial_tour: &[u32],
+    config: &LkConfig,
+    stall: Option<i32>,
+    length_bound: Option<f64>,
+    time_bound: Option<Duration>,
+) -> Result<Solution, SolverError> {
+    check_lk_matrix(dist_mat)?;
+    check_tour(initial_tour, dist_mat.num_nodes)?;
+    config.run(time_bound, |params| {
+        lk_solution(
             dist_mat.num_nodes,
             stall,
             length_bound,
+            "Lin-Kernighan",
+            |tour, stall, length_bound| unsafe {
+                CCtsp_lk_from(
+                    dist_mat.values.as_ptr(),
+                    initial_tour.as_ptr(),
+                    tour,
+                    dist_mat.num_nodes,
+                    stall,
+                    length_bound,
+                    params,
+                )
+            },
         )
+    })
+}
+
+/// Lin-Kernighan heuristic for the shortest Hamiltonian path from `start` to `end`.
+///
+/// The returned tour begins at `start` and finishes at `end`, and its length does not
+/// include a closing edge. Concorde closes the path with an edge from `end` back to
+/// `start` that no move may remove, so the distances themselves are left untouched.
+/// # Examples
+/// ```
+/// use concorde_rs::{solver, LowerDistanceMatrix};
+///
+/// let dist_mat =
+///     LowerDistanceMatrix::new(5, vec![0, 3, 0, 4, 4, 0, 2, 6, 5, 0, 7, 3, 8, 6, 0]);
+/// let path = solver::path_lk(&dist_mat, 0, 4, None, None, None).unwrap();
+/// assert_eq!((path.tour[0], path.tour[4]), (0, 4));
+/// assert_eq!(path.length, 14);
+/// ```
+/// # Errors
+///
+/// Returns `SolverError::InvalidInput` if `start` or `end` is not a node or they are the
+/// same node, and `SolverError::SolverFailed` if Concorde fails to solve the problem.
+pub fn path_lk(
+    dist_mat: &LowerDistanceMatrix,
+    start: u32,
+    end: u32,
+    stall: Option<i32>,
+    length_bound: Option<f64>,
+    time_bound: Option<Duration>,
+) -> Result<Solution, SolverError> {
+    path_lk_with(
+        dist_mat,
+        start,
+        end,
+        &LkConfig::default(),
+        stall,
+        length_bound,
+        time_bound,
+    )
+}
+
+/// [`path_lk`] with the start tour, kick, candidate edges and search chosen by
+/// `config`.
+/// # Examples
+/// ```
+/// use concorde_rs::solver::{self, LkConfig, LkSearch};
+/// use concorde_rs::LowerDistanceMatrix;
+///
+/// let dist_mat =
+///     LowerDistanceMatrix::new(5, vec![0, 3, 0, 4, 4, 0, 2, 6, 5, 0, 7, 3, 8, 6, 0]);
+/// let config = LkConfig {
+///     search: LkSearch::DEEP,
+///     ..LkConfig::default()
+/// };
+/// let path = solver::path_lk_with(&dist_mat, 0, 4, &config, None, None, None).unwrap();
+/// assert_eq!(path.length, 14);
+/// ```
+/// # Errors
+///
+/// As for [`path_lk`], and `SolverError::InvalidInput` if `config.search` is out of
+/// range.
+pub fn path_lk_with(
+    dist_mat: &LowerDistanceMatrix,
+    start: u32,
+    end: u32,
+    config: &LkConfig,
+    stall: Option<i32>,
+    length_bound: Option<f64>,
+    time_bound: Option<Duration>,
+) -> Result<Solution, SolverError> {
+    check_lk_matrix(dist_mat)?;
+    if start >= dist_mat.num_nodes || end >= dist_mat.num_nodes || start == end {
+        return Err(SolverError::InvalidInput(format!(
+            "path ends {start} and {end} must be distinct nodes below {}",
+            dist_mat.num_nodes
+        )));
+    }
+    config.run(time_bound, |params| {
+        lk_solution(
+            dist_mat.num_nodes,
+            stall,
+            length_bound,
+            "Lin-Kernighan path",
+            |tour, stall, length_bound| unsafe {
+                CCtsp_lk_path(
+                    dist_mat.values.as_ptr(),
+                    start,
+                    end,
+                    tour,
+                    dist_mat.num_nodes,
+                    stall,
+                    length_bound,
+                    params,
+                )
+            },
+        )
+    })
+}
+
+/// Concorde trusts the start tour, so it must visit every node exactly once.
+fn check_tour(tour: &[u32], num_nodes: u32) -> Result<(), SolverError> {
+    if tour.len() != num_nodes as usize {
+        return Err(SolverError::InvalidInput(format!(
+            "tour holds {} nodes instead of {num_nodes}",
+            tour.len()
+        )));
+    }
+    let mut seen = vec![false; tour.len()];
+    for &node in tour {
+        match seen.get_mut(node as usize) {
+            Some(visited) if !*visited => *visited = true,
+            _ => {
+                return Err(SolverError::InvalidInput(format!(
+                    "tour is not a permutation of 0..{num_nodes} (node {node})"
+                )))
+            }
+        }
+    }
+    Ok(())
+}
+
+/// Lin-Kernighan heuristic for tours that must use the edges in `fixed`.
+///
+/// Each `[a, b]` pair makes `a` and `b` consecutive in the returned tour, for stops
+/// that have to follow one another such as a pick-up and its drop-off. The moves and
+/// kicks skip fixed edges instead of seeing doctored weights, so the candidate sets
+/// and the search are the same as for the unconstrained instance.
+/// # Examples
+/// ```
+/// use concorde_rs::{solver, LowerDistanceMatrix};
+///
+/// let dist_mat =
+///     LowerDistanceMatrix::new(5, vec![0, 3, 0, 4, 4, 0, 2, 6, 5, 0, 7, 3, 8, 6, 0]);
+/// let solution = solver::tsp_lk_fixed(&dist_mat, &[[0, 4]], None, None, None).unwrap();
+/// let at = |node| solution.tour.iter().position(|&n| n == node).unwrap();
+/// assert!(matches!((at(0) + 5 - at(4)) % 5, 1 | 4));
+/// ```
+/// # Errors
+///
+/// Returns `SolverError::InvalidInput` if the fixed edges are not node-disjoint paths
+/// (or one tour through every node), and `SolverError::SolverFailed` if Concorde fails
+/// to solve the problem.
+pub fn tsp_lk_fixed(
+    dist_mat: &LowerDistanceMatrix,
+    fixed: &[[u32; 2]],
+    stall: Option<i32>,
+    length_bound: Option<f64>,
+    time_bound: Option<Duration>,
+) -> Result<Solution, SolverError> {
+    tsp_lk_fixed_with(
+        dist_mat,
+        fixed,
+        &LkConfig::default(),
+        stall,
+        length_bound,
+        time_bound,
+    )
+}
+
+/// [`tsp_lk_fixed`] with the start tour, kick, candidate edges and search chosen by
+/// `config`.
+/// # Examples
+/// ```
+/// use concorde_rs::solver::{self, KickType, LkConfig};
+/// use concorde_rs::LowerDistanceMatrix;
+///
+/// let dist_mat =
+///     LowerDistanceMatrix::new(5, vec![0, 3, 0, 4, 4, 0, 2, 6, 5, 0, 7, 3, 8, 6, 0]);
+/// let config = LkConfig {
+///     kick: KickType::Close,
+///     stats: true,
+///     ..LkConfig::default()
+/// };
+/// let solution =
+///     solver::tsp_lk_fixed_with(&dist_mat, &[[0, 4]], &config, None, None, None).unwrap();
+/// assert!(solution.stats.is_some());
+/// ```
+/// # Errors
+///
+/// As for [`tsp_lk_fixed`], and `SolverError::InvalidInput` if `config.search` is out
+/// of range.
+pub fn tsp_lk_fixed_with(
+    dist_mat: &LowerDistanceMatrix,
+    fixed: &[[u32; 2]],
+    config: &LkConfig,
+    stall: Option<i32>,
+    length_bound: Option<f64>,
+    time_bound: Option<Duration>,
+) -> Result<Solution, SolverError> {
+    check_lk_matrix(dist_mat)?;
+    check_fixed(fixed, dist_mat.num_nodes)?;
+    let fcount = c_int::try_from(fixed.len())
+        .map_err(|_| SolverError::InvalidInput(String::from("too many fixed edges")))?;
+    config.run(time_bound, |params| {
+        lk_solution(
+            dist_mat.num_nodes,
+            stall,
+            length_bound,
+            "Lin-Kernighan",
+            |tour, stall, length_bound| unsafe {
+                CCtsp_lk_fixed(
+                    dist_mat.values.as_ptr(),
+                    fcount,
+                    fixed.as_ptr().cast(),
+                    tour,
+                    dist_mat.num_nodes,
+                    stall,
+                    length_bound,
+                    params,
+                )
+            },
+        )
+    })
+}
+
+/// Fixed edges fit in a tour when no node has more than two of them and the only
+/// cycle they close, if any, runs through every node.
+fn check_fixed(fixed: &[[u32; 2]], num_nodes: u32) -> Result<(), SolverError> {
+    if fixed.len() > num_nodes as usize {
+        return Err(SolverError::InvalidInput(format!(
+            "{} fixed edges do not fit in a tour of {num_nodes} nodes",
+            fixed.len()
+        )));
+    }
+    let mut degree = vec![0u8; num_nodes as usize];
+    let mut parent: Vec<u32> = (0..num_nodes).collect();
+    let mut closed = 0;
+    for &[a, b] in fixed {
+        if a >= num_nodes || b >= num_nodes || a == b {
+            return Err(SolverError::InvalidInput(format!(
+                "fixed edge ({a}, {b}) must join two distinct nodes below {num_nodes}"
+            )));
+        }
+        for node in [a, b] {
+            degree[node as usize] += 1;
+            if degree[node as usize] > 2 {
+                return Err(SolverError::InvalidInput(format!(
+                    "node {node} is in more than two fixed edges"
+                )));
+            }
+        }
+        let (ra, rb) = (find_root(&mut parent, a), find_root(&mut parent, b));
+        if ra == rb {
+            closed += 1;
+        } else {
+            parent[ra as usize] = rb;
+        }
+    }
+    if closed > 0 && (closed > 1 || fixed.len() != num_nodes as usize) {
+        return Err(SolverError::InvalidInput(String::from(
+            "fixed edges close a cycle that misses some nodes",
+        )));
+    }
+    Ok(())
+}
+
+fn find_root(parent: &mut [u32], mut node: u32) -> u32 {
+    while parent[node as usize] != node {
+        parent[node as usize] = parent[parent[node as usize] as usize];
+        node = parent[node as usize];
+    }
+    node
+}
+
+/// Lin-Kernighan heuristic that can be stopped from another thread.
+///
+/// Concorde checks `cancel` wherever it checks the deadline of [`tsp_lk`]; once
+/// [`CancelToken::cancel`] is called the search stops within a few Lin-Kernighan steps
+/// and the best tour found so far is returned. A solve cancelled during setup skips
+/// the rest of it and returns a random tour. See
+/// [`crate::task::tsp_lk_async`] for a future-based variant.
+/// # Examples
+/// ```
+/// use concorde_rs::{solver, task::CancelToken, LowerDistanceMatrix};
+///
+/// let dist_mat =
+///     LowerDistanceMatrix::new(5, vec![0, 3, 0, 4, 4, 0, 2, 6, 5, 0, 7, 3, 8, 6, 0]);
+/// let cancel = CancelToken::new();
+/// let solution = solver::tsp_lk_cancellable(&dist_mat, None, None, None, &cancel).unwrap();
+/// assert_eq!(solution.length, 19);
+/// ```
+/// # Errors
+///
+/// If the solver cannot solve the TSP, the return length from Concorde TSP is -1.0.
+/// Thus, the solver will return SolverError.
+pub fn tsp_lk_cancellable(
+    dist_mat: &LowerDistanceMatrix,
+    stall: Option<i32>,
+    length_bound: Option<f64>,
+    time_bound: Option<Duration>,
+    cancel: &CancelToken,
+) -> Result<Solution, SolverError> {
+    let mut params = LkParams::with_time_bound(time_bound);
+    params.ctl.cancel = cancel.as_ptr();
+    lk_matrix(dist_mat, stall, length_bound, &params)
+}
+
+/// Lin-Kernighan heuristic that reports every improved tour while it runs.
+///
+/// `on_improve` receives the length and the node order of the new best tour. It is
+/// first called right after the initial local search, then on improvements at most once
+/// per `interval`; the last improvement is always delivered before the call returns.
+/// Returning [`ControlFlow::Break`] stops the search, which then returns the reported
+/// tour. Without a callback ([`tsp_lk`]) nothing of this runs.
+/// # Examples
+/// ```
+/// use concorde_rs::{solver, LowerDistanceMatrix};
+/// use std::ops::ControlFlow;
+/// use std::time::Duration;
+///
+/// let dist_mat =
+///     LowerDistanceMatrix::new(5, vec![0, 3, 0, 4, 4, 0, 2, 6, 5, 0, 7, 3, 8, 6, 0]);
+/// let mut lengths = Vec::new();
+/// let solution = solver::tsp_lk_anytime(&dist_mat, None, None, None, Duration::ZERO, |len, _| {
+///     lengths.push(len);
+///     ControlFlow::Continue(())
+/// })
+/// .unwrap();
+/// assert_eq!(lengths.last(), Some(&solution.length));
+/// ```
+/// # Errors
+///
+/// If the solver cannot solve the TSP, the return length from Concorde TSP is -1.0.
+/// Thus, the solver will return SolverError.
+/// # Panics
+///
+/// A panic in `on_improve` stops the search and is resumed once Concorde has returned.
+pub fn tsp_lk_anytime<F>(
+    dist_mat: &LowerDistanceMatrix,
+    stall: Option<i32>,
+    length_bound: Option<f64>,
+    time_bound: Option<Duration>,
+    interval: Duration,
+    mut on_improve: F,
+) -> Result<Solution, SolverError>
+where
+    F: FnMut(u32, &[u32]) -> ControlFlow<()>,
+{
+    let mut state = Anytime {
+        on_improve: &mut on_improve,
+        panic: None,
     };
-    u32::try_from(length).map_or_else(
-        |_| Err(SolverError::SolverFailed(String::from("Lin-Kernighan"))),
-        |val| Ok(Solution { length: val, tour }),
+    let mut params = LkParams::with_time_bound(time_bound);
+    params.ctl.improved = Some(report_improved);
+    params.ctl.improved_arg = std::ptr::addr_of_mut!(state).cast();
+    params.ctl.improved_interval = interval.as_secs_f64();
+    let result = lk_matrix(dist_mat, stall, length_bound, &params);
+    if let Some(payload) = state.panic {
+        panic::resume_unwind(payload);
+    }
+    result
+}
+
+struct Anytime<'a> {
+    on_improve: &'a mut dyn FnMut(u32, &[u32]) -> ControlFlow<()>,
+    panic: Option<Box<dyn Any + Send>>,
+}
+
+unsafe extern "C" fn report_improved(
+    arg: *mut c_void,
+    val: c_double,
+    ncount: c_int,
+    cycle: *const c_int,
+) -> c_int {
+    let state = &mut *arg.cast::<Anytime>();
+    // Node indices are non-negative, so the cycle reads as a `u32` tour in place.
+    let tour = std::slice::from_raw_parts(cycle.cast::<u32>(), ncount as usize);
+    match panic::catch_unwind(AssertUnwindSafe(|| (state.on_improve)(val as u32, tour))) {
+        Ok(ControlFlow::Continue(())) => 0,
+        Ok(ControlFlow::Break(())) => 1,
+        Err(payload) => {
+            state.panic = Some(payload);
+            1
+        }
+    }
+}
+
+fn lk_matrix(
+    dist_mat: &LowerDistanceMatrix,
+    stall: Option<i32>,
+    length_bound: Option<f64>,
+    params: &LkParams,
+) -> Result<Solution, SolverError> {
+    check_lk_matrix(dist_mat)?;
+    lk_solution(
+        dist_mat.num_nodes,
+        stall,
+        length_bound,
+        "Lin-Kernighan",
+        |tour, stall, length_bound| unsafe {
+            CCtsp_lk(
+                dist_mat.values.as_ptr(),
+                tour,
+                dist_mat.num_nodes,
+                stall,
+                length_bound,
+                params,
+            )
+        },
+    )
+}
+
+/// Calls a Concorde Lin-Kernighan routine with the stall count and length bound it
+/// gets for `None` (10⁷ kicks without improvement, no bound), and reads what it
+/// returns, -1 on failure, as the tour length.
+pub(crate) fn call_lk(
+    stall: Option<i32>,
+    length_bound: Option<f64>,
+    name: &str,
+    lk: impl FnOnce(c_int, c_double) -> c_int,
+) -> Result<u32, SolverError> {
+    let length = lk(stall.unwrap_or(10_000_000), length_bound.unwrap_or(-1.0));
+    u32::try_from(length).map_err(|_| SolverError::SolverFailed(String::from(name)))
+}
+
+/// [`call_lk`] on a new tour of `num_nodes` nodes, returned as a [`Solution`].
+fn lk_solution(
+    num_nodes: u32,
+    stall: Option<i32>,
+    length_bound: Option<f64>,
+    name: &str,
+    lk: impl FnOnce(*mut u32, c_int, c_double) -> c_int,
+) -> Result<Solution, SolverError> {
+    let mut tour = vec![0u32; num_nodes as usize];
+    let length = call_lk(stall, length_bound, name, |stall, length_bound| {
+        lk(tour.as_mut_ptr(), stall, length_bound)
+    })?;
+    Ok(Solution {
+        length,
+        tour,
+        stats: None,
+        lower_bound: None,
+    })
+}
+
+/// Runs `chains` independent chained Lin-Kernighan searches concurrently and returns
+/// the best tour found.
+///
+/// The candidate edges are computed once and shared by all chains. The first chain
+/// starts from the same Q-Boruvka tour as [`tsp_lk`]; every other chain starts from a
+/// nearest-neighbor tour out of a random node and kicks with its own seed. Chains run
+/// on up to the available parallelism, so with enough cores the wall-clock time stays
+/// close to that of a single [`tsp_lk`] call. A `time_bound` is shared by all chains:
+/// chains that have not started by the deadline are skipped.
+/// # Examples
+/// ```
+/// use concorde_rs::{solver, LowerDistanceMatrix};
+///
+/// let dist_mat =
+///     LowerDistanceMatrix::new(5, vec![0, 3, 0, 4, 4, 0, 2, 6, 5, 0, 7, 3, 8, 6, 0]);
+/// let solution = solver::tsp_lk_multistart(&dist_mat, 4, None, None, None).unwrap();
+/// assert_eq!(solution.length, 19);
+/// ```
+/// # Errors
+///
+/// Returns `SolverError::InvalidInput` if `chains` is zero or the matrix is too short.
+/// If no chain produced a tour, returns the error of the first chain that failed.
+pub fn tsp_lk_multistart(
+    dist_mat: &LowerDistanceMatrix,
+    chains: usize,
+    stall: Option<i32>,
+    length_bound: Option<f64>,
+    time_bound: Option<Duration>,
+) -> Result<Solution, SolverError> {
+    let deadline = time_bound.map(|bound| Instant::now() + bound);
+    check_lk_matrix(dist_mat)?;
+    if chains == 0 {
+        return Err(SolverError::InvalidInput(String::from(
+            "at least one chain is required",
+        )));
+    }
+    let cands = Candidates::new(dist_mat)?;
+    let threads = thread::available_parallelism()
+        .map_or(1, usize::from)
+        .min(chains);
+    let next = AtomicUsize::new(0);
+
+    thread::scope(|s| {
+        let workers: Vec<_> = (0..threads)
+            .map(|_| {
+                s.spawn(|| {
+                    let mut ws = LkWorkspace::new();
+                    let mut tour = vec![0u32; dist_mat.num_nodes as usize];
+                    let mut best: Option<Solution> = None;
+                    let mut failed: Option<(usize, SolverError)> = None;
+                    loop {
+                        let chain = next.fetch_add(1, Ordering::Relaxed);
+                        if chain >= chains {
+                            break;
+                        }
+                        let mut params = LkParams::default();
+                        if let Some(deadline) = deadline {
+                            let left = deadline.saturating_duration_since(Instant::now());
+                            if chain > 0 && left.is_zero() {
+                                break;
+                            }
+                            params.time_bound = secs(left);
+                        }
+                        if chain > 0 {
+                            params.seed = c_int::try_from(chain).unwrap_or(c_int::MAX);
+                            params.starttype = StartTour::NearestNeighbor as c_int;
+                        }
+                        let length = match ws.lk_chain(
+                            dist_mat,
+                            &cands,
+                            stall,
+                            length_bound,
+                            &params,
+                            &mut tour,
+                        ) {
+                            Ok(length) => length,
+                            Err(err) => {
+                                // Chains are claimed in order, so this worker's first
+                                // failure is its earliest.
+                                failed.get_or_insert((chain, err));
+                                continue;
+                            }
+                        };
+                        if best.as_ref().is_none_or(|b| length < b.length) {
+                            best = Some(Solution {
+                                tour: tour.clone(),
+                                length,
+                                stats: None,
+                                lower_bound: None,
+                            });
+                        }
+                    }
+                    (best, failed)
+                })
+            })
+            .collect();
+        let mut best: Option<Solution> = None;
+        let mut failed: Option<(usize, SolverError)> = None;
+        for worker in workers {
+            let (sol, err) = worker.join().expect("solver thread panicked");
+            if let Some(sol) = sol {
+                if best.as_ref().is_none_or(|b| sol.length < b.length) {
+                    best = Some(sol);
+                }
+            }
+            if let Some((chain, err)) = err {
+                if failed.as_ref().is_none_or(|&(first, _)| chain < first) {
+                    failed = Some((chain, err));
+                }
+            }
+        }
+        best.ok_or_else(|| {
+            failed.map_or_else(
+                || SolverError::SolverFailed(String::from("Lin-Kernighan")),
+                |(_, err)| err,
+            )
+        })
+    })
+}
+
+/// Lin-Kernighan heuristic on node coordinates.
+///
+/// Edge lengths are computed on the fly from `x`, `y` (and `z` for 3D Euclidean
+/// instances) under `norm`, so memory stays linear in the number of nodes. See
+/// [`tsp_lk_coords_with`] to choose the start tour and kicks.
+/// # Examples
+/// ```
+/// use concorde_rs::{solver, Norm};
+///
+/// let x = [0.0, 0.0, 3.0, 3.0];
+/// let y = [0.0, 4.0, 4.0, 0.0];
+/// let sol = solver::tsp_lk_coords(&x, &y, None, Norm::Euclidean, None, None, None);
+/// assert_eq!(sol.unwrap().length, 14);
+/// ```
+/// # Errors
+///
+/// Returns `SolverError::InvalidInput` if the coordinate slices differ in length,
+/// `z` is given for a norm without a 3D variant, or a coordinate is not finite or so
+/// far from the others that an edge length would overflow an `i32`; and
+/// `SolverError::SolverFailed` if Concorde fails to solve the problem.
+pub fn tsp_lk_coords(
+    x: &[f64],
+    y: &[f64],
+    z: Option<&[f64]>,
+    norm: Norm,
+    stall: Option<i32>,
+    length_bound: Option<f64>,
+    time_bound: Option<Duration>,
+) -> Result<Solution, SolverError> {
+    tsp_lk_coords_with(
+        x,
+        y,
+        z,
+        norm,
+        &LkConfig::default(),
+        stall,
+        length_bound,
+        time_bound,
     )
 }
 
+/// [`tsp_lk_coords`] with the start tour, kick, candidate edges and search chosen by
+/// `config`.
+///
+/// Only here do [`StartTour::SpaceFilling`] and [`KickType::Geometric`] differ from
+/// the fallbacks the matrix solvers use, Q-Boruvka and close kicks. Both need the
+/// points of a 2D norm searched with a kd-tree (Euclidean, EuclideanCeil, Manhattan
+/// or Max); Att, Geographic and 3D Euclidean instances get the fallbacks too.
+/// # Examples
+/// ```
+/// use concorde_rs::solver::{self, KickType, LkConfig, StartTour};
+/// use concorde_rs::Norm;
+///
+/// let x = [0.0, 0.0, 3.0, 3.0];
+/// let y = [0.0, 4.0, 4.0, 0.0];
+/// let config = LkConfig {
+///     start: StartTour::SpaceFilling,
+///     kick: KickType::Geometric,
+///     ..LkConfig::default()
+/// };
+/// let sol = solver::tsp_lk_coords_with(&x, &y, None, Norm::Euclidean, &config, None, None, None);
+/// assert_eq!(sol.unwrap().length, 14);
+/// ```
+/// # Errors
+///
+/// As for [`tsp_lk_coords`], and `SolverError::InvalidInput` if `config.search` is out
+/// of range.
+#[allow(clippy::too_many_arguments)]
+pub fn tsp_lk_coords_with(
+    x: &[f64],
+    y: &[f64],
+    z: Option<&[f64]>,
+    norm: Norm,
+    config: &LkConfig,
+    stall: Option<i32>,
+    length_bound: Option<f64>,
+    time_bound: Option<Duration>,
+) -> Result<Solution, SolverError> {
+    if x.len() != y.len() || z.is_some_and(|z| z.len() != x.len()) {
+        return Err(SolverError::InvalidInput(String::from(
+            "coordinate slices must have the same length",
+        )));
+    }
+    let norm_code = norm.code(z.is_some()).ok_or_else(|| {
+        SolverError::InvalidInput(format!("{norm:?} norm does not support z coordinates"))
+    })?;
+    let num_nodes = u32::try_from(x.len())
+        .map_err(|_| SolverError::InvalidInput(String::from("too many nodes")))?;
+    check_lk_nodes(num_nodes)?;
+    check_coords(x, y, z)?;
+    config.run(time_bound, |params| {
+        lk_solution(
+            num_nodes,
+            stall,
+            length_bound,
+            "Lin-Kernighan",
+            |tour, stall, length_bound| unsafe {
+                CCtsp_lk_coords(
+                    x.as_ptr(),
+                    y.as_ptr(),
+                    z.map_or(std::ptr::null(), <[f64]>::as_ptr),
+                    norm_code,
+                    tour,
+                    num_nodes,
+                    stall,
+                    length_bound,
+                    params,
+                )
+            },
+        )
+    })
+}
+
+/// Settings for [`solve_batch`].
+///
+/// * `threads`: number of worker threads, defaults to the available parallelism.
+/// * `hk_max_nodes`: instances with at most this many nodes are solved exactly with
+///   Held-Karp, larger ones with Lin-Kernighan.
+/// * `stall`, `length_bound`, `time_bound`: passed to [`tsp_lk`] for every instance.
+#[derive(Clone, Debug)]
+pub struct BatchConfig {
+    pub threads: Option<usize>,
+    pub hk_max_nodes: u32,
+    pub stall: Option<i32>,
+    pub length_bound: Option<f64>,
+    pub time_bound: Option<Duration>,
+}
+
+impl Default for BatchConfig {
+    fn default() -> Self {
+        Self {
+            threads: None,
+            hk_max_nodes: 16,
+            stall: None,
+            length_bound: None,
+            time_bound: None,
+        }
+    }
+}
+
+/// Solves many independent instances on a pool of worker threads.
+///
+/// Workers claim the next unsolved instance as soon as they are free, so a few large
+/// instances do not hold up the rest of the batch. Each worker keeps one
+/// [`LkWorkspace`] for all the Lin-Kernighan instances it solves. Results are returned
+/// in input order.
+/// # Examples
+/// ```
+/// use concorde_rs::{solver, LowerDistanceMatrix};
+///
+/// let dist_mat =
+///     LowerDistanceMatrix::new(5, vec![0, 3, 0, 4, 4, 0, 2, 6, 5, 0, 7, 3, 8, 6, 0]);
+/// let batch = vec![dist_mat; 8];
+/// let results = solver::solve_batch(&batch, &solver::BatchConfig::default());
+/// assert!(results.iter().all(|sol| sol.as_ref().unwrap().length == 19));
+/// ```
+#[must_use]
+pub fn solve_batch(
+    instances: &[LowerDistanceMatrix],
+    config: &BatchConfig,
+) -> Vec<Result<Solution, SolverError>> {
+    let threads = config
+        .threads
+        .unwrap_or_else(|| thread::available_parallelism().map_or(1, usize::from))
+        .clamp(1, instances.len().max(1));
+    let next = AtomicUsize::new(0);
+
+    let mut solved: Vec<(usize, Result<Solution, SolverError>)> = thread::scope(|s| {
+        let workers: Vec<_> = (0..threads)
+            .map(|_| {
+                s.spawn(|| {
+                    let mut ws = LkWorkspace::new();
+                    let mut done = Vec::new();
+                    loop {
+                        let i = next.fetch_add(1, Ordering::Relaxed);
+                        let Some(dist_mat) = instances.get(i) else {
+                            break;
+                        };
+                        done.push((i, solve_one(dist_mat, config, &mut ws)));
+                    }
+                    done
+                })
+            })
+            .collect();
+        workers
+            .into_iter()
+            .flat_map(|worker| worker.join().expect("solver thread panicked"))
+            .collect()
+    });
+    solved.sort_unstable_by_key(|&(i, _)| i);
+    solved.into_iter().map(|(_, result)| result).collect()
+}
+
+fn solve_one(
+    dist_mat: &LowerDistanceMatrix,
+    config: &BatchConfig,
+    ws: &mut LkWorkspace,
+) -> Result<Solution, SolverError> {
+    if dist_mat.num_nodes <= config.hk_max_nodes {
+        // The batch already keeps every core busy.
+        let config = HkConfig {
+            threads: Some(1),
+            ..HkConfig::default()
+        };
+        return tsp_hk_with(dist_mat, &config, None, None);
+    }
+    let mut tour = vec![0u32; dist_mat.num_nodes as usize];
+    let length = ws.tsp_lk(
+        dist_mat,
+        config.stall,
+        config.length_bound,
+        config.time_bound,
+        &mut tour,
+    )?;
+    Ok(Solution {
+        tour,
+        length,
+        stats: None,
+        lower_bound: None,
+    })
+}
+
+/// Concorde indexes the borrowed buffer directly, so it must hold the full lower triangle.
+pub(crate) fn check_matrix(dist_mat: &LowerDistanceMatrix) -> Result<(), SolverError> {
+    let num_nodes = u64::from(dist_mat.num_nodes);
+    if (dist_mat.values.len() as u64) < num_nodes * (num_nodes + 1) / 2 {
+        return Err(SolverError::InvalidInput(format!(
+            "{} values cannot hold the lower triangle of {num_nodes} nodes",
+            dist_mat.values.len()
+        )));
+    }
+    Ok(())
+}
+
+/// Concorde computes edge lengths as `c_int`s, so coordinates must be finite and close
+/// enough that the L1 span of all points, which bounds every norm, fits one.
+fn check_coords(x: &[f64], y: &[f64], z: Option<&[f64]>) -> Result<(), SolverError> {
+    let mut span = 0.0;
+    for axis in [Some(x), Some(y), z].into_iter().flatten() {
+        if let Some(value) = axis.iter().find(|value| !value.is_finite()) {
+            return Err(SolverError::InvalidInput(format!(
+                "coordinate {value} is not finite"
+            )));
+        }
+        let (min, max) = axis
+            .iter()
+            .fold((f64::INFINITY, f64::NEG_INFINITY), |(min, max), &value| {
+                (min.min(value), max.max(value))
+            });
+        span += max - min;
+    }
+    if span >= f64::from(c_int::MAX) {
+        return Err(SolverError::InvalidInput(format!(
+            "coordinates span {span}, too far apart for edge lengths to fit an i32"
+        )));
+    }
+    Ok(())
+}
+
+/// [`check_matrix`] for Lin-Kernighan, which has no candidate edges to search below 3 nodes.
+pub(crate) fn check_lk_matrix(dist_mat: &LowerDistanceMatrix) -> Result<(), SolverError> {
+    check_matrix(dist_mat)?;
+    check_lk_nodes(dist_mat.num_nodes)
+}
+
+fn check_lk_nodes(num_nodes: u32) -> Result<(), SolverError> {
+    if num_nodes < 3 {
+        return Err(SolverError::InvalidInput(format!(
+            "Lin-Kernighan needs at least 3 nodes, not {num_nodes}"
+        )));
+    }
+    Ok(())
+}
+
+/// How Lin-Kernighan builds its start tour (`CC_LK_*_START` in linkern.h).
+#[derive(Clone, Copy, Debug, Default, PartialEq, Eq)]
+pub enum StartTour {
+    /// A random order of the nodes.
+    Random = 0,
+    /// Nearest neighbour from a random node.
+    NearestNeighbor = 1,
+    /// Shortest edges first, as long as they still fit in a tour.
+    Greedy = 2,
+    /// Greedy edges added in Boruvka passes; fast and nearly as good.
+    #[default]
+    QBoruvka = 3,
+    /// The order along a space-filling curve. It needs the points of a 2D kd-tree
+    /// norm, so matrices and the other norms get [`StartTour::QBoruvka`].
+    SpaceFilling = 4,
+}
+
+/// The double-bridge kick Lin-Kernighan applies when it gets stuck (`CC_LK_*_KICK`
+/// in linkern.h). Each picks four tour edges to reconnect.
+#[derive(Clone, Copy, Debug, Default, PartialEq, Eq)]
+pub enum KickType {
+    /// Four edges anywhere in the tour.
+    Random = 0,
+    /// Edges at points near one another. It needs the points of a 2D kd-tree norm, so
+    /// matrices and the other norms get [`KickType::Close`].
+    Geometric = 1,
+    /// Edges at nodes close to the first one, out of a random sample.
+    Close = 2,
+    /// Edges found by short random walks on the candidate edges.
+    #[default]
+    Walk = 3,
+}
+
+/// The edges each node may try in Lin-Kernighan moves (`CC_LK_*_CANDS` in linkern.h).
+#[derive(Clone, Copy, Debug, Default, PartialEq, Eq)]
+pub enum CandidateSet {
+    /// The 8 nearest neighbours.
+    #[default]
+    Nearest = 0,
+    /// The 5 alpha-nearest neighbours, see [`tsp_lk_alpha`].
+    AlphaNearest = 1,
+}
+
+/// How deep and wide each Lin-Kernighan move is searched (`CClk_search` in linkern.h).
+///
+/// * `max_depth`: the most flips in one improving move, 1 to 1000.
+/// * `kick_max_depth`: the most flips in one kick, up to 1000.
+/// * `breadth`: `breadth[i]` flips, at most 12, are tried at depth `i` before
+///   giving up on the move; the first 0 ends the list, and deeper levels try only
+///   the best flip.
+/// * `mak_morton`: also try Mak-Morton moves, which flip at the fixed end.
+/// * `less_or_equal`: also try edges exactly as long as the gain so far.
+///
+/// [`LkSearch::DEFAULT`], [`LkSearch::FAST`] and [`LkSearch::DEEP`] run compiled
+/// copies of the inner search; any other setting runs a slightly slower copy.
+/// # Examples
+/// ```
+/// use concorde_rs::solver::{self, LkConfig, LkSearch};
+/// use concorde_rs::LowerDistanceMatrix;
+///
+/// let dist_mat =
+///     LowerDistanceMatrix::new(5, vec![0, 3, 0, 4, 4, 0, 2, 6, 5, 0, 7, 3, 8, 6, 0]);
+/// let config = LkConfig {
+///     search: LkSearch {
+///         breadth: [8, 4, 2, 0, 0, 0, 0, 0],
+///         ..LkSearch::FAST
+///     },
+///     ..LkConfig::default()
+/// };
+/// let solution = solver::tsp_lk_with(&dist_mat, &config, None, None, None).unwrap();
+/// assert_eq!(solution.length, 19);
+/// ```
+#[derive(Clone, Copy, Debug, PartialEq, Eq)]
+pub struct LkSearch {
+    pub max_depth: u32,
+    pub kick_max_depth: u32,
+    pub breadth: [u32; 8],
+    pub mak_morton: bool,
+    pub less_or_equal: bool,
+}
+
+impl LkSearch {
+    /// Concorde's search: depth 25, trying 4, 3, 3 and 2 flips at the first levels.
+    pub const DEFAULT: Self = Self {
+        max_depth: 25,
+        kick_max_depth: 50,
+        breadth: [4, 3, 3, 2, 0, 0, 0, 0],
+        mak_morton: true,
+        less_or_equal: true,
+    };
+    /// Depth 10, trying 3 and 2 flips; for quick tours of large instances.
+    pub const FAST: Self = Self {
+        max_depth: 10,
+        kick_max_depth: 25,
+        breadth: [3, 2, 0, 0, 0, 0, 0, 0],
+        mak_morton: true,
+        less_or_equal: true,
+    };
+    /// Depth 50, trying 5, 4, 3, 3 and 2 flips; slower kicks that find more.
+    pub const DEEP: Self = Self {
+        max_depth: 50,
+        kick_max_depth: 50,
+        breadth: [5, 4, 3, 3, 2, 0, 0, 0],
+        mak_morton: true,
+        less_or_equal: true,
+    };
+
+    fn params(&self) -> Result<LkSearchParams, SolverError> {
+        if !(1..=1000).contains(&self.max_depth) || self.kick_max_depth > 1000 {
+            return Err(SolverError::InvalidInput(format!(
+                "search depths {} and {} are out of range",
+                self.max_depth, self.kick_max_depth
+            )));
+        }
+        if let Some(count) = self.breadth.iter().find(|&&count| count > 12) {
+            return Err(SolverError::InvalidInput(format!(
+                "search breadth {count} is above 12"
+            )));
+        }
+        let backtrack = self.breadth.iter().take_while(|&&count| count > 0).count();
+        let mut backtrack_count = [0; 8];
+        for (to, &from) in backtrack_count.iter_mut().zip(&self.breadth[..backtrack]) {
+            *to = from as c_int;
+        }
+        Ok(LkSearchParams {
+            maxdepth: self.max_depth as c_int,
+            kick_maxdepth: self.kick_max_depth as c_int,
+            backtrack: backtrack as c_int,
+            backtrack_count,
+            mak_morton: c_int::from(self.mak_morton),
+            less_or_equal: c_int::from(self.less_or_equal),
+        })
+    }
+}
+
+impl Default for LkSearch {
+    fn default() -> Self {
+        Self::DEFAULT
+    }
+}
+
+/// Which open subproblem the Held-Karp branch-and-bound takes next
+/// (`CC_HK_*` in heldkarp.h).
+#[derive(Clone, Copy, Debug, Default, PartialEq, Eq)]
+pub enum NodeSelection {
+    /// Dive into the last subproblem opened; little memory, but a poor early dive
+    /// is searched to the bottom.
+    #[default]
+    DepthFirst = 0,
+    /// The subproblem with the least lower bound, diving depth-first while the pool
+    /// of open subproblems is at its memory cap.
+    BestFirst = 1,
+}
+
+/// Settings for [`tsp_hk_with`].
+///
+/// * `threads`: branch-and-bound threads, defaults to the available parallelism. Idle
+///   threads take open subproblems from busy ones, and a tour found on any thread
+///   prunes the search on all of them.
+/// * `node_selection`: the order the subproblems are searched in.
+/// * `pool_memory`: bytes the open subproblems of [`NodeSelection::BestFirst`] may
+///   take, defaults to 256 MiB.
+#[derive(Clone, Copy, Debug, Default, PartialEq, Eq)]
+pub struct HkConfig {
+    pub threads: Option<usize>,
+    pub node_selection: NodeSelection,
+    pub pool_memory: Option<usize>,
+}
+
+impl HkConfig {
+    fn params(&self, time_bound: Option<Duration>) -> Result<HkParams, SolverError> {
+        let threads = match self.threads {
+            Some(0) => {
+                return Err(SolverError::InvalidInput(String::from(
+                    "Held-Karp needs at least one thread",
+                )))
+            }
+            Some(threads) => threads,
+            None => thread::available_parallelism().map_or(1, usize::from),
+        };
+        let mut params = HkParams {
+            nthreads: c_int::try_from(threads).unwrap_or(c_int::MAX),
+            nodesel: self.node_selection as c_int,
+            time_bound: time_bound.map_or(-1.0, secs),
+            ..HkParams::default()
+        };
+        if let Some(bytes) = self.pool_memory {
+            params.pool_memory = bytes as c_double;
+        }
+        Ok(params)
+    }
+}
+
+/// Mirrors `CCheldkarp_config` in heldkarp.h.
+#[repr(C)]
+struct HkParams {
+    nthreads: c_int,
+    nodesel: c_int,
+    time_bound: c_double,
+    pool_memory: c_double,
+}
+
+/// Per-call settings for [`tsp_lk_with`] and [`tsp_lk_coords_with`].
+///
+/// * `start`: how the start tour is built.
+/// * `kick`: the kick used between Lin-Kernighan searches.
+/// * `candidates`: the candidate edges.
+/// * `search`: how deep and wide each move is searched.
+/// * `seed`: seeds Concorde's random choices; equal seeds repeat a run.
+/// * `stats`: return [`SolveStats`] in [`Solution::stats`]. Without it the phases
+///   are not timed.
+#[derive(Clone, Copy, Debug, Default, PartialEq, Eq)]
+pub struct LkConfig {
+    pub start: StartTour,
+    pub kick: KickType,
+    pub candidates: CandidateSet,
+    pub search: LkSearch,
+    pub seed: i32,
+    pub stats: bool,
+}
+
+impl LkConfig {
+    /// Runs `solve` on the parameters for this config and attaches the stats.
+    fn run(
+        &self,
+        time_bound: Option<Duration>,
+        solve: impl FnOnce(&LkParams) -> Result<Solution, SolverError>,
+    ) -> Result<Solution, SolverError> {
+        let mut stats = LkStats::default();
+        let mut params = LkParams {
+            seed: self.seed,
+            kicktype: self.kick as c_int,
+            starttype: self.start as c_int,
+            candtype: self.candidates as c_int,
+            ..LkParams::with_time_bound(time_bound)
+        };
+        params.ctl.search = self.search.params()?;
+        if self.stats {
+            params.ctl.stats = std::ptr::addr_of_mut!(stats);
+        }
+        let mut solution = solve(&params)?;
+        if self.stats {
+            solution.stats = Some(SolveStats::from(&stats));
+        }
+        Ok(solution)
+    }
+}
+
+/// Mirrors `CCtsp_lkconfig` in linkern.h.
+#[repr(C)]
+pub(crate) struct LkParams {
+    pub seed: c_int,
+    pub kicktype: c_int,
+    pub starttype: c_int,
+    pub candtype: c_int,
+    pub silent: c_int,
+    pub time_bound: c_double,
+    pub ctl: LkControl,
+}
+
+/// Mirrors `CClk_control` in linkern.h.
+#[repr(C)]
+pub(crate) struct LkControl {
+    pub cancel: *const c_int,
+    pub improved: Option<unsafe extern "C" fn(*mut c_void, c_double, c_int, *const c_int) -> c_int>,
+    pub improved_arg: *mut c_void,
+    pub improved_interval: c_double,
+    pub search: LkSearchParams,
+    pub stats: *mut LkStats,
+}
+
+/// Mirrors `CClk_stats` in linkern.h.
+#[repr(C)]
+#[derive(Default)]
+pub(crate) struct LkStats {
+    pub load_time: c_double,
+    pub candidate_time: c_double,
+    pub start_time: c_double,
+    pub initial_time: c_double,
+    pub kick_time: c_double,
+    pub kicks: c_double,
+    pub improving_kicks: c_double,
+    pub last_improvement: c_double,
+    pub flips: c_double,
+    pub splits: c_double,
+    pub dist_lookups: c_double,
+    pub dist_misses: c_double,
+    pub process_peak_rss: c_double,
+}
+
+/// Mirrors `CClk_search` in linkern.h.
+#[repr(C)]
+pub(crate) struct LkSearchParams {
+    pub maxdepth: c_int,
+    pub kick_maxdepth: c_int,
+    pub backtrack: c_int,
+    pub backtrack_count: [c_int; 8],
+    pub mak_morton: c_int,
+    pub less_or_equal: c_int,
+}
+
+impl LkParams {
+    pub(crate) fn with_time_bound(time_bound: Option<Duration>) -> Self {
+        Self {
+            time_bound: time_bound.map_or(-1.0, secs),
+            ..Self::default()
+        }
+    }
+}
+
+/// Concorde reads a non-positive bound as "no bound", so an exhausted budget is
+/// rounded up to the smallest step that still stops the search at once.
+fn secs(bound: Duration) -> c_double {
+    bound.as_secs_f64().max(1e-9)
+}
+
+impl Default for LkParams {
+    fn default() -> Self {
+        let mut params = std::mem::MaybeUninit::uninit();
+        unsafe {
+            CCtsp_init_lkconfig(params.as_mut_ptr());
+            params.assume_init()
+        }
+    }
+}
+
+impl Default for HkParams {
+    fn default() -> Self {
+        let mut params = std::mem::MaybeUninit::uninit();
+        unsafe {
+            CCheldkarp_init_config(params.as_mut_ptr());
+            params.assume_init()
+        }
+    }
+}
+
+/// `CCtsp_hk` returns this when the tour it found is longer than `i32::MAX`.
+const CC_HK_TOUR_TOO_LONG: i32 = -2;
+
 extern "C" {
-    fn CCtsp_hk(dist_mat: *const c_uint, tour: *mut c_uint, ncount: c_uint) -> i32;
+    fn CCtsp_init_lkconfig(cfg: *mut LkParams);
+    fn CCheldkarp_init_config(cfg: *mut HkParams);
+    fn CCtsp_hk(
+        dist_mat: *const c_uint,
+        tour: *mut c_uint,
+        ncount: c_uint,
+        nodelimit: c_int,
+        lowbound: *mut c_double,
+        cfg: *const HkParams,
+    ) -> i32;
+    fn CCtsp_hk_bound(dist_mat: *const c_uint, ncount: c_uint, lowbound: *mut c_double) -> i32;
     fn CCtsp_lk(
         dist_mat: *const c_uint,
         tour: *mut c_uint,
         ncount: c_uint,
         stall_count: c_int,
         length_bound: c_double,
+        cfg: *const LkParams,
+    ) -> i32;
+    fn CCtsp_lk_from(
+        dist_mat: *const c_uint,
+        start: *const c_uint,
+        tour: *mut c_uint,
+        ncount: c_uint,
+        stall_count: c_int,
+        length_bound: c_double,
+        cfg: *const LkParams,
+    ) -> i32;
+    fn CCtsp_lk_path(
+        dist_mat: *const c_uint,
+        start: c_uint,
+        end: c_uint,
+        tour: *mut c_uint,
+        ncount: c_uint,
+        stall_count: c_int,
+        length_bound: c_double,
+        cfg: *const LkParams,
+    ) -> i32;
+    fn CCtsp_lk_fixed(
+        dist_mat: *const c_uint,
+        fcount: c_int,
+        flist: *const c_uint,
+        tour: *mut c_uint,
+        ncount: c_uint,
+        stall_count: c_int,
+        length_bound: c_double,
+        cfg: *const LkParams,
+    ) -> i32;
+    fn CCtsp_lk_coords(
+        x: *const c_double,
+        y: *const c_double,
+        z: *const c_double,
+        norm: c_int,
+        tour: *mut c_uint,
+        ncount: c_uint,
+        stall_count: c_int,
+        length_bound: c_double,
+        cfg: *const LkParams,
     ) -> i32;
 }
 
@@ -69,10 +1575,95 @@ extern "C" {
 ///
 /// * `tour`:
 /// * `length`:
+/// * `stats`: what the solve did, when [`LkConfig::stats`] asked for it.
+/// * `lower_bound`: no tour is shorter than this. Held-Karp sets it, equal to `length`
+///   unless a limit stopped the search; it stays `None` if the limit came before the
+///   root of the branch-and-bound was bounded.
 #[derive(Clone, Debug)]
 pub struct Solution {
     pub tour: Vec<u32>,
     pub length: u32,
+    pub stats: Option<SolveStats>,
+    pub lower_bound: Option<u32>,
+}
+
+/// What one Lin-Kernighan solve did and where its time went.
+///
+/// * `load`, `candidates`, `start_tour`, `initial_lk`, `kick_loop`: wall time spent
+///   reading the instance, building the candidate edges and the start tour, in
+///   the local search from the start tour, and in the kicks after it.
+/// * `kicks`, `improving_kicks`: kicks made, and those that shortened the tour.
+/// * `last_improvement`: the kick that last shortened the tour, 0 if none did. A
+///   value far below `kicks` means `stall` could be cut.
+/// * `flips`, `segment_splits`: tour flips, and the splits of the two-level list
+///   they needed.
+/// * `dist_lookups`, `dist_misses`: edge lengths asked of the distance cache, and
+///   those it had to compute.
+/// * `process_peak_rss`: the peak resident set of the whole process in bytes, 0
+///   where the system does not report it. It is read when the solve ends and covers
+///   everything the process did before and alongside it, so it is an upper bound on
+///   the solve's own footprint rather than a measure of it.
+/// # Examples
+/// ```
+/// use concorde_rs::solver::{self, LkConfig};
+/// use concorde_rs::LowerDistanceMatrix;
+///
+/// let dist_mat =
+///     LowerDistanceMatrix::new(5, vec![0, 3, 0, 4, 4, 0, 2, 6, 5, 0, 7, 3, 8, 6, 0]);
+/// let config = LkConfig {
+///     stats: true,
+///     ..LkConfig::default()
+/// };
+/// let solution = solver::tsp_lk_with(&dist_mat, &config, None, None, None).unwrap();
+/// let stats = solution.stats.unwrap();
+/// assert!(stats.improving_kicks <= stats.kicks);
+/// ```
+#[derive(Clone, Copy, Debug, Default, PartialEq)]
+pub struct SolveStats {
+    pub load: Duration,
+    pub candidates: Duration,
+    pub start_tour: Duration,
+    pub initial_lk: Duration,
+    pub kick_loop: Duration,
+    pub kicks: u64,
+    pub improving_kicks: u64,
+    pub last_improvement: u64,
+    pub flips: u64,
+    pub segment_splits: u64,
+    pub dist_lookups: u64,
+    pub dist_misses: u64,
+    pub process_peak_rss: u64,
+}
+
+impl SolveStats {
+    /// The share of edge lengths found in the distance cache.
+    pub fn cache_hit_rate(&self) -> f64 {
+        if self.dist_lookups == 0 {
+            return 0.0;
+        }
+        1.0 - self.dist_misses as f64 / self.dist_lookups as f64
+    }
+}
+
+impl From<&LkStats> for SolveStats {
+    fn from(stats: &LkStats) -> Self {
+        let time = |secs: c_double| Duration::from_secs_f64(secs.max(0.0));
+        Self {
+            load: time(stats.load_time),
+            candidates: time(stats.candidate_time),
+            start_tour: time(stats.start_time),
+            initial_lk: time(stats.initial_time),
+            kick_loop: time(stats.kick_time),
+            kicks: stats.kicks as u64,
+            improving_kicks: stats.improving_kicks as u64,
+            last_improvement: stats.last_improvement as u64,
+            flips: stats.flips as u64,
+            segment_splits: stats.splits as u64,
+            dist_lookups: stats.dist_lookups as u64,
+            dist_misses: stats.dist_misses as u64,
+            process_peak_rss: (stats.process_peak_rss * 1024.0) as u64,
+        }
+    }
 }
 
 impl PartialEq for Solution {
@@ -116,12 +1707,13 @@ impl fmt::Display for Solution {
 #[cfg(test)]
 mod tests {
     use super::*;
+    use crate::testing::{euclid_matrix, grid_matrix, random_points};
 
     #[test]
     fn test_5_cities_instance() {
         let dist_mat =
             LowerDistanceMatrix::new(5, vec![0, 3, 0, 4, 4, 0, 2, 6, 5, 0, 7, 3, 8, 6, 0]);
-        let sol = tsp_hk(&dist_mat).unwrap();
+        let sol = tsp_hk(&dist_mat, None, None).unwrap();
         assert_eq!(sol.length, 19);
         assert_eq!(Solution::calc_length_from_tour(&sol.tour, &dist_mat), 19);
     }
@@ -136,11 +1728,48 @@ mod tests {
                 372, 175, 338, 264, 232, 249, 0, 505, 289, 262, 476, 196, 360, 444, 402, 495, 0,
             ],
         );
-        let sol = tsp_hk(&dist_mat).unwrap();
+        let sol = tsp_hk(&dist_mat, None, None).unwrap();
         assert_eq!(sol.length, 1637);
         assert_eq!(Solution::calc_length_from_tour(&sol.tour, &dist_mat), 1637);
     }
 
+    #[test]
+    fn test_hk_long_edges() {
+        // The 10-city instance in millimetres: edges up to 661_000, far past 2^15.
+        let values = vec![
+            0, 633, 0, 257, 390, 0, 91, 661, 228, 0, 412, 227, 169, 383, 0, 150, 488, 112, 120,
+            267, 0, 80, 572, 196, 77, 351, 63, 0, 134, 530, 154, 105, 309, 34, 29, 0, 259, 555,
+            372, 175, 338, 264, 232, 249, 0, 505, 289, 262, 476, 196, 360, 444, 402, 495, 0,
+        ];
+        let dist_mat = LowerDistanceMatrix::new(10, values.iter().map(|d| d * 1000).collect());
+        let sol = tsp_hk(&dist_mat, None, None).unwrap();
+        assert_eq!(sol.length, 1_637_000);
+        assert_eq!(
+            Solution::calc_length_from_tour(&sol.tour, &dist_mat),
+            1_637_000
+        );
+    }
+
+    #[test]
+    fn test_hk_lk_overflow() {
+        // Nodes on a line; LK keeps tour lengths in an i32, so it must not seed these.
+        let line = |n: u32, step: u32| {
+            let values = (0..n)
+                .flat_map(|i| (0..=i).map(move |j| (i - j) * step))
+                .collect();
+            LowerDistanceMatrix::new(n, values)
+        };
+        let sol = tsp_hk(&line(12, 90_000_000), None, None).unwrap();
+        assert_eq!(sol.length, 1_980_000_000);
+        // The optimal tour is 2_240_000_000, past what Held-Karp can return.
+        let err = tsp_hk(&line(8, 160_000_000), None, None).unwrap_err();
+        assert!(matches!(err, SolverError::SolverFailed(msg) if msg.contains("i32::MAX")));
+        let err = tsp_hk(&line(7, 200_000_000), None, None).unwrap_err();
+        assert!(matches!(err, SolverError::SolverFailed(msg) if msg.contains("i32::MAX")));
+        let err = tsp_hk(&line(2, 2_000_000_000), None, None).unwrap_err();
+        assert!(matches!(err, SolverError::SolverFailed(msg) if msg.contains("i32::MAX")));
+    }
+
     #[test]
     fn test_14_cities_instance() {
         let dist_mat = LowerDistanceMatrix::new(
@@ -153,7 +1782,7 @@ mod tests {
                 68, 49, 56, 0, 51, 45, 38, 49, 54, 71, 55, 52, 57, 35, 56, 39, 53, 0,
             ],
         );
-        let sol = tsp_hk(&dist_mat).unwrap();
+        let sol = tsp_hk(&dist_mat, None, None).unwrap();
         assert_eq!(sol.length, 284);
         assert_eq!(Solution::calc_length_from_tour(&sol.tour, &dist_mat), 284);
     }
@@ -174,7 +1803,7 @@ mod tests {
                 29, 36, 236, 390, 238, 301, 55, 96, 153, 336, 0,
             ],
         );
-        let sol = tsp_lk(&dist_mat, None, None).unwrap();
+        let sol = tsp_lk(&dist_mat, None, None, None).unwrap();
         assert_eq!(sol.length, 2085);
         assert_eq!(Solution::calc_length_from_tour(&sol.tour, &dist_mat), 2085);
     }
@@ -205,7 +1834,7 @@ mod tests {
                 95, 51, 51, 81, 79, 37, 27, 58, 107, 90, 0,
             ],
         );
-        let sol = tsp_lk(&dist_mat, None, None).unwrap();
+        let sol = tsp_lk(&dist_mat, None, None, None).unwrap();
         assert_eq!(sol.length, 937);
         assert_eq!(Solution::calc_length_from_tour(&sol.tour, &dist_mat), 937);
     }
@@ -247,8 +1876,669 @@ mod tests {
                 77, 60, 55, 93, 56, 91, 92, 84, 63, 116, 41, 69, 86, 40, 96, 42, 87, 92, 75, 89, 0,
             ],
         );
-        let sol = tsp_lk(&dist_mat, None, None).unwrap();
+        let sol = tsp_lk(&dist_mat, None, None, None).unwrap();
         assert_eq!(sol.length, 476);
         assert_eq!(Solution::calc_length_from_tour(&sol.tour, &dist_mat), 476);
+
+        // The LK tour is optimal, so Held-Karp only has to prove it.
+        let sol = tsp_hk(&dist_mat, None, None).unwrap();
+        assert_eq!(sol.length, 476);
+        assert_eq!(Solution::calc_length_from_tour(&sol.tour, &dist_mat), 476);
+    }
+
+    #[test]
+    fn test_concurrent_solves() {
+        fn assert_send_sync<T: Send + Sync>() {}
+        assert_send_sync::<LowerDistanceMatrix>();
+        assert_send_sync::<Solution>();
+        assert_send_sync::<Norm>();
+
+        let (x, y): (Vec<f64>, Vec<f64>) = (0..200)
+            .map(|i| (f64::from(i * 37 % 101), f64::from(i * 53 % 97)))
+            .unzip();
+        let expected = tsp_lk_coords(&x, &y, None, Norm::Euclidean, None, None, None).unwrap();
+        std::thread::scope(|s| {
+            let handles: Vec<_> = (0..4)
+                .map(|_| s.spawn(|| tsp_lk_coords(&x, &y, None, Norm::Euclidean, None, None, None)))
+                .collect();
+            for handle in handles {
+                let sol = handle.join().unwrap().unwrap();
+                assert_eq!(sol.length, expected.length);
+                assert_eq!(sol.tour, expected.tour);
+            }
+        });
+    }
+
+    #[test]
+    fn test_solve_batch_order() {
+        let small = LowerDistanceMatrix::new(5, vec![0, 3, 0, 4, 4, 0, 2, 6, 5, 0, 7, 3, 8, 6, 0]);
+        let large = grid_matrix(6, 30);
+        let short = LowerDistanceMatrix::new(5, vec![0, 3, 0]);
+
+        let batch = vec![small.clone(), large.clone(), short, large, small];
+        let config = BatchConfig {
+            threads: Some(3),
+            ..BatchConfig::default()
+        };
+        let results = solve_batch(&batch, &config);
+        assert_eq!(results.len(), 5);
+        assert_eq!(results[0].as_ref().unwrap().length, 19);
+        assert_eq!(results[1].as_ref().unwrap().length, 300);
+        assert!(results[2].is_err());
+        assert_eq!(results[3].as_ref().unwrap().length, 300);
+        assert_eq!(results[4].as_ref().unwrap().length, 19);
+        assert!(solve_batch(&[], &config).is_empty());
+    }
+
+    #[test]
+    fn test_lk_multistart() {
+        let dist_mat = grid_matrix(8, 48);
+
+        let single = tsp_lk_multistart(&dist_mat, 1, None, None, None).unwrap();
+        assert_eq!(single, tsp_lk(&dist_mat, None, None, None).unwrap());
+        let multi = tsp_lk_multistart(&dist_mat, 6, None, None, None).unwrap();
+        assert_eq!(multi.length, 480);
+        assert_eq!(Solution::calc_length_from_tour(&multi.tour, &dist_mat), 480);
+        assert!(tsp_lk_multistart(&dist_mat, 0, None, None, None).is_err());
+    }
+
+    #[test]
+    fn test_short_matrix() {
+        let dist_mat = LowerDistanceMatrix::new(5, vec![0, 3, 0, 4, 4, 0]);
+        assert!(tsp_hk(&dist_mat, None, None).is_err());
+        assert!(tsp_lk(&dist_mat, None, None, None).is_err());
+    }
+
+    #[test]
+    fn test_too_few_nodes() {
+        for dist_mat in [
+            LowerDistanceMatrix::new(1, vec![0]),
+            LowerDistanceMatrix::new(2, vec![0, 5, 0]),
+        ] {
+            assert!(tsp_lk(&dist_mat, None, None, None).is_err());
+            assert!(tsp_lk_alpha(&dist_mat, None, None, None).is_err());
+            assert!(tsp_lk_multistart(&dist_mat, 2, None, None, None).is_err());
+        }
+        assert!(tsp_lk_coords(&[0.0], &[0.0], None, Norm::Euclidean, None, None, None).is_err());
+    }
+
+    #[test]
+    fn test_bad_coords() {
+        let (x, y): (Vec<f64>, Vec<f64>) = random_points(99, 20, 100.0).into_iter().unzip();
+        let norms = [
+            Norm::Euclidean,
+            Norm::EuclideanCeil,
+            Norm::Manhattan,
+            Norm::Max,
+            Norm::Att,
+            Norm::Geographic,
+        ];
+        for bad in [f64::NAN, f64::INFINITY, f64::NEG_INFINITY, 1e10] {
+            let mut bad_x = x.clone();
+            bad_x[7] = bad;
+            for norm in norms {
+                let sol = tsp_lk_coords(&bad_x, &y, None, norm, None, None, None);
+                assert!(
+                    matches!(sol, Err(SolverError::InvalidInput(_))),
+                    "{bad} {norm:?}"
+                );
+            }
+            let mut z = vec![0.0; 20];
+            z[3] = bad;
+            let sol = tsp_lk_coords(&x, &y, Some(&z), Norm::Euclidean, None, None, None);
+            assert!(matches!(sol, Err(SolverError::InvalidInput(_))), "{bad} z");
+        }
+        assert!(tsp_lk_coords(&x, &y, None, Norm::Euclidean, None, None, None).is_ok());
+    }
+
+    #[test]
+    fn test_hk_tiny() {
+        // Held-Karp has nothing to branch on, but the single tour is still a solution.
+        let sol = tsp_hk(&LowerDistanceMatrix::new(1, vec![0]), None, None).unwrap();
+        assert_eq!(
+            (sol.length, sol.tour, sol.lower_bound),
+            (0, vec![0], Some(0))
+        );
+        let sol = tsp_hk(&LowerDistanceMatrix::new(2, vec![0, 5, 0]), None, None).unwrap();
+        assert_eq!(
+            (sol.length, sol.tour, sol.lower_bound),
+            (10, vec![0, 1], Some(10))
+        );
+    }
+
+    #[test]
+    fn test_grid_coords_instance() {
+        let (x, y): (Vec<f64>, Vec<f64>) = (0..20)
+            .map(|i| (f64::from(i % 5) * 10.0, f64::from(i / 5) * 10.0))
+            .unzip();
+        let sol = tsp_lk_coords(&x, &y, None, Norm::Euclidean, None, None, None).unwrap();
+        assert_eq!(sol.length, 200);
+        let mut visited = sol.tour.clone();
+        visited.sort_unstable();
+        assert_eq!(visited, (0..20).collect::<Vec<u32>>());
+
+        let z = vec![0.0; 20];
+        let sol = tsp_lk_coords(&x, &y, Some(&z), Norm::Euclidean, None, None, None).unwrap();
+        assert_eq!(sol.length, 200);
+        assert!(tsp_lk_coords(&x, &y, Some(&z), Norm::Att, None, None, None).is_err());
+        assert!(tsp_lk_coords(&x, &y[1..], None, Norm::Euclidean, None, None, None).is_err());
+    }
+
+    #[test]
+    fn test_hk_threads() {
+        let points = random_points(4_242, 45, 1000.0);
+        let dist_mat = euclid_matrix(&points);
+
+        let config = |threads| HkConfig {
+            threads: Some(threads),
+            ..HkConfig::default()
+        };
+        let single = tsp_hk_with(&dist_mat, &config(1), None, None).unwrap();
+        for threads in [2, 4, 8] {
+            let sol = tsp_hk_with(&dist_mat, &config(threads), None, None).unwrap();
+            assert_eq!(sol.length, single.length);
+            assert_eq!(
+                Solution::calc_length_from_tour(&sol.tour, &dist_mat),
+                sol.length
+            );
+        }
+        assert!(tsp_hk_with(&dist_mat, &config(0), None, None).is_err());
+    }
+
+    #[test]
+    fn test_hk_lower_bound() {
+        let points = random_points(31_337, 300, 1000.0);
+
+        // The first 40 points are small enough to solve exactly
+        let small = euclid_matrix(&points[..40]);
+        let bound = hk_lower_bound(&small).unwrap();
+        let optimal = tsp_hk(&small, None, None).unwrap().length;
+        assert!(bound <= optimal);
+        assert!(f64::from(bound) > 0.97 * f64::from(optimal));
+
+        let dist_mat = euclid_matrix(&points);
+        let bound = hk_lower_bound(&dist_mat).unwrap();
+        let length = tsp_lk(&dist_mat, None, None, None).unwrap().length;
+        assert!(bound <= length);
+        assert!(f64::from(bound) > 0.95 * f64::from(length));
+
+        let tiny = LowerDistanceMatrix::new(2, vec![0, 5, 0]);
+        assert!(hk_lower_bound(&tiny).is_err());
+    }
+
+    #[test]
+    fn test_hk_limits() {
+        let points = random_points(777, 60, 1000.0);
+        let dist_mat = euclid_matrix(&points);
+
+        let depth_first = tsp_hk(&dist_mat, None, None).unwrap();
+        assert_eq!(depth_first.lower_bound, Some(depth_first.length));
+        let best_first = HkConfig {
+            node_selection: NodeSelection::BestFirst,
+            ..HkConfig::default()
+        };
+        let sol = tsp_hk_with(&dist_mat, &best_first, None, None).unwrap();
+        assert_eq!(sol.length, depth_first.length);
+        assert_eq!(sol.lower_bound, Some(sol.length));
+
+        for (node_limit, time_bound) in [(Some(1), None), (None, Some(Duration::ZERO))] {
+            let sol = tsp_hk_with(&dist_mat, &best_first, node_limit, time_bound).unwrap();
+            assert_eq!(
+                Solution::calc_length_from_tour(&sol.tour, &dist_mat),
+                sol.length
+            );
+            assert!(sol.length >= depth_first.length);
+            match node_limit {
+                // The root is bounded before the limit stops the search.
+                Some(_) => assert!((1..=depth_first.length).contains(&sol.lower_bound.unwrap())),
+                None => assert_eq!(sol.lower_bound, None),
+            }
+        }
+
+        // Below the size that gets an LK tour, a limit that stops the search before
+        // its first tour still returns one.
+        for n in 3..8 {
+            let dist_mat = euclid_matrix(&random_points(n as u64, n, 1000.0));
+            let opt = tsp_hk(&dist_mat, None, None).unwrap().length;
+            for (node_limit, time_bound) in [(Some(0), None), (None, Some(Duration::ZERO))] {
+                let sol = tsp_hk_with(&dist_mat, &best_first, node_limit, time_bound).unwrap();
+                let mut nodes = sol.tour.clone();
+                nodes.sort_unstable();
+                assert_eq!(nodes, (0..n as u32).collect::<Vec<_>>());
+                assert_eq!(
+                    Solution::calc_length_from_tour(&sol.tour, &dist_mat),
+                    sol.length
+                );
+                assert!(sol.length >= opt);
+                assert!(sol.lower_bound.is_none_or(|bound| bound <= opt));
+            }
+        }
+    }
+
+    #[test]
+    fn test_time_bound() {
+        // Compared with a full search on the same machine rather than with the clock,
+        // so a loaded machine slows both alike.
+        let points = random_points(12_345, 2000, 10_000.0);
+        let dist_mat = euclid_matrix(&points);
+        let start = Instant::now();
+        let unbounded = tsp_lk(&dist_mat, None, None, None).unwrap();
+        let full = start.elapsed();
+        for bound in [Duration::ZERO, Duration::from_millis(20)] {
+            let start = Instant::now();
+            let bounded = tsp_lk(&dist_mat, None, None, Some(bound)).unwrap();
+            assert!(
+                start.elapsed() < full / 4,
+                "{bound:?} took {:?}",
+                start.elapsed()
+            );
+            let mut visited = bounded.tour.clone();
+            visited.sort_unstable();
+            assert_eq!(visited, (0..2000).collect::<Vec<u32>>());
+            assert_eq!(
+                Solution::calc_length_from_tour(&bounded.tour, &dist_mat),
+                bounded.length
+            );
+            if bound.is_zero() {
+                assert!(unbounded.length <= bounded.length);
+            }
+        }
+
+        let (x, y): (Vec<f64>, Vec<f64>) = points.into_iter().unzip();
+        let bounded = tsp_lk_coords(
+            &x,
+            &y,
+            None,
+            Norm::Euclidean,
+            None,
+            None,
+            Some(Duration::ZERO),
+        )
+        .unwrap();
+        let mut visited = bounded.tour.clone();
+        visited.sort_unstable();
+        assert_eq!(visited, (0..2000).collect::<Vec<u32>>());
+        let unbounded = tsp_lk_coords(&x, &y, None, Norm::Euclidean, None, None, None).unwrap();
+        assert!(unbounded.length <= bounded.length);
+    }
+
+    #[test]
+    fn test_large_coords() {
+        // Candidates and the start tour come from a kd-tree, so a large geometric
+        // instance gets through setup and returns a whole tour under a time bound.
+        let (x, y): (Vec<f64>, Vec<f64>) =
+            random_points(777, 100_000, 1_000_000.0).into_iter().unzip();
+
+        let solution = tsp_lk_coords(
+            &x,
+            &y,
+            None,
+            Norm::Euclidean,
+            None,
+            None,
+            Some(Duration::from_secs(1)),
+        )
+        .unwrap();
+        let mut visited = solution.tour.clone();
+        visited.sort_unstable();
+        assert_eq!(visited, (0..100_000).collect::<Vec<u32>>());
+    }
+
+    #[test]
+    fn test_lk_anytime() {
+        let dist_mat = grid_matrix(10, 100);
+
+        let mut reports = Vec::new();
+        let sol = tsp_lk_anytime(&dist_mat, None, None, None, Duration::ZERO, |len, tour| {
+            assert_eq!(Solution::calc_length_from_tour(tour, &dist_mat), len);
+            reports.push(len);
+            ControlFlow::Continue(())
+        })
+        .unwrap();
+        assert!(reports.windows(2).all(|w| w[1] < w[0]));
+        assert_eq!(reports.last(), Some(&sol.length));
+        assert_eq!(sol, tsp_lk(&dist_mat, None, None, None).unwrap());
+
+        let mut first = None;
+        let sol = tsp_lk_anytime(&dist_mat, None, None, None, Duration::ZERO, |len, _| {
+            first = Some(len);
+            ControlFlow::Break(())
+        })
+        .unwrap();
+        assert_eq!(first, Some(sol.length));
+
+        let caught = panic::catch_unwind(|| {
+            tsp_lk_anytime(&dist_mat, None, None, None, Duration::ZERO, |_, _| {
+                panic!("stop")
+            })
+        });
+        assert!(caught.is_err());
+    }
+
+    #[test]
+    fn test_lk_from() {
+        let dist_mat = grid_matrix(10, 60);
+
+        let identity: Vec<u32> = (0..60).collect();
+        let sol = tsp_lk_from(&dist_mat, &identity, None, None, None).unwrap();
+        assert_eq!(sol.length, 600);
+        let warm = tsp_lk_from(&dist_mat, &sol.tour, Some(1), None, None).unwrap();
+        assert_eq!(warm.length, 600);
+
+        assert!(tsp_lk_from(&dist_mat, &identity[1..], None, None, None).is_err());
+        let mut dup = identity.clone();
+        dup[3] = 4;
+        assert!(tsp_lk_from(&dist_mat, &dup, None, None, None).is_err());
+        dup[3] = 60;
+        assert!(tsp_lk_from(&dist_mat, &dup, None, None, None).is_err());
+    }
+
+    #[test]
+    fn test_path_lk() {
+        // Nodes on a line: the best path between the two ends visits them in order,
+        // while the best tour would pay for the way back.
+        let values = (0..40u32)
+            .flat_map(|i| (0..=i).map(move |j| 10 * (i - j)))
+            .collect();
+        let dist_mat = LowerDistanceMatrix::new(40, values);
+        let path = path_lk(&dist_mat, 0, 39, None, None, None).unwrap();
+        assert_eq!(path.tour, (0..40).collect::<Vec<u32>>());
+        assert_eq!(path.length, 390);
+
+        let path = path_lk(&dist_mat, 39, 0, None, None, None).unwrap();
+        assert_eq!(path.tour, (0..40).rev().collect::<Vec<u32>>());
+
+        // With inner ends the path must double back once.
+        let path = path_lk(&dist_mat, 10, 30, None, None, None).unwrap();
+        assert_eq!((path.tour[0], path.tour[39]), (10, 30));
+        let mut visited = path.tour.clone();
+        visited.sort_unstable();
+        assert_eq!(visited, (0..40).collect::<Vec<u32>>());
+        let legs: u32 = path
+            .tour
+            .windows(2)
+            .map(|w| dist_mat.dist(w[0] as usize, w[1] as usize))
+            .sum();
+        assert_eq!(legs, path.length);
+        assert_eq!(path.length, 100 + 390 + 90);
+
+        let small = LowerDistanceMatrix::new(3, vec![0, 3, 0, 4, 5, 0]);
+        assert_eq!(path_lk(&small, 0, 2, None, None, None).unwrap().length, 8);
+        assert!(path_lk(&dist_mat, 3, 3, None, None, None).is_err());
+        assert!(path_lk(&dist_mat, 3, 40, None, None, None).is_err());
+    }
+
+    #[test]
+    fn test_lk_fixed() {
+        let values = (0..40u32)
+            .flat_map(|i| (0..=i).map(move |j| 10 * (i - j)))
+            .collect();
+        let dist_mat = LowerDistanceMatrix::new(40, values);
+        let fixed = [[5, 30], [30, 12], [20, 10], [0, 39]];
+        let solution = tsp_lk_fixed(&dist_mat, &fixed, None, None, None).unwrap();
+        let mut at = vec![0; 40];
+        for (i, &node) in solution.tour.iter().enumerate() {
+            at[node as usize] = i;
+        }
+        for [a, b] in fixed {
+            let gap = (at[a as usize] + 40 - at[b as usize]) % 40;
+            assert!(gap == 1 || gap == 39, "edge ({a}, {b}) was broken");
+        }
+        assert_eq!(
+            solution.length,
+            Solution::calc_length_from_tour(&solution.tour, &dist_mat)
+        );
+
+        // A fixed tour through every node is the only answer.
+        let ring: Vec<[u32; 2]> = (0..40).map(|i| [i, (i + 7) % 40]).collect();
+        let solution = tsp_lk_fixed(&dist_mat, &ring, None, None, None).unwrap();
+        assert_eq!(
+            solution.length,
+            ring.iter()
+                .map(|&[a, b]| dist_mat.dist(a as usize, b as usize))
+                .sum::<u32>()
+        );
+
+        assert!(tsp_lk_fixed(&dist_mat, &[[1, 2], [1, 3], [1, 4]], None, None, None).is_err());
+        assert!(tsp_lk_fixed(&dist_mat, &[[1, 2], [2, 3], [3, 1]], None, None, None).is_err());
+        assert!(tsp_lk_fixed(&dist_mat, &[[1, 2], [2, 1]], None, None, None).is_err());
+        assert!(tsp_lk_fixed(&dist_mat, &[[1, 40]], None, None, None).is_err());
+        assert!(tsp_lk_fixed(&dist_mat, &[[7, 7]], None, None, None).is_err());
+        let too_many: Vec<[u32; 2]> = (0..41).map(|i| [i % 40, (i + 1) % 40]).collect();
+        assert!(tsp_lk_fixed(&dist_mat, &too_many, None, None, None).is_err());
+    }
+
+    #[test]
+    fn test_lk_config() {
+        let (x, y): (Vec<f64>, Vec<f64>) = (0..20)
+            .map(|i| (f64::from(i % 5) * 10.0, f64::from(i / 5) * 10.0))
+            .unzip();
+        let values = (0..20)
+            .flat_map(|i| (0..=i).map(move |j| (i, j)))
+            .map(|(i, j): (usize, usize)| (x[i] - x[j]).hypot(y[i] - y[j]).round() as u32)
+            .collect();
+        let dist_mat = LowerDistanceMatrix::new(20, values);
+        let starts = [
+            StartTour::Random,
+            StartTour::NearestNeighbor,
+            StartTour::Greedy,
+            StartTour::QBoruvka,
+            StartTour::SpaceFilling,
+        ];
+        let kicks = [
+            KickType::Random,
+            KickType::Geometric,
+            KickType::Close,
+            KickType::Walk,
+        ];
+        for start in starts {
+            for kick in kicks {
+                let config = LkConfig {
+                    start,
+                    kick,
+                    seed: 7,
+                    ..LkConfig::default()
+                };
+                let sol = tsp_lk_with(&dist_mat, &config, None, None, None).unwrap();
+                assert_eq!(sol.length, 200, "{start:?} {kick:?} on the matrix");
+                let sol =
+                    tsp_lk_coords_with(&x, &y, None, Norm::Euclidean, &config, None, None, None)
+                        .unwrap();
+                assert_eq!(sol.length, 200, "{start:?} {kick:?} on the points");
+            }
+        }
+        assert_eq!(
+            tsp_lk_with(&dist_mat, &LkConfig::default(), None, None, None).unwrap(),
+            tsp_lk(&dist_mat, None, None, None).unwrap()
+        );
+
+        // Norms without a kd-tree start from Q-Boruvka instead of the curve. On
+        // 500 random points a different start would end in a different tour.
+        let points = random_points(99, 500, 1000.0);
+        let (x, y): (Vec<f64>, Vec<f64>) = points.iter().copied().unzip();
+        let z: Vec<f64> = random_points(98, 500, 1000.0).iter().map(|p| p.0).collect();
+        let space_filling = LkConfig {
+            start: StartTour::SpaceFilling,
+            seed: 7,
+            ..LkConfig::default()
+        };
+        let q_boruvka = LkConfig {
+            start: StartTour::QBoruvka,
+            ..space_filling
+        };
+        for (norm, z) in [
+            (Norm::Att, None),
+            (Norm::Geographic, None),
+            (Norm::Euclidean, Some(&z[..])),
+        ] {
+            let solve =
+                |config| tsp_lk_coords_with(&x, &y, z, norm, config, Some(1), None, None).unwrap();
+            assert_eq!(solve(&space_filling), solve(&q_boruvka), "{norm:?}");
+        }
+    }
+
+    #[test]
+    fn test_lk_search() {
+        let (x, y): (Vec<f64>, Vec<f64>) = (0..30)
+            .map(|i| (f64::from(i % 6) * 10.0, f64::from(i / 6) * 10.0))
+            .unzip();
+        let custom = LkSearch {
+            max_depth: 6,
+            kick_max_depth: 0,
+            breadth: [6, 1, 0, 9, 0, 0, 0, 0],
+            mak_morton: false,
+            less_or_equal: false,
+        };
+        for search in [LkSearch::DEFAULT, LkSearch::FAST, LkSearch::DEEP, custom] {
+            let config = LkConfig {
+                search,
+                ..LkConfig::default()
+            };
+            let sol = tsp_lk_coords_with(&x, &y, None, Norm::Euclidean, &config, None, None, None)
+                .unwrap();
+            assert_eq!(sol.length, 300, "{search:?}");
+        }
+
+        for search in [
+            LkSearch {
+                max_depth: 0,
+                ..LkSearch::DEFAULT
+            },
+            LkSearch {
+                kick_max_depth: 1001,
+                ..LkSearch::DEFAULT
+            },
+            LkSearch {
+                breadth: [4, 13, 0, 0, 0, 0, 0, 0],
+                ..LkSearch::DEFAULT
+            },
+        ] {
+            let config = LkConfig {
+                search,
+                ..LkConfig::default()
+            };
+            assert!(matches!(
+                tsp_lk_coords_with(&x, &y, None, Norm::Euclidean, &config, None, None, None),
+                Err(SolverError::InvalidInput(_))
+            ));
+        }
+    }
+
+    #[test]
+    fn test_lk_stats() {
+        let (x, y): (Vec<f64>, Vec<f64>) = (0..400)
+            .map(|i| (f64::from(i * 7919 % 1000), f64::from(i * 104_729 % 997)))
+            .unzip();
+        let config = LkConfig {
+            stats: true,
+            ..LkConfig::default()
+        };
+        let sol = tsp_lk_coords_with(
+            &x,
+            &y,
+            None,
+            Norm::Euclidean,
+            &config,
+            Some(100),
+            None,
+            None,
+        )
+        .unwrap();
+        let stats = sol.stats.unwrap();
+        assert!(stats.kicks >= 100);
+        assert!(stats.improving_kicks <= stats.kicks);
+        assert!(stats.last_improvement <= stats.kicks);
+        assert!(stats.kicks - stats.last_improvement < 100);
+        assert!(stats.flips > 0);
+        assert!(stats.dist_misses > 0 && stats.dist_misses < stats.dist_lookups);
+        assert!(stats.cache_hit_rate() > 0.0 && stats.cache_hit_rate() < 1.0);
+        assert!(stats.kick_loop > Duration::ZERO);
+
+        let sol = tsp_lk_coords(&x, &y, None, Norm::Euclidean, Some(100), None, None).unwrap();
+        assert!(sol.stats.is_none());
+    }
+
+    #[test]
+    fn test_lk_variants_with() {
+        // The warm-start, path and fixed-edge solvers take their settings from an
+        // LkConfig too, so they report stats and reject a bad search.
+        let dist_mat = grid_matrix(8, 40);
+        let config = LkConfig {
+            kick: KickType::Close,
+            search: LkSearch::FAST,
+            stats: true,
+            ..LkConfig::default()
+        };
+        let identity: Vec<u32> = (0..40).collect();
+        for sol in [
+            tsp_lk_from_with(&dist_mat, &identity, &config, None, None, None),
+            path_lk_with(&dist_mat, 0, 39, &config, None, None, None),
+            tsp_lk_fixed_with(&dist_mat, &[[0, 39]], &config, None, None, None),
+        ] {
+            let stats = sol.unwrap().stats.unwrap();
+            assert!(stats.kicks > 0);
+            assert!(stats.flips > 0);
+        }
+
+        let bad = LkConfig {
+            search: LkSearch {
+                max_depth: 0,
+                ..LkSearch::FAST
+            },
+            ..config
+        };
+        assert!(matches!(
+            tsp_lk_from_with(&dist_mat, &identity, &bad, None, None, None),
+            Err(SolverError::InvalidInput(_))
+        ));
+        assert!(matches!(
+            path_lk_with(&dist_mat, 0, 39, &bad, None, None, None),
+            Err(SolverError::InvalidInput(_))
+        ));
+        assert!(matches!(
+            tsp_lk_fixed_with(&dist_mat, &[[0, 39]], &bad, None, None, None),
+            Err(SolverError::InvalidInput(_))
+        ));
+    }
+
+    #[test]
+    fn test_lk_alpha() {
+        // `k` tight clusters of `n / k` points on a coarse grid, `cols` clusters wide.
+        let clusters = |n: u32, k: u32, cols: u32| {
+            let points: Vec<(f64, f64)> = (0..n)
+                .map(|i| {
+                    let c = i % k;
+                    let (x, y) = (c % cols * 1000 + i * 37 % 50, c / cols * 1000 + i * 53 % 50);
+                    (f64::from(x), f64::from(y))
+                })
+                .collect();
+            euclid_matrix(&points)
+        };
+
+        // The 8 nearest neighbours of a point all lie in its own cluster of 25, so
+        // only the start tour links the clusters; the alpha-nearest include the
+        // links of the minimum 1-tree, and LK can improve them.
+        let dist_mat = clusters(300, 12, 4);
+        let solution = tsp_lk_alpha(&dist_mat, Some(300), None, None).unwrap();
+        let mut seen = vec![false; 300];
+        for &node in &solution.tour {
+            assert!(!std::mem::replace(&mut seen[node as usize], true));
+        }
+        assert_eq!(
+            solution.length,
+            Solution::calc_length_from_tour(&solution.tour, &dist_mat)
+        );
+        let nearest = tsp_lk(&dist_mat, Some(300), None, None).unwrap();
+        assert!(solution.length < nearest.length);
+
+        // Six clusters of 6 are small enough for Held-Karp to give the optimum.
+        let dist_mat = clusters(36, 6, 3);
+        let optimum = tsp_hk(&dist_mat, None, None).unwrap().length;
+        assert_eq!(
+            tsp_lk_alpha(&dist_mat, Some(10), None, None)
+                .unwrap()
+                .length,
+            optimum
+        );
     }
 }
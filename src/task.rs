@@ -0,0 +1,196 @@
+//! Cancellation and asynchronous solves.
+//!
+//! No runtime is assumed: [`tsp_lk_async`] runs the solve on its own thread and the
+//! returned [`LkTask`] can be awaited from any executor.
+use super::errors::SolverError;
+use super::solver::tsp_lk_cancellable;
+use super::{LowerDistanceMatrix, Solution};
+use std::ffi::c_int;
+use std::future::Future;
+use std::pin::Pin;
+use std::sync::atomic::{AtomicI32, Ordering};
+use std::sync::{Arc, Mutex};
+use std::task::{Context, Poll, Waker};
+use std::thread;
+use std::time::Duration;
+
+/// A flag that asks running solves to stop with the best tour found so far.
+///
+/// Clones share the flag, so one clone can be handed to the solver and another kept
+/// by whoever decides to cancel.
+#[derive(Clone, Debug, Default)]
+pub struct CancelToken {
+    flag: Arc<AtomicI32>,
+}
+
+impl CancelToken {
+    #[must_use]
+    pub fn new() -> Self {
+        Self::default()
+    }
+
+    pub fn cancel(&self) {
+        self.flag.store(1, Ordering::Relaxed);
+    }
+
+    #[must_use]
+    pub fn is_cancelled(&self) -> bool {
+        self.flag.load(Ordering::Relaxed) != 0
+    }
+
+    /// Concorde polls the flag through this pointer; it stays valid while `self` lives.
+    pub(crate) fn as_ptr(&self) -> *const c_int {
+        self.flag.as_ptr()
+    }
+}
+
+/// Runs [`crate::solver::tsp_lk`] on a background thread.
+///
+/// Awaiting the returned [`LkTask`] yields the solution. Dropping it cancels the solve,
+/// which then stops within a few Lin-Kernighan steps and releases the thread and its
+/// buffers.
+#[must_use = "dropping the task cancels the solve"]
+pub fn tsp_lk_async(
+    dist_mat: impl Into<Arc<LowerDistanceMatrix>>,
+    stall: Option<i32>,
+    length_bound: Option<f64>,
+    time_bound: Option<Duration>,
+) -> LkTask {
+    let dist_mat = dist_mat.into();
+    let cancel = CancelToken::new();
+    let shared = Arc::new(Mutex::new(Shared::default()));
+
+    let (token, state) = (cancel.clone(), Arc::clone(&shared));
+    thread::spawn(move || {
+        let result = tsp_lk_cancellable(&dist_mat, stall, length_bound, time_bound, &token);
+        let mut state = state.lock().unwrap_or_else(|e| e.into_inner());
+        state.result = Some(result);
+        if let Some(waker) = state.waker.take() {
+            waker.wake();
+        }
+    });
+
+    LkTask { shared, cancel }
+}
+
+#[derive(Default)]
+struct Shared {
+    result: Option<Result<Solution, SolverError>>,
+    waker: Option<Waker>,
+}
+
+/// A Lin-Kernighan solve running on a background thread, see [`tsp_lk_async`].
+pub struct LkTask {
+    shared: Arc<Mutex<Shared>>,
+    cancel: CancelToken,
+}
+
+impl LkTask {
+    /// Stops the search early; the task then resolves to the best tour found so far.
+    pub fn cancel(&self) {
+        self.cancel.cancel();
+    }
+}
+
+impl Future for LkTask {
+    type Output = Result<Solution, SolverError>;
+
+    fn poll(self: Pin<&mut Self>, cx: &mut Context<'_>) -> Poll<Self::Output> {
+        let mut state = self.shared.lock().unwrap_or_else(|e| e.into_inner());
+        match state.result.take() {
+            Some(result) => Poll::Ready(result),
+            None => {
+                state.waker = Some(cx.waker().clone());
+                Poll::Pending
+            }
+        }
+    }
+}
+
+impl Drop for LkTask {
+    fn drop(&mut self) {
+        self.cancel.cancel();
+    }
+}
+
+#[cfg(test)]
+mod tests {
+    use super::*;
+    use crate::solver::tsp_lk;
+    use crate::testing::{euclid_matrix, grid_matrix, random_points};
+    use std::sync::atomic::AtomicBool;
+    use std::task::Wake;
+    use std::time::Instant;
+
+    struct ThreadWaker(thread::Thread, AtomicBool);
+
+    impl Wake for ThreadWaker {
+        fn wake(self: Arc<Self>) {
+            self.1.store(true, Ordering::Release);
+            self.0.unpark();
+        }
+    }
+
+    fn block_on<F: Future>(fut: F) -> F::Output {
+        let waker = Arc::new(ThreadWaker(thread::current(), AtomicBool::new(false)));
+        let cx_waker = Waker::from(Arc::clone(&waker));
+        let mut cx = Context::from_waker(&cx_waker);
+        let mut fut = std::pin::pin!(fut);
+        loop {
+            if let Poll::Ready(out) = fut.as_mut().poll(&mut cx) {
+                return out;
+            }
+            while !waker.1.swap(false, Ordering::Acquire) {
+                thread::park();
+            }
+        }
+    }
+
+    #[test]
+    fn test_async_matches_sync() {
+        let dist_mat = grid_matrix(6, 36);
+        let expected = tsp_lk(&dist_mat, None, None, None).unwrap();
+        let sol = block_on(tsp_lk_async(dist_mat, None, None, None)).unwrap();
+        assert_eq!(sol, expected);
+    }
+
+    #[test]
+    fn test_cancel_latency() {
+        // A full solve of this instance takes seconds, far past the generous limit
+        // below, so a thread released within it was stopped by the cancel.
+        let dist_mat = Arc::new(euclid_matrix(&random_points(4_321, 5000, 10_000.0)));
+        let limit = Duration::from_secs(5);
+
+        // Cancelled up front, the solve skips setup and the search just as an
+        // exhausted time bound does, whatever the machine's load.
+        let cancel = CancelToken::new();
+        cancel.cancel();
+        let sol = tsp_lk_cancellable(&dist_mat, None, None, None, &cancel).unwrap();
+        assert_eq!(
+            sol,
+            tsp_lk(&dist_mat, None, None, Some(Duration::ZERO)).unwrap()
+        );
+        assert_eq!(
+            Solution::calc_length_from_tour(&sol.tour, &dist_mat),
+            sol.length
+        );
+
+        let task = tsp_lk_async(Arc::clone(&dist_mat), None, None, None);
+        task.cancel();
+        assert!(block_on(task).is_ok());
+
+        // The solve thread holds the other reference until it returns.
+        let task = tsp_lk_async(Arc::clone(&dist_mat), None, None, None);
+        thread::sleep(Duration::from_millis(200));
+        assert_eq!(Arc::strong_count(&dist_mat), 2);
+        let start = Instant::now();
+        drop(task);
+        while Arc::strong_count(&dist_mat) > 1 {
+            assert!(
+                start.elapsed() < limit,
+                "the dropped solve is still running"
+            );
+            thread::sleep(Duration::from_millis(1));
+        }
+    }
+}
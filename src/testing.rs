@@ -0,0 +1,52 @@
+//! Instances shared by the unit tests.
+
+use crate::LowerDistanceMatrix;
+
+/// `n` nodes on a grid `cols` wide with spacing 10, under the Manhattan norm.
+pub(crate) fn grid_matrix(cols: u32, n: u32) -> LowerDistanceMatrix {
+    let nodes: Vec<(u32, u32)> = (0..n).map(|i| (i % cols * 10, i / cols * 10)).collect();
+    let values = (0..nodes.len())
+        .flat_map(|i| (0..=i).map(move |j| (i, j)))
+        .map(|(i, j)| nodes[i].0.abs_diff(nodes[j].0) + nodes[i].1.abs_diff(nodes[j].1))
+        .collect();
+    LowerDistanceMatrix::new(n, values)
+}
+
+/// `n` points drawn uniformly from `[0, scale)²` by a fixed LCG seeded with `seed`.
+pub(crate) fn random_points(seed: u64, n: usize, scale: f64) -> Vec<(f64, f64)> {
+    let mut seed = seed;
+    let mut next = || {
+        seed = seed.wrapping_mul(6_364_136_223_846_793_005).wrapping_add(1);
+        (seed >> 33) as f64 / f64::from(1u32 << 31) * scale
+    };
+    (0..n).map(|_| (next(), next())).collect()
+}
+
+/// Rounded Euclidean distances between `points`.
+pub(crate) fn euclid_matrix(points: &[(f64, f64)]) -> LowerDistanceMatrix {
+    let values = points
+        .iter()
+        .enumerate()
+        .flat_map(|(i, a)| points[..=i].iter().map(move |b| (a, b)))
+        .map(|(a, b)| ((a.0 - b.0).hypot(a.1 - b.1) + 0.5) as u32)
+        .collect();
+    LowerDistanceMatrix::new(points.len() as u32, values)
+}
+
+/// Distances drawn uniformly from `1..=max` by a fixed LCG seeded with `seed`; a small
+/// `max` makes most of them ties.
+pub(crate) fn random_matrix(seed: u64, n: u32, max: u32) -> LowerDistanceMatrix {
+    let mut seed = seed;
+    let mut values = Vec::with_capacity(n as usize * (n as usize + 1) / 2);
+    for i in 0..n {
+        for j in 0..=i {
+            seed = seed.wrapping_mul(6_364_136_223_846_793_005).wrapping_add(1);
+            values.push(if j == i {
+                0
+            } else {
+                (seed >> 33) as u32 % max + 1
+            });
+        }
+    }
+    LowerDistanceMatrix::new(n, values)
+}
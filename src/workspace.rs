@@ -0,0 +1,342 @@
+//! Reusable buffers for high-rate repeated solves.
+use super::errors::SolverError;
+use super::solver::{call_lk, check_lk_matrix, LkParams};
+use super::LowerDistanceMatrix;
+use std::ffi::{c_double, c_int, c_uint, c_void};
+use std::ptr::NonNull;
+use std::time::Duration;
+
+/// Buffers for the Lin-Kernighan heuristic that are kept between solves.
+///
+/// Concorde's per-solve arrays (candidate graph, distance cache, flipper, flip
+/// stacks, active queue and their pools) grow to the largest instance seen and are
+/// reused afterwards, so solving many instances of similar size does not go back
+/// to the allocator for them.
+///
+/// # Examples
+/// ```
+/// use concorde_rs::{LkWorkspace, LowerDistanceMatrix};
+///
+/// let dist_mat =
+///     LowerDistanceMatrix::new(5, vec![0, 3, 0, 4, 4, 0, 2, 6, 5, 0, 7, 3, 8, 6, 0]);
+/// let mut ws = LkWorkspace::new();
+/// let mut tour = [0u32; 5];
+/// for _ in 0..3 {
+///     assert_eq!(ws.tsp_lk(&dist_mat, None, None, None, &mut tour).unwrap(), 19);
+/// }
+/// ```
+#[derive(Debug)]
+pub struct LkWorkspace {
+    raw: NonNull<c_void>,
+}
+
+// The workspace is plain heap memory owned by this handle.
+unsafe impl Send for LkWorkspace {}
+
+impl LkWorkspace {
+    /// # Panics
+    ///
+    /// Panics if Concorde cannot allocate the (empty) workspace.
+    #[must_use]
+    pub fn new() -> Self {
+        let mut raw = std::ptr::null_mut();
+        let rval = unsafe { CCtsp_lkworkspace_alloc(&mut raw) };
+        assert!(rval == 0, "out of memory allocating an LkWorkspace");
+        Self {
+            raw: NonNull::new(raw).expect("CCtsp_lkworkspace_alloc returned NULL"),
+        }
+    }
+
+    /// Lin-Kernighan heuristic, see [`crate::solver::tsp_lk`].
+    ///
+    /// The tour is written into `tour`, which must hold exactly `dist_mat.num_nodes`
+    /// entries, and its length is returned.
+    /// # Errors
+    ///
+    /// Returns `SolverError::InvalidInput` if `tour` or `dist_mat.values` have the
+    /// wrong size, and `SolverError::SolverFailed` if Concorde fails to solve the problem.
+    pub fn tsp_lk(
+        &mut self,
+        dist_mat: &LowerDistanceMatrix,
+        stall: Option<i32>,
+        length_bound: Option<f64>,
+        time_bound: Option<Duration>,
+        tour: &mut [u32],
+    ) -> Result<u32, SolverError> {
+        check_lk_matrix(dist_mat)?;
+        if tour.len() != dist_mat.num_nodes as usize {
+            return Err(SolverError::InvalidInput(format!(
+                "tour holds {} nodes instead of {}",
+                tour.len(),
+                dist_mat.num_nodes
+            )));
+        }
+        call_lk(
+            stall,
+            length_bound,
+            "Lin-Kernighan",
+            |stall, length_bound| unsafe {
+                CCtsp_lk_ws(
+                    self.raw.as_ptr(),
+                    dist_mat.values.as_ptr(),
+                    tour.as_mut_ptr(),
+                    dist_mat.num_nodes,
+                    stall,
+                    length_bound,
+                    &LkParams::with_time_bound(time_bound),
+                )
+            },
+        )
+    }
+}
+
+impl LkWorkspace {
+    /// One chain of [`crate::solver::tsp_lk_multistart`] on a shared candidate set.
+    pub(crate) fn lk_chain(
+        &mut self,
+        dist_mat: &LowerDistanceMatrix,
+        cands: &Candidates,
+        stall: Option<i32>,
+        length_bound: Option<f64>,
+        params: &LkParams,
+        tour: &mut [u32],
+    ) -> Result<u32, SolverError> {
+        debug_assert_eq!(tour.len(), dist_mat.num_nodes as usize);
+        call_lk(
+            stall,
+            length_bound,
+            "Lin-Kernighan",
+            |stall, length_bound| unsafe {
+                CCtsp_lk_chain(
+                    self.raw.as_ptr(),
+                    dist_mat.values.as_ptr(),
+                    tour.as_mut_ptr(),
+                    dist_mat.num_nodes,
+                    cands.ecount,
+                    cands.elist.as_ptr(),
+                    stall,
+                    length_bound,
+                    params,
+                )
+            },
+        )
+    }
+}
+
+impl Default for LkWorkspace {
+    fn default() -> Self {
+        Self::new()
+    }
+}
+
+impl Drop for LkWorkspace {
+    fn drop(&mut self) {
+        unsafe { CCtsp_lkworkspace_free(self.raw.as_ptr()) };
+    }
+}
+
+/// The Lin-Kernighan candidate edges of one instance, in Concorde's `end1 end2` format.
+pub(crate) struct Candidates {
+    ecount: c_int,
+    elist: NonNull<c_int>,
+}
+
+// Concorde only reads the list once it is built.
+unsafe impl Send for Candidates {}
+unsafe impl Sync for Candidates {}
+
+impl Candidates {
+    pub(crate) fn new(dist_mat: &LowerDistanceMatrix) -> Result<Self, SolverError> {
+        let mut ecount = 0;
+        let mut elist = std::ptr::null_mut();
+        let rval = unsafe {
+            CCtsp_lk_candidates(
+                dist_mat.values.as_ptr(),
+                dist_mat.num_nodes,
+                &mut ecount,
+                &mut elist,
+            )
+        };
+        match NonNull::new(elist) {
+            Some(elist) if rval == 0 => Ok(Self { ecount, elist }),
+            _ => {
+                unsafe { CCtsp_lk_free_candidates(elist) };
+                Err(SolverError::SolverFailed(String::from(
+                    "Lin-Kernighan candidate edges",
+                )))
+            }
+        }
+    }
+}
+
+impl Drop for Candidates {
+    fn drop(&mut self) {
+        unsafe { CCtsp_lk_free_candidates(self.elist.as_ptr()) };
+    }
+}
+
+extern "C" {
+    fn CCtsp_lk_candidates(
+        dist_mat: *const c_uint,
+        ncount: c_uint,
+        ecount: *mut c_int,
+        elist: *mut *mut c_int,
+    ) -> c_int;
+    fn CCtsp_lk_free_candidates(elist: *mut c_int);
+    #[cfg(test)]
+    fn CCtsp_junk_k_nearest(
+        dist_mat: *const c_uint,
+        ncount: c_uint,
+        num: c_int,
+        wcoord: *const c_double,
+        nthreads: c_int,
+        ecount: *mut c_int,
+        elist: *mut *mut c_int,
+    ) -> c_int;
+    fn CCtsp_lk_chain(
+        ws: *mut c_void,
+        dist_mat: *const c_uint,
+        tour: *mut c_uint,
+        ncount: c_uint,
+        ecount: c_int,
+        elist: *const c_int,
+        stall_count: c_int,
+        length_bound: c_double,
+        cfg: *const LkParams,
+    ) -> i32;
+    fn CCtsp_lkworkspace_alloc(ws: *mut *mut c_void) -> c_int;
+    fn CCtsp_lkworkspace_free(ws: *mut c_void);
+    fn CCtsp_lk_ws(
+        ws: *mut c_void,
+        dist_mat: *const c_uint,
+        tour: *mut c_uint,
+        ncount: c_uint,
+        stall_count: c_int,
+        length_bound: c_double,
+        cfg: *const LkParams,
+    ) -> i32;
+}
+
+#[cfg(test)]
+mod tests {
+    use super::*;
+    use crate::solver::tsp_lk;
+    use crate::testing::{grid_matrix, random_matrix};
+    use crate::Solution;
+
+    /// The junk-norm k-nearest edges on `nthreads` threads, in the order Concorde lists them.
+    fn junk_k_nearest(
+        dist_mat: &LowerDistanceMatrix,
+        num: c_int,
+        weights: Option<&[f64]>,
+        nthreads: c_int,
+    ) -> Vec<(c_int, c_int)> {
+        let mut ecount = 0;
+        let mut elist = std::ptr::null_mut();
+        let rval = unsafe {
+            CCtsp_junk_k_nearest(
+                dist_mat.values.as_ptr(),
+                dist_mat.num_nodes,
+                num,
+                weights.map_or(std::ptr::null(), <[f64]>::as_ptr),
+                nthreads,
+                &mut ecount,
+                &mut elist,
+            )
+        };
+        assert_eq!(rval, 0);
+        let edges = unsafe { std::slice::from_raw_parts(elist, 2 * ecount as usize) }
+            .chunks(2)
+            .map(|e| (e[0], e[1]))
+            .collect();
+        unsafe { CCtsp_lk_free_candidates(elist) };
+        edges
+    }
+
+    /// The same edges by brute force, sorted: node `n` lists the `num` nodes `j` with the
+    /// least `key(n, j)`, and each edge is kept once, from the smaller end if both list it.
+    fn brute_k_nearest(
+        ncount: usize,
+        num: usize,
+        key: impl Fn(usize, usize) -> (u64, usize),
+    ) -> Vec<(c_int, c_int)> {
+        let lists: Vec<Vec<usize>> = (0..ncount)
+            .map(|n| {
+                let mut others: Vec<usize> = (0..ncount).filter(|&j| j != n).collect();
+                others.select_nth_unstable_by_key(num, |&j| key(n, j));
+                others.truncate(num);
+                others
+            })
+            .collect();
+        let mut edges = Vec::new();
+        for (n, list) in lists.iter().enumerate() {
+            for &j in list {
+                if j > n || !lists[j].contains(&n) {
+                    edges.push((n as c_int, j as c_int));
+                }
+            }
+        }
+        edges.sort_unstable();
+        edges
+    }
+
+    #[test]
+    fn test_junk_k_nearest() {
+        // Node weights send the matrix through the per-node scans; with distances in
+        // 1..=4 and weights in 0..=2 nearly every list is decided by ties, which the
+        // scan breaks in favour of the node it reached first: n-1 down to 0, then up.
+        let dist_mat = random_matrix(31, 300, 4);
+        let weights: Vec<f64> = (0..300).map(|i| f64::from(i % 3)).collect();
+        let expected = brute_k_nearest(300, 8, |n, j| {
+            let len = u64::from(dist_mat.dist(n, j)) + (n % 3 + j % 3) as u64;
+            (len, if j < n { n - j } else { j })
+        });
+        let edges = junk_k_nearest(&dist_mat, 8, Some(&weights), 1);
+        let mut sorted = edges.clone();
+        sorted.sort_unstable();
+        assert_eq!(sorted, expected);
+        for nthreads in [0, 2, 3, 7, 64] {
+            assert_eq!(
+                junk_k_nearest(&dist_mat, 8, Some(&weights), nthreads),
+                edges
+            );
+        }
+    }
+
+    #[test]
+    fn test_matrix_k_nearest() {
+        // Without weights a matrix goes through the tiled kernel, one worker per range
+        // of 2048-column tiles; three tiles give up to three workers whose top lists
+        // are merged, and ties must still go to the smaller end.
+        let dist_mat = random_matrix(47, 4500, 4);
+        let expected = brute_k_nearest(4500, 8, |n, j| (u64::from(dist_mat.dist(n, j)), j));
+        let edges = junk_k_nearest(&dist_mat, 8, None, 1);
+        let mut sorted = edges.clone();
+        sorted.sort_unstable();
+        assert_eq!(sorted, expected);
+        for nthreads in [2, 3, 8] {
+            assert_eq!(junk_k_nearest(&dist_mat, 8, None, nthreads), edges);
+        }
+    }
+
+    #[test]
+    fn test_reuse_across_sizes() {
+        let small = LowerDistanceMatrix::new(5, vec![0, 3, 0, 4, 4, 0, 2, 6, 5, 0, 7, 3, 8, 6, 0]);
+        let large = grid_matrix(8, 40);
+
+        let mut ws = LkWorkspace::new();
+        let mut tour = [0u32; 40];
+        for dist_mat in [&small, &large, &small, &large] {
+            let n = dist_mat.num_nodes as usize;
+            let length = ws
+                .tsp_lk(dist_mat, None, None, None, &mut tour[..n])
+                .unwrap();
+            assert_eq!(length, tsp_lk(dist_mat, None, None, None).unwrap().length);
+            assert_eq!(
+                Solution::calc_length_from_tour(&tour[..n], dist_mat),
+                length
+            );
+        }
+        assert!(ws.tsp_lk(&large, None, None, None, &mut tour[..5]).is_err());
+    }
+}